@@ -0,0 +1,2150 @@
+#include "Benchmark.h"
+#include "CommandList.h"
+#include "DrawList.h"
+#include "EnvironmentMap.h"
+#include "FrameStats.h"
+#include "FrameStatsHud.h"
+#include "HeightReadback.h"
+#include "JobSystem.h"
+#include "Ocean.h"
+#include "PipelineStatistics.h"
+#include "PlanarReflections.h"
+#include "SceneGraph.h"
+#include "ShaderVariants.h"
+#include "RenderFormats.h"
+#include "ScreenSpaceReflections.h"
+#include "Terrain.h"
+#include "ToneMapper.h"
+#include "UniformRing.h"
+#include "WaterNormals.h"
+#include "WaterSim.h"
+
+#include <learnopengl/shader_m.h>
+
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <thread>
+
+// report
+// ------
+void BenchmarkReport::add(const std::string& section, const std::string& metric, double value)
+{
+    entries.push_back({ section, metric, value });
+}
+
+void BenchmarkReport::print(std::ostream& out) const
+{
+    std::string section;
+    for (const Entry& e : entries)
+    {
+        if (e.section != section)
+        {
+            section = e.section;
+            out << "[" << section << "]" << std::endl;
+        }
+        out << "  " << std::left << std::setw(40) << e.metric << " " << e.value << std::endl;
+    }
+}
+
+bool BenchmarkReport::writeJson(const std::string& path) const
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        std::cout << "ERROR::BENCHMARK:: could not write report to " << path << std::endl;
+        return false;
+    }
+    out << std::setprecision(9);
+    out << "{\n  \"benchmark\": \"Water\",\n  \"sections\": {";
+    std::string section;
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        const Entry& e = entries[i];
+        if (i == 0 || e.section != section)
+        {
+            out << (i == 0 ? "\n" : "\n    },\n") << "    \"" << e.section << "\": {\n";
+            section = e.section;
+        }
+        else
+            out << ",\n";
+        out << "      \"" << e.metric << "\": " << e.value;
+    }
+    out << (entries.empty() ? "}\n}\n" : "\n    }\n  }\n}\n");
+    return true;
+}
+
+// only as much JSON as writeJson writes: the objects under "sections" are the sections, the
+// numbers in them the metrics
+bool BenchmarkReport::readJson(const std::string& path)
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        std::cout << "ERROR::BENCHMARK:: could not read report " << path << std::endl;
+        return false;
+    }
+    std::stringstream text;
+    text << in.rdbuf();
+    std::string json = text.str();
+
+    entries.clear();
+    int depth = 0;
+    std::string key, section;
+    for (size_t i = 0; i < json.size(); i++)
+    {
+        char c = json[i];
+        if (c == '{')
+        {
+            if (depth == 2)
+                section = key;
+            depth++;
+        }
+        else if (c == '}')
+            depth--;
+        else if (c == '"')
+        {
+            size_t end = json.find('"', i + 1);
+            if (end == std::string::npos)
+                break;
+            key = json.substr(i + 1, end - i - 1);
+            i = end;
+        }
+        else if (c == ':' && depth == 3)
+        {
+            const char* start = json.c_str() + i + 1;
+            char* end = nullptr;
+            double value = std::strtod(start, &end);
+            if (end == start)
+                break;
+            entries.push_back({ section, key, value });
+            i += end - start;
+        }
+    }
+    if (depth != 0)
+    {
+        std::cout << "ERROR::BENCHMARK:: report " << path << " is not a benchmark report" << std::endl;
+        entries.clear();
+        return false;
+    }
+    return true;
+}
+
+// water simulation: cell updates per second for both backends
+// -----------------------------------------------------------
+static double timeSimSteps(WaterSim& sim, int minSteps, double minSeconds, int& stepsTaken)
+{
+    // start from a disturbed surface so the solver does real work
+    sim.reset();
+    sim.addDisturbance(sim.origin() + glm::vec2(sim.extent() * 0.5f), sim.extent() * 0.1f, 0.2f);
+    for (int i = 0; i < 4; i++)
+        sim.step();
+    glFinish();
+
+    stepsTaken = 0;
+    double start = glfwGetTime(), elapsed = 0.0;
+    while (stepsTaken < minSteps || elapsed < minSeconds)
+    {
+        sim.step();
+        stepsTaken++;
+        if (sim.backend() == WaterSimBackend::GPU && stepsTaken % 16 != 0)
+            continue;
+        glFinish();
+        elapsed = glfwGetTime() - start;
+    }
+    glFinish();
+    return glfwGetTime() - start;
+}
+
+void benchmarkWaterSim(BenchmarkReport& report)
+{
+    const int sizes[] = { 256, 512, 1024, 2048 };
+    const WaterSimBackend backends[] = { WaterSimBackend::CPU, WaterSimBackend::GPU };
+    JobSystem jobs(std::max(1u, std::thread::hardware_concurrency()));
+    for (WaterSimBackend backend : backends)
+    {
+        for (int size : sizes)
+        {
+            WaterSim sim(size, glm::vec2(-3.5f), 7.0f, backend, &jobs);
+            if (sim.backend() != backend)
+                break;
+            int steps;
+            double seconds = timeSimSteps(sim, 32, 0.5, steps);
+            std::string name = std::string(backend == WaterSimBackend::CPU ? "cpu_" : "gpu_") + std::to_string(size);
+            report.add("water_sim", name + "_cell_updates_per_sec", static_cast<double>(size) * size * steps / seconds);
+            report.add("water_sim", name + "_ms_per_step", 1000.0 * seconds / steps);
+            if (backend == WaterSimBackend::CPU && size == sizes[0])
+                report.add("water_sim", "cpu_threads", sim.threadCount());
+        }
+    }
+}
+
+// heightfield readback: time the CPU spends blocked per frame, synchronous vs. PBO ring
+// ------------------------------------------------------------------------------------
+void benchmarkHeightReadback(BenchmarkReport& report)
+{
+    const int frames = 240;
+    const int sizes[] = { 256, 1024 };
+    for (int size : sizes)
+    {
+        WaterSim sim(size, glm::vec2(-3.5f), 7.0f, GLAD_GL_VERSION_4_3 ? WaterSimBackend::GPU : WaterSimBackend::CPU);
+        HeightReadback readback(size, size);
+        std::string name = std::to_string(size);
+
+        double syncStall = 0.0;
+        for (int frame = 0; frame < frames; frame++)
+        {
+            sim.update(sim.FixedTimestep);
+            double start = glfwGetTime();
+            readback.readSynchronous(sim.heightTexture(), frame, start);
+            syncStall += glfwGetTime() - start;
+            glFlush();
+        }
+        glFinish();
+
+        double asyncStall = 0.0;
+        long long latencySum = 0, arrivals = 0;
+        for (int frame = 0; frame < frames; frame++)
+        {
+            sim.update(sim.FixedTimestep);
+            double start = glfwGetTime();
+            if (readback.poll(frame))
+            {
+                latencySum += readback.latencyFrames();
+                arrivals++;
+            }
+            readback.request(sim.heightTexture(), frame, start);
+            asyncStall += glfwGetTime() - start;
+            // stands in for the buffer swap that ends a real frame
+            glFlush();
+        }
+        glFinish();
+
+        report.add("height_readback", name + "_sync_stall_ms_per_frame", 1000.0 * syncStall / frames);
+        report.add("height_readback", name + "_async_stall_ms_per_frame", 1000.0 * asyncStall / frames);
+        report.add("height_readback", name + "_async_latency_frames", arrivals ? static_cast<double>(latencySum) / arrivals : 0.0);
+        report.add("height_readback", name + "_async_dropped_requests", readback.droppedRequests());
+    }
+}
+
+// job system: CPU time to cull and build the three pass draw lists over a large tiled
+// surface, at 1 to 16 worker threads
+// ------------------------------------------------------------------------------------
+void benchmarkJobSystem(BenchmarkReport& report)
+{
+    const int tiles = 256;
+    const int frames = 100;
+    SceneState scene;
+    scene.instances.push_back({ 0, glm::dmat4(1.0), { glm::dvec3(0.0), 1.0f } });
+    for (int i = 0; i < tiles; i++)
+    {
+        for (int j = 0; j < tiles; j++)
+        {
+            glm::dmat4 model = glm::dmat4(1.0);
+            model = glm::translate(model, glm::dvec3(i - tiles / 2, 0.0, j - tiles / 2));
+            model = glm::rotate(model, glm::radians(90.0), glm::dvec3(1, 0, 0));
+            scene.waterTransforms.push_back(model);
+            scene.waterBounds.push_back(transformBounds(model, { glm::dvec3(0.0), 0.7072f }));
+        }
+    }
+    CameraState camera;
+    camera.Position = glm::dvec3(0.0, 2.0, 0.0);
+    camera.Pitch = -20.0f;
+    const ReflectionSchedule reflections = ReflectionSchedule::single(0.0);
+
+    report.add("job_system", "water_tiles", static_cast<double>(scene.waterTransforms.size()));
+    const unsigned int workerCounts[] = { 1, 2, 4, 8, 16 };
+    for (unsigned int workers : workerCounts)
+    {
+        JobSystem jobs(workers);
+        FrameDrawLists lists;
+        buildFrameDrawLists(jobs, scene, camera, reflections, 800.0f / 600.0f, lists);
+
+        double start = glfwGetTime();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            // turn the camera so the visible set changes from frame to frame
+            camera.Yaw = -90.0f + 360.0f * frame / frames;
+            buildFrameDrawLists(jobs, scene, camera, reflections, 800.0f / 600.0f, lists);
+        }
+        double seconds = glfwGetTime() - start;
+
+        std::string name = std::to_string(workers);
+        report.add("job_system", name + "_workers_frame_cpu_ms", 1000.0 * seconds / frames);
+        report.add("job_system", name + "_workers_main_pass_draws", static_cast<double>(lists.main.items.size()));
+    }
+    report.add("job_system", "hardware_threads", std::thread::hardware_concurrency());
+}
+
+// command lists: record throughput on one and on all worker threads, replay throughput
+// against issuing the same calls directly
+// -----------------------------------------------------------------------------------
+static unsigned int createBenchmarkTriangle(unsigned int* vertexArrays, int count)
+{
+    float triangle[] = { -0.5f, -0.5f, 0.0f, 0.5f, -0.5f, 0.0f, 0.0f, 0.5f, 0.0f };
+    unsigned int vertexBuffer;
+    glGenVertexArrays(count, vertexArrays);
+    glGenBuffers(1, &vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(triangle), triangle, GL_STATIC_DRAW);
+    for (int i = 0; i < count; i++)
+    {
+        glBindVertexArray(vertexArrays[i]);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+    }
+    glBindVertexArray(0);
+    return vertexBuffer;
+}
+
+static void recordBenchmarkDraws(CommandList& commands, const ProgramUniforms& program, const unsigned int* vertexArrays,
+    unsigned int uniformBuffer, const std::vector<size_t>& drawOffsets)
+{
+    int sampler = program.location("texture_diffuse1");
+    commands.bindProgram(program.program());
+    for (size_t i = 0; i < drawOffsets.size(); i++)
+    {
+        commands.bindVertexArray(vertexArrays[i & 1]);
+        commands.bindUniformRange(DRAW_BLOCK_BINDING, uniformBuffer, drawOffsets[i], sizeof(DrawBlock));
+        commands.setInt(sampler, static_cast<int>(i & 1));
+        commands.drawArrays(Primitive::Triangles, 0, 3);
+    }
+}
+
+void benchmarkCommandList(BenchmarkReport& report)
+{
+    const int draws = 10000;
+    const int repeats = 10;
+    Shader shader("basic_shader.vs", "basic_shader.fs");
+    bindUniformBlocks(shader.ID);
+    ProgramUniforms program(shader.ID);
+    unsigned int vertexArrays[2];
+    unsigned int vertexBuffer = createBenchmarkTriangle(vertexArrays, 2);
+
+    // one frame of model blocks, written once so only recording is timed
+    UniformRing ring(static_cast<size_t>(draws + 1) * 256);
+    ring.beginFrame();
+    std::vector<size_t> drawOffsets;
+    for (int i = 0; i < draws; i++)
+    {
+        size_t offset = ring.push(DrawBlock{ glm::translate(glm::mat4(1.0f), glm::vec3(i * 0.001f, 0.0f, 0.0f)) });
+        if (offset != UniformRing::NO_SPACE)
+            drawOffsets.push_back(offset);
+    }
+    size_t passOffset = ring.push(PassBlock{ glm::mat4(1.0f), glm::mat4(1.0f), glm::vec4(0.0f), glm::vec4(0.0f) });
+    ring.unmap();
+    glBindBufferRange(GL_UNIFORM_BUFFER, PASS_BLOCK_BINDING, ring.buffer(), passOffset, sizeof(PassBlock));
+
+    // record on this thread
+    CommandList commands;
+    double start = glfwGetTime();
+    for (int r = 0; r < repeats; r++)
+    {
+        commands.clear();
+        recordBenchmarkDraws(commands, program, vertexArrays, ring.buffer(), drawOffsets);
+    }
+    double recordSeconds = glfwGetTime() - start;
+    double commandCount = static_cast<double>(commands.commandCount());
+    report.add("command_list", "commands_per_list", commandCount);
+    report.add("command_list", "bytes_per_command", commands.byteSize() / commandCount);
+    report.add("command_list", "record_commands_per_ms", commandCount * repeats / (1000.0 * recordSeconds));
+
+    // record one list per worker, in parallel
+    {
+        JobSystem jobs(std::max(1u, std::thread::hardware_concurrency()));
+        std::vector<CommandList> lists(jobs.threadCount());
+        start = glfwGetTime();
+        for (int r = 0; r < repeats; r++)
+        {
+            jobs.parallelFor(lists.size(), 1, [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; i++)
+                {
+                    lists[i].clear();
+                    recordBenchmarkDraws(lists[i], program, vertexArrays, ring.buffer(), drawOffsets);
+                }
+            });
+        }
+        double seconds = glfwGetTime() - start;
+        report.add("command_list", "parallel_record_threads", jobs.threadCount());
+        report.add("command_list", "parallel_record_commands_per_ms", commandCount * lists.size() * repeats / (1000.0 * seconds));
+    }
+
+    // replay, then the same calls issued directly; only CPU submission time counts
+    glFinish();
+    start = glfwGetTime();
+    for (int r = 0; r < repeats; r++)
+        commands.replay();
+    double replaySeconds = glfwGetTime() - start;
+    glFinish();
+
+    int sampler = program.location("texture_diffuse1");
+    start = glfwGetTime();
+    for (int r = 0; r < repeats; r++)
+    {
+        glUseProgram(program.program());
+        for (size_t i = 0; i < drawOffsets.size(); i++)
+        {
+            glBindVertexArray(vertexArrays[i & 1]);
+            glBindBufferRange(GL_UNIFORM_BUFFER, DRAW_BLOCK_BINDING, ring.buffer(), drawOffsets[i], sizeof(DrawBlock));
+            glUniform1i(sampler, static_cast<int>(i & 1));
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+    }
+    double directSeconds = glfwGetTime() - start;
+    glFinish();
+
+    report.add("command_list", "replay_commands_per_ms", commandCount * repeats / (1000.0 * replaySeconds));
+    report.add("command_list", "direct_commands_per_ms", commandCount * repeats / (1000.0 * directSeconds));
+
+    glBindVertexArray(0);
+    glDeleteVertexArrays(2, vertexArrays);
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteProgram(shader.ID);
+}
+
+// uniform ring: per-draw model blocks streamed through the ring vs. glBufferSubData into
+// a single uniform buffer before every draw
+// ------------------------------------------------------------------------------------
+void benchmarkUniformRing(BenchmarkReport& report)
+{
+    const int draws = 2000;
+    const int frames = 300;
+    Shader shader("basic_shader.vs", "basic_shader.fs");
+    bindUniformBlocks(shader.ID);
+    unsigned int vertexArray;
+    unsigned int vertexBuffer = createBenchmarkTriangle(&vertexArray, 1);
+    glUseProgram(shader.ID);
+    glBindVertexArray(vertexArray);
+
+    UniformRing ring(static_cast<size_t>(draws + 1) * 256);
+    std::vector<size_t> drawOffsets(draws);
+    double start = glfwGetTime();
+    size_t streamed = 0;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        ring.beginFrame();
+        size_t passOffset = ring.push(PassBlock{ glm::mat4(1.0f), glm::mat4(1.0f), glm::vec4(0.0f), glm::vec4(0.0f) });
+        for (int i = 0; i < draws; i++)
+            drawOffsets[i] = ring.push(DrawBlock{ glm::translate(glm::mat4(1.0f), glm::vec3(i * 0.001f, frame * 0.001f, 0.0f)) });
+        // the blocks are all written before the first draw, as the render loop does
+        ring.unmap();
+        glBindBufferRange(GL_UNIFORM_BUFFER, PASS_BLOCK_BINDING, ring.buffer(), passOffset, sizeof(PassBlock));
+        for (int i = 0; i < draws; i++)
+        {
+            if (drawOffsets[i] == UniformRing::NO_SPACE)
+                continue;
+            glBindBufferRange(GL_UNIFORM_BUFFER, DRAW_BLOCK_BINDING, ring.buffer(), drawOffsets[i], sizeof(DrawBlock));
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+        ring.fence();
+        streamed += ring.bytesStreamedLastFrame();
+        // stands in for the buffer swap that ends a real frame
+        glFlush();
+    }
+    glFinish();
+    double ringSeconds = glfwGetTime() - start;
+
+    unsigned int passBuffer, drawBuffer;
+    glGenBuffers(1, &passBuffer);
+    glGenBuffers(1, &drawBuffer);
+    PassBlock pass = { glm::mat4(1.0f), glm::mat4(1.0f), glm::vec4(0.0f), glm::vec4(0.0f) };
+    glBindBuffer(GL_UNIFORM_BUFFER, passBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(PassBlock), &pass, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, drawBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(DrawBlock), NULL, GL_STREAM_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, PASS_BLOCK_BINDING, passBuffer);
+    glBindBufferBase(GL_UNIFORM_BUFFER, DRAW_BLOCK_BINDING, drawBuffer);
+    start = glfwGetTime();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        for (int i = 0; i < draws; i++)
+        {
+            DrawBlock block = { glm::translate(glm::mat4(1.0f), glm::vec3(i * 0.001f, frame * 0.001f, 0.0f)) };
+            glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(DrawBlock), &block);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+        glFlush();
+    }
+    glFinish();
+    double subDataSeconds = glfwGetTime() - start;
+
+    report.add("uniform_ring", "persistent_mapping", ring.persistent() ? 1.0 : 0.0);
+    report.add("uniform_ring", "draws_per_frame", draws);
+    report.add("uniform_ring", "ring_ms_per_frame", 1000.0 * ringSeconds / frames);
+    report.add("uniform_ring", "buffer_sub_data_ms_per_frame", 1000.0 * subDataSeconds / frames);
+    report.add("uniform_ring", "bytes_streamed_per_frame", static_cast<double>(streamed) / frames);
+    report.add("uniform_ring", "fence_waits", static_cast<double>(ring.fenceWaits()));
+    report.add("uniform_ring", "fence_wait_ms_total", 1000.0 * ring.fenceWaitSeconds());
+    report.add("uniform_ring", "overflows", static_cast<double>(ring.overflows()));
+
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &vertexArray);
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteBuffers(1, &passBuffer);
+    glDeleteBuffers(1, &drawBuffer);
+    glDeleteProgram(shader.ID);
+}
+
+// scene graph: cost of update() with 1% of the nodes moved per frame against recomputing
+// every world transform, on 8-ary hierarchies of 10k to 100k nodes
+// -------------------------------------------------------------------------------------
+void benchmarkSceneGraph(BenchmarkReport& report)
+{
+    const int frames = 200;
+    const unsigned int nodeCounts[] = { 10000, 25000, 50000, 100000 };
+    for (unsigned int nodes : nodeCounts)
+    {
+        SceneGraph graph;
+        const DrawBounds unit = { glm::dvec3(0.0), 1.0f };
+        for (unsigned int i = 0; i < nodes; i++)
+        {
+            unsigned int parent = i == 0 ? SceneGraph::NO_PARENT : (i - 1) / 8;
+            graph.addNode(parent, glm::translate(glm::dmat4(1.0), glm::dvec3(1.0, 0.0, 0.0)), unit);
+        }
+        graph.update();
+
+        // the same pseudo-random 1% every run
+        unsigned int seed = 12345u;
+        unsigned int moved = std::max(1u, nodes / 100);
+        size_t recomputed = 0;
+        double start = glfwGetTime();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            for (unsigned int i = 0; i < moved; i++)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                unsigned int node = seed % nodes;
+                graph.setLocal(node, glm::rotate(graph.local(node), 0.01, glm::dvec3(0, 1, 0)));
+            }
+            recomputed += graph.update();
+        }
+        double dirtySeconds = glfwGetTime() - start;
+
+        // touching the root recomputes the whole hierarchy, what rebuilding every tick costs
+        start = glfwGetTime();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            graph.setLocal(0, graph.local(0));
+            graph.update();
+        }
+        double fullSeconds = glfwGetTime() - start;
+
+        std::string name = std::to_string(nodes);
+        report.add("scene_graph", name + "_nodes_dirty_update_ms", 1000.0 * dirtySeconds / frames);
+        report.add("scene_graph", name + "_nodes_full_update_ms", 1000.0 * fullSeconds / frames);
+        report.add("scene_graph", name + "_nodes_recomputed_per_frame", static_cast<double>(recomputed) / frames);
+    }
+}
+
+// terrain: a flight across the Mars terrain through all three passes, per-frame chunks,
+// triangles, resident tiles and streamed bytes with the default cache and upload budget
+// -------------------------------------------------------------------------------------
+void benchmarkTerrain(BenchmarkReport& report)
+{
+    const int frames = 600;
+    const float speed = 20.0f;    // m/s at 60 frames per second
+    SceneTerrain placement;
+    placement.path = "resources/terrain/Marscolor.png";
+    placement.center = glm::dvec3(0.0, -14.0, 0.0);
+    Terrain terrain;
+    if (!terrain.load(placement))
+        return;
+    terrain.createGpuResources();
+
+    JobSystem jobs(std::max(1u, std::thread::hardware_concurrency()));
+    FrameDrawLists lists;
+    SceneState scene;
+    CameraState camera;
+    camera.Position = glm::dvec3(-200.0, 4.0, -150.0);
+    camera.Pitch = -10.0f;
+    const ReflectionSchedule reflections = ReflectionSchedule::single(0.0);
+    std::vector<const TerrainSelection*> selections;
+
+    double cpuSeconds = 0.0;
+    double chunks = 0.0, triangles = 0.0, resident = 0.0, uploadBytes = 0.0;
+    size_t maxTriangles = 0, maxUploadBytes = 0, framesWaiting = 0;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        // straight across with a slow weave, so new tiles keep coming into view
+        camera.Yaw = 35.0f + 25.0f * std::sin(frame * 0.02f);
+        camera.Position += glm::dvec3(camera.front() * glm::vec3(1.0f, 0.0f, 1.0f) * (speed / 60.0f));
+
+        double start = glfwGetTime();
+        buildFrameDrawLists(jobs, scene, camera, reflections, 800.0f / 600.0f, lists, nullptr, &terrain);
+        frameTerrainSelections(lists, selections);
+        terrain.stream(selections);
+        cpuSeconds += glfwGetTime() - start;
+
+        const TerrainStats& stats = terrain.stats();
+        chunks += stats.chunks;
+        triangles += stats.triangles;
+        resident += stats.residentTiles;
+        uploadBytes += stats.uploadBytes;
+        maxTriangles = std::max(maxTriangles, stats.triangles);
+        maxUploadBytes = std::max(maxUploadBytes, stats.uploadBytes);
+        if (stats.requests > stats.uploads)
+            framesWaiting++;
+    }
+    glFinish();
+
+    report.add("terrain", "levels", terrain.levels());
+    report.add("terrain", "cache_tiles", static_cast<double>(terrain.cacheCapacity()));
+    report.add("terrain", "cache_bytes", static_cast<double>(terrain.cacheCapacity()) * Terrain::TILE_BYTES);
+    report.add("terrain", "select_and_stream_cpu_ms", 1000.0 * cpuSeconds / frames);
+    report.add("terrain", "chunks_per_frame", chunks / frames);
+    report.add("terrain", "triangles_per_frame", triangles / frames);
+    report.add("terrain", "triangles_per_frame_max", static_cast<double>(maxTriangles));
+    report.add("terrain", "resident_tiles", resident / frames);
+    report.add("terrain", "upload_bytes_per_frame", uploadBytes / frames);
+    report.add("terrain", "upload_bytes_per_frame_max", static_cast<double>(maxUploadBytes));
+    report.add("terrain", "frames_over_upload_budget", static_cast<double>(framesWaiting));
+}
+
+// origin rebasing: the same patch of water rendered at the world origin and a thousand km away,
+// compared pixel by pixel, plus the projected vertex error with and without the floating origin
+// ---------------------------------------------------------------------------------------------
+static unsigned int createBenchmarkTexture(int internalFormat, unsigned int format, unsigned int type, int size, const void* data)
+{
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, size, size, 0, format, type, data);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+// largest distance in pixels between where the reference and a float transform put a point
+static double projectedError(const glm::dmat4& reference, const glm::mat4& transform, const glm::vec3& point, int size)
+{
+    glm::dvec4 exact = reference * glm::dvec4(glm::dvec3(point), 1.0);
+    glm::vec4 rounded = transform * glm::vec4(point, 1.0f);
+    glm::dvec2 a = glm::dvec2(exact.x, exact.y) / exact.w;
+    glm::dvec2 b = glm::dvec2(rounded.x, rounded.y) / static_cast<double>(rounded.w);
+    return glm::length(a - b) * 0.5 * size;
+}
+
+void benchmarkOriginRebasing(BenchmarkReport& report)
+{
+    const int size = 256;
+    const int patternSize = 64;
+    const int tiles = 8;
+    // far enough out that a float position only resolves 6 cm; the fraction keeps the scene off the rebase grid
+    const glm::dvec3 far(1000037.25, 0.0, 1000037.25);
+    const glm::dvec3 eye(0.3, 2.5, -5.2);
+
+    // checkered pass textures and a rippled height field, so both screen and world position show up in the image
+    std::vector<unsigned char> checker(patternSize * patternSize * 4);
+    std::vector<float> heights(patternSize * patternSize);
+    for (int y = 0; y < patternSize; y++)
+    {
+        for (int x = 0; x < patternSize; x++)
+        {
+            bool odd = ((x / 8) + (y / 8)) % 2 != 0;
+            unsigned char* texel = &checker[(y * patternSize + x) * 4];
+            texel[0] = odd ? 230 : 30;
+            texel[1] = static_cast<unsigned char>(x * 4);
+            texel[2] = static_cast<unsigned char>(y * 4);
+            texel[3] = 255;
+            heights[y * patternSize + x] = 0.01f * std::sin(x * 0.4f) * std::cos(y * 0.3f);
+        }
+    }
+    unsigned int patternTexture = createBenchmarkTexture(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, patternSize, checker.data());
+    unsigned int heightTexture = createBenchmarkTexture(GL_R32F, GL_RED, GL_FLOAT, patternSize, heights.data());
+    unsigned int colorTexture = createBenchmarkTexture(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, size, nullptr);
+    unsigned int depthBuffer, framebuffer;
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, size, size);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+    float square[] = { -0.5f, 0.5f, 0.0f, -0.5f, -0.5f, 0.0f, 0.5f, -0.5f, 0.0f, -0.5f, 0.5f, 0.0f, 0.5f, -0.5f, 0.0f, 0.5f, 0.5f, 0.0f };
+    unsigned int vertexArray, vertexBuffer;
+    glGenVertexArrays(1, &vertexArray);
+    glGenBuffers(1, &vertexBuffer);
+    glBindVertexArray(vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(square), square, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    // no floor or detail under this water
+    ShaderVariants variants("");
+    UniformRing ring(64 * 1024);
+    JobSystem jobs(1);
+    SceneResources resources;
+    resources.waterProgram = variants.get("water.vs", "water.fs", FEATURE_DISTORTION | FEATURE_FRESNEL);
+    resources.uniforms = &ring;
+    resources.waterVertexArray = vertexArray;
+    resources.planeTextures.push_back({ patternTexture, patternTexture });
+    const ReflectionSchedule reflections = ReflectionSchedule::single(0.0);
+    resources.heightTexture = heightTexture;
+    resources.simExtent = static_cast<float>(tiles);
+
+    std::vector<unsigned char> pixels[2];
+    double floatError = 0.0, rebasedError = 0.0;
+    for (int run = 0; run < 2; run++)
+    {
+        glm::dvec3 offset = run == 0 ? glm::dvec3(0.0) : far;
+        SceneState scene;
+        for (int i = 0; i < tiles; i++)
+        {
+            for (int j = 0; j < tiles; j++)
+            {
+                glm::dmat4 model = glm::translate(glm::dmat4(1.0), offset + glm::dvec3(i - 0.5 * (tiles - 1), 0.0, j - 0.5 * (tiles - 1)));
+                model = glm::rotate(model, glm::radians(90.0), glm::dvec3(1, 0, 0));
+                scene.waterTransforms.push_back(model);
+                scene.waterBounds.push_back(transformBounds(model, { glm::dvec3(0.0), 0.7072f }));
+            }
+        }
+        CameraState camera;
+        camera.Position = offset + eye;
+        camera.Yaw = 90.0f;
+        camera.Pitch = -25.0f;
+        // representable in float at either offset, so the solver's own origin adds no error of its own
+        resources.simOrigin = glm::vec2(static_cast<float>(offset.x - 0.5 * tiles), static_cast<float>(offset.z - 0.5 * tiles));
+
+        FrameDrawLists lists;
+        ring.beginFrame();
+        buildFrameDrawLists(jobs, scene, camera, reflections, 1.0f, lists, &resources);
+        ring.unmap();
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glViewport(0, 0, size, size);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        lists.main.commands.replay();
+        ring.fence();
+        pixels[run].resize(size * size * 4);
+        glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, pixels[run].data());
+
+        if (run == 0)
+            continue;
+        // every tile corner through a double reference, the plain float matrices and the rebased ones
+        glm::dvec3 origin = renderOrigin(camera.Position);
+        glm::dmat4 projection = glm::perspective(glm::radians(static_cast<double>(camera.Zoom)), 1.0, 0.1, 100.0);
+        glm::dvec3 front(camera.front()), up(camera.up());
+        glm::dmat4 view = glm::lookAt(camera.Position, camera.Position + front, up);
+        glm::mat4 floatView = glm::lookAt(glm::vec3(camera.Position), glm::vec3(camera.Position) + camera.front(), camera.up());
+        glm::mat4 rebasedView = camera.viewMatrix(origin);
+        for (const glm::dmat4& model : scene.waterTransforms)
+        {
+            glm::dmat4 reference = projection * view * model;
+            glm::mat4 plain = glm::mat4(projection) * floatView * glm::mat4(model);
+            glm::mat4 rebased = glm::mat4(projection) * rebasedView * toRenderSpace(model, origin);
+            for (int corner = 0; corner < 4; corner++)
+            {
+                glm::vec3 point((corner & 1) ? 0.5f : -0.5f, (corner & 2) ? 0.5f : -0.5f, 0.0f);
+                floatError = std::max(floatError, projectedError(reference, plain, point, size));
+                rebasedError = std::max(rebasedError, projectedError(reference, rebased, point, size));
+            }
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    size_t covered = 0, differing = 0;
+    int maxDifference = 0;
+    for (int i = 0; i < size * size; i++)
+    {
+        int difference = 0;
+        for (int c = 0; c < 3; c++)
+            difference = std::max(difference, std::abs(pixels[0][i * 4 + c] - pixels[1][i * 4 + c]));
+        if (pixels[0][i * 4] || pixels[0][i * 4 + 1] || pixels[0][i * 4 + 2])
+            covered++;
+        // one step is filtering noise, more is a visible shift
+        if (difference > 1)
+            differing++;
+        maxDifference = std::max(maxDifference, difference);
+    }
+
+    report.add("origin_rebasing", "offset_m", far.x);
+    report.add("origin_rebasing", "covered_pixels", static_cast<double>(covered));
+    report.add("origin_rebasing", "differing_pixels", static_cast<double>(differing));
+    report.add("origin_rebasing", "max_channel_difference", maxDifference);
+    report.add("origin_rebasing", "float_vertex_error_px", floatError);
+    report.add("origin_rebasing", "rebased_vertex_error_px", rebasedError);
+
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(1, &depthBuffer);
+    unsigned int textures[] = { patternTexture, heightTexture, colorTexture };
+    glDeleteTextures(3, textures);
+    glDeleteVertexArrays(1, &vertexArray);
+    glDeleteBuffers(1, &vertexBuffer);
+}
+
+// ocean: a fast, low and weaving flight over open water, per-frame chunk counts, instanced draws
+// and the CPU cost of paging and culling them, plus any growth of the chunk pool
+// ---------------------------------------------------------------------------------------------
+void benchmarkOcean(BenchmarkReport& report)
+{
+    const int frames = 1200;
+    const float speed = 250.0f;    // m/s at 60 frames per second
+    SceneOcean settings;
+    settings.chunkSize = 4.0f;
+    settings.range = 100.0f;
+    Ocean ocean;
+    ocean.configure(settings);
+    ocean.createGpuResources();
+
+    JobSystem jobs(std::max(1u, std::thread::hardware_concurrency()));
+    FrameDrawLists lists;
+    SceneState scene;
+    CameraState camera;
+    camera.Position = glm::dvec3(0.0, 3.0, 0.0);
+    const ReflectionSchedule reflections = ReflectionSchedule::single(0.0);
+    buildFrameDrawLists(jobs, scene, camera, reflections, 800.0f / 600.0f, lists, nullptr, nullptr, &ocean);
+    const glm::vec4* pool = lists.main.ocean.chunks.data();
+
+    double cpuSeconds = 0.0;
+    double chunks = 0.0, draws = 0.0;
+    size_t maxChunks = 0, dropped = 0, reallocations = 0;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        // skimming the surface, climbing and turning so every LOD level changes
+        camera.Yaw = 20.0f + 90.0f * std::sin(frame * 0.01f);
+        camera.Pitch = -10.0f - 20.0f * (0.5f + 0.5f * std::sin(frame * 0.013f));
+        camera.Position += glm::dvec3(camera.front() * glm::vec3(1.0f, 0.0f, 1.0f) * (speed / 60.0f));
+        camera.Position.y = 2.0 + 40.0 * (0.5 + 0.5 * std::sin(frame * 0.007));
+
+        double start = glfwGetTime();
+        buildFrameDrawLists(jobs, scene, camera, reflections, 800.0f / 600.0f, lists, nullptr, nullptr, &ocean);
+        cpuSeconds += glfwGetTime() - start;
+
+        const OceanSelection& selection = lists.main.ocean;
+        chunks += static_cast<double>(selection.count);
+        maxChunks = std::max(maxChunks, selection.count);
+        dropped += selection.dropped;
+        for (const DrawItem& item : lists.main.items)
+            draws += item.kind == DrawKind::Ocean ? 1.0 : 0.0;
+        if (selection.chunks.data() != pool)
+            reallocations++;
+        pool = selection.chunks.data();
+    }
+
+    report.add("ocean", "levels", ocean.levels());
+    report.add("ocean", "distance_flown_m", static_cast<double>(speed) * frames / 60.0);
+    report.add("ocean", "frame_cpu_ms", 1000.0 * cpuSeconds / frames);
+    report.add("ocean", "chunks_per_frame", chunks / frames);
+    report.add("ocean", "chunks_per_frame_max", static_cast<double>(maxChunks));
+    report.add("ocean", "triangles_per_frame", chunks / frames * Ocean::GRID * Ocean::GRID * 2);
+    report.add("ocean", "instanced_draws_per_frame", draws / frames);
+    report.add("ocean", "dropped_chunks", static_cast<double>(dropped));
+    report.add("ocean", "pool_reallocations", static_cast<double>(reallocations));
+}
+
+// planar reflections: a dozen pools at four heights seen from an orbiting camera; water bodies
+// and planes on screen against plane renders actually issued under the default budget
+// -------------------------------------------------------------------------------------------
+void benchmarkPlanarReflections(BenchmarkReport& report)
+{
+    const int frames = 600;
+    const double heights[] = { 0.0, 0.0, 1.5, 0.0, 3.0, 1.5, 0.0, 6.0, 3.0, 1.5, 0.0, 3.0 };
+    SceneDescription description;
+    for (int i = 0; i < 12; i++)
+    {
+        SceneWater body;
+        body.center = glm::dvec3((i % 4) * 12.0 - 18.0, heights[i], (i / 4) * 12.0 - 12.0);
+        body.size = glm::vec2(8.0f);
+        body.tiles = glm::ivec2(4);
+        description.water.push_back(body);
+    }
+    PlanarReflections reflections;
+    reflections.create(description, 800, 600);
+
+    // tiles the way the simulation thread lays them out
+    SceneState scene;
+    std::vector<glm::mat4> tiles;
+    for (unsigned int i = 0; i < description.water.size(); i++)
+    {
+        description.water[i].tileTransforms(tiles);
+        for (const glm::mat4& tile : tiles)
+        {
+            glm::dmat4 model = glm::translate(glm::dmat4(1.0), description.water[i].center) * glm::dmat4(tile);
+            scene.waterTransforms.push_back(model);
+            scene.waterBounds.push_back(transformBounds(model, { glm::dvec3(0.0), 0.7072f }));
+            scene.waterBodies.push_back(i);
+        }
+    }
+
+    JobSystem jobs(std::max(1u, std::thread::hardware_concurrency()));
+    FrameDrawLists lists;
+    CameraState camera;
+    double cpuSeconds = 0.0;
+    double bodiesVisible = 0.0, planesVisible = 0.0, renders = 0.0, deferred = 0.0, targetBytes = 0.0;
+    size_t maxStale = 0, maxRenders = 0;
+    std::vector<unsigned char> bodySeen(description.water.size());
+    for (int frame = 0; frame < frames; frame++)
+    {
+        // circle the pools, looking across them towards the middle
+        float angle = frame * 0.01f;
+        camera.Position = glm::dvec3(30.0 * std::cos(angle), 8.0, 30.0 * std::sin(angle));
+        camera.Yaw = glm::degrees(angle) + 180.0f + 20.0f * std::sin(frame * 0.03f);
+        camera.Pitch = -15.0f;
+
+        double start = glfwGetTime();
+        reflections.schedule(lists.planeCoverage);
+        buildFrameDrawLists(jobs, scene, camera, reflections.current(), 800.0f / 600.0f, lists);
+        cpuSeconds += glfwGetTime() - start;
+
+        std::fill(bodySeen.begin(), bodySeen.end(), 0);
+        for (size_t i = 0; i < scene.waterBodies.size(); i++)
+        {
+            if (lists.waterVisible[i])
+                bodySeen[scene.waterBodies[i]] = 1;
+        }
+        bodiesVisible += static_cast<double>(std::count(bodySeen.begin(), bodySeen.end(), 1));
+        const PlanarReflectionStats& stats = reflections.stats();
+        planesVisible += static_cast<double>(stats.planesVisible);
+        renders += static_cast<double>(stats.renders);
+        deferred += static_cast<double>(stats.deferred);
+        targetBytes += static_cast<double>(stats.targetBytes);
+        maxRenders = std::max(maxRenders, stats.renders);
+        // the first frames render everything once, staleness only means something after that
+        if (frame >= 10)
+            maxStale = std::max(maxStale, stats.maxStaleFrames);
+    }
+
+    const PlanarReflectionStats& stats = reflections.stats();
+    report.add("planar_reflections", "water_bodies", static_cast<double>(stats.bodies));
+    report.add("planar_reflections", "planes", static_cast<double>(stats.planes));
+    report.add("planar_reflections", "update_budget", reflections.UpdateBudget);
+    report.add("planar_reflections", "bodies_visible_per_frame", bodiesVisible / frames);
+    report.add("planar_reflections", "planes_visible_per_frame", planesVisible / frames);
+    report.add("planar_reflections", "renders_per_frame", renders / frames);
+    report.add("planar_reflections", "renders_per_frame_max", static_cast<double>(maxRenders));
+    report.add("planar_reflections", "deferred_per_frame", deferred / frames);
+    report.add("planar_reflections", "max_stale_frames", static_cast<double>(maxStale));
+    report.add("planar_reflections", "target_bytes", targetBytes / frames);
+    report.add("planar_reflections", "schedule_and_build_cpu_ms", 1000.0 * cpuSeconds / frames);
+}
+
+// screen-space reflections: a pool with boxes standing in it, drawn with each reflection mode
+// from the same orbit; GPU frame time and scene passes per mode, and how far the image of each
+// mode strays from the planar one
+// ------------------------------------------------------------------------------------------
+static void addBenchmarkCubeFace(std::vector<glm::vec3>& corners, glm::vec3& normal, int face)
+{
+    int axis = face / 2;
+    float side = face % 2 ? -1.0f : 1.0f;
+    normal = glm::vec3(0.0f);
+    normal[axis] = side;
+    glm::vec3 u(0.0f), v(0.0f);
+    u[(axis + 1) % 3] = 1.0f;
+    v[(axis + 2) % 3] = side;
+    corners.clear();
+    corners.push_back(normal - u - v);
+    corners.push_back(normal + u - v);
+    corners.push_back(normal + u + v);
+    corners.push_back(normal - u + v);
+}
+
+static unsigned int createBenchmarkCubemap()
+{
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+    const int size = 16;
+    std::vector<unsigned char> pixels(size * size * 3);
+    for (int face = 0; face < 6; face++)
+    {
+        // light above the horizon, dark below, a different tint per face
+        for (int y = 0; y < size; y++)
+        {
+            for (int x = 0; x < size; x++)
+            {
+                unsigned char* texel = &pixels[(y * size + x) * 3];
+                bool up = face == 2 || (face != 3 && y < size / 2);
+                texel[0] = static_cast<unsigned char>(up ? 120 + face * 20 : 40);
+                texel[1] = static_cast<unsigned char>(up ? 170 : 50);
+                texel[2] = static_cast<unsigned char>(up ? 230 - face * 15 : 60);
+            }
+        }
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGB, size, size, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+    }
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+// colour and depth-stencil renderbuffers to draw the main pass into and read back
+static unsigned int createBenchmarkFramebuffer(int width, int height, unsigned int* renderbuffers)
+{
+    unsigned int framebuffer;
+    glGenRenderbuffers(2, renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return framebuffer;
+}
+
+// the scene both reflection-quality benchmarks orbit: one pool of 8 x 8 tiles with a ring of
+// checkered boxes half in the water and one tower behind, under a two-tone sky
+struct BenchmarkPool
+{
+    SceneDescription description;
+    SceneState scene;
+    std::vector<Mesh> box;
+    unsigned int boxTexture = 0, heightTexture = 0, cubemapTexture = 0;
+    unsigned int vertexArrays[2] = {}, vertexBuffers[2] = {};   // water square, sky cube
+
+    void create();
+    void destroy();
+    // everything but the programs, the ring and the targets
+    void fill(SceneResources& resources) const;
+    // frame of the orbit, the last one of a run coming back to where the first started
+    static CameraState orbit(float angle);
+};
+
+void BenchmarkPool::create()
+{
+    const int patternSize = 64;
+
+    // checkered boxes, a rippled height field and a two-tone sky
+    std::vector<unsigned char> checker(patternSize * patternSize * 4);
+    std::vector<float> heights(patternSize * patternSize);
+    for (int y = 0; y < patternSize; y++)
+    {
+        for (int x = 0; x < patternSize; x++)
+        {
+            bool odd = ((x / 8) + (y / 8)) % 2 != 0;
+            unsigned char* texel = &checker[(y * patternSize + x) * 4];
+            texel[0] = odd ? 220 : 60;
+            texel[1] = odd ? 90 : 180;
+            texel[2] = static_cast<unsigned char>(y * 4);
+            texel[3] = 255;
+            heights[y * patternSize + x] = 0.004f * std::sin(x * 0.5f) * std::cos(y * 0.4f);
+        }
+    }
+    boxTexture = createBenchmarkTexture(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, patternSize, checker.data());
+    heightTexture = createBenchmarkTexture(GL_R32F, GL_RED, GL_FLOAT, patternSize, heights.data());
+    cubemapTexture = createBenchmarkCubemap();
+
+    // the box as a model mesh, and the sky cube as 36 bare positions
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    std::vector<float> skyVertices;
+    std::vector<glm::vec3> corners;
+    glm::vec3 normal;
+    for (int face = 0; face < 6; face++)
+    {
+        addBenchmarkCubeFace(corners, normal, face);
+        unsigned int base = static_cast<unsigned int>(vertices.size());
+        for (int i = 0; i < 4; i++)
+        {
+            Vertex vertex = {};
+            vertex.Position = corners[i] * 0.5f;
+            vertex.Normal = normal;
+            vertex.TexCoords = glm::vec2(i == 1 || i == 2 ? 1.0f : 0.0f, i >= 2 ? 1.0f : 0.0f);
+            vertices.push_back(vertex);
+        }
+        unsigned int quad[6] = { 0, 1, 2, 0, 2, 3 };
+        for (unsigned int corner : quad)
+        {
+            indices.push_back(base + corner);
+            skyVertices.insert(skyVertices.end(), { corners[corner].x, corners[corner].y, corners[corner].z });
+        }
+    }
+    box.push_back(Mesh(vertices, indices, { { boxTexture, "texture_diffuse", "" } }));
+
+    float square[] = { -0.5f, 0.5f, 0.0f, -0.5f, -0.5f, 0.0f, 0.5f, 0.5f, 0.0f, 0.5f, 0.5f, 0.0f, -0.5f, -0.5f, 0.0f, 0.5f, -0.5f, 0.0f };
+    glGenVertexArrays(2, vertexArrays);
+    glGenBuffers(2, vertexBuffers);
+    glBindVertexArray(vertexArrays[0]);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffers[0]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(square), square, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(vertexArrays[1]);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffers[1]);
+    glBufferData(GL_ARRAY_BUFFER, skyVertices.size() * sizeof(float), skyVertices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    // one pool of 8 x 8 tiles, a ring of boxes half in the water and one tower behind
+    SceneWater pool;
+    pool.center = glm::dvec3(0.0);
+    pool.size = glm::vec2(8.0f);
+    pool.tiles = glm::ivec2(8);
+    description.water.push_back(pool);
+    std::vector<glm::mat4> tiles;
+    pool.tileTransforms(tiles);
+    for (const glm::mat4& tile : tiles)
+    {
+        scene.waterTransforms.push_back(glm::dmat4(tile));
+        scene.waterBounds.push_back(transformBounds(glm::dmat4(tile), { glm::dvec3(0.0), 0.7072f }));
+        scene.waterBodies.push_back(0);
+    }
+    DrawBounds boxBounds = { glm::dvec3(0.0), 0.8661f };
+    for (int i = 0; i < 9; i++)
+    {
+        double angle = i * 0.6981;
+        glm::dmat4 transform = glm::translate(glm::dmat4(1.0), glm::dvec3(2.5 * std::cos(angle), 0.1, 2.5 * std::sin(angle)));
+        if (i == 8)
+            transform = glm::scale(glm::translate(glm::dmat4(1.0), glm::dvec3(0.0, 1.5, -6.0)), glm::dvec3(2.0, 4.0, 1.0));
+        scene.instances.push_back({ 0, transform, transformBounds(transform, boxBounds) });
+    }
+}
+
+void BenchmarkPool::destroy()
+{
+    unsigned int textures[] = { boxTexture, heightTexture, cubemapTexture };
+    glDeleteTextures(3, textures);
+    glDeleteVertexArrays(2, vertexArrays);
+    glDeleteBuffers(2, vertexBuffers);
+}
+
+void BenchmarkPool::fill(SceneResources& resources) const
+{
+    resources.models.push_back(&box);
+    resources.waterVertexArray = vertexArrays[0];
+    resources.skyboxVertexArray = vertexArrays[1];
+    resources.heightTexture = heightTexture;
+    resources.cubemapTexture = cubemapTexture;
+    resources.environmentTexture = cubemapTexture;
+    resources.simOrigin = glm::vec2(-4.0f);
+    resources.simExtent = 8.0f;
+}
+
+CameraState BenchmarkPool::orbit(float angle)
+{
+    CameraState camera;
+    camera.Position = glm::dvec3(9.0 * std::sin(angle), 3.0, 9.0 * std::cos(angle));
+    camera.Yaw = -90.0f - glm::degrees(angle);
+    camera.Pitch = -18.0f;
+    return camera;
+}
+
+void benchmarkScreenSpaceReflections(BenchmarkReport& report)
+{
+    const int width = 800, height = 600;
+    const int frames = 120;
+    const float aspect = static_cast<float>(width) / height;
+    BenchmarkPool pool;
+    pool.create();
+
+    Shader waterShader("water.vs", "water.fs");
+    Shader modelShader("basic_shader.vs", "basic_shader.fs");
+    Shader skyShader("sky.vs", "sky.fs");
+    Shader hiZShader("hiz.vs", "hiz.fs");
+    unsigned int programs[] = { waterShader.ID, modelShader.ID, skyShader.ID };
+    for (unsigned int program : programs)
+        bindUniformBlocks(program);
+
+    PlanarReflections reflections;
+    reflections.create(pool.description, width, height);
+    ScreenSpaceReflections screenSpace;
+    screenSpace.create(width, height, hiZShader.ID);
+    UniformRing ring(1 << 20);
+    JobSystem jobs(std::max(1u, std::thread::hardware_concurrency()));
+    SceneResources resources;
+    resources.waterProgram = ProgramUniforms(waterShader.ID);
+    resources.modelProgram = ProgramUniforms(modelShader.ID);
+    resources.skyProgram = ProgramUniforms(skyShader.ID);
+    resources.uniforms = &ring;
+    pool.fill(resources);
+    resources.planeTextures.push_back({ reflections.reflectionTexture(0), reflections.refractionTexture(0),
+                                        reflections.reflectionDepthTexture(0), reflections.refractionDepthTexture(0) });
+    resources.sceneColorTexture = screenSpace.colorTexture();
+    resources.hiZTexture = screenSpace.hiZTexture();
+    resources.hiZLevels = screenSpace.hiZLevels();
+
+    // what every mode ends up in, read back for the comparison
+    unsigned int renderbuffers[2];
+    unsigned int framebuffer = createBenchmarkFramebuffer(width, height, renderbuffers);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CLIP_DISTANCE0);
+
+    const ReflectionMode modes[] = { ReflectionMode::Planar, ReflectionMode::ScreenSpace, ReflectionMode::Blended };
+    const char* names[] = { "planar", "ssr", "blended" };
+    std::vector<unsigned char> pixels[3];
+    FrameDrawLists lists;
+    for (int m = 0; m < 3; m++)
+    {
+        reflections.Mode = modes[m];
+        resources.reflectionMode = modes[m];
+        double gpuSeconds = 0.0, passes = 0.0;
+        // the timed orbit, then one more frame at the first pose for the image
+        for (int frame = 0; frame <= frames; frame++)
+        {
+            CameraState camera = BenchmarkPool::orbit(frame < frames ? frame * 0.02f : 0.0f);
+
+            glFinish();
+            double start = glfwGetTime();
+            ring.beginFrame();
+            reflections.schedule(lists.planeCoverage);
+            buildFrameDrawLists(jobs, pool.scene, camera, reflections.current(), aspect, lists, &resources);
+            ring.unmap();
+            for (size_t i = 0; i < lists.planeCount; i++)
+            {
+                const PlanePassLists& planeLists = lists.planes[i];
+                glm::ivec2 size = reflections.size(planeLists.plane);
+                glViewport(0, 0, size.x, size.y);
+                glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+                glBindFramebuffer(GL_FRAMEBUFFER, reflections.reflectionFramebuffer(planeLists.plane));
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                planeLists.reflection.commands.replay();
+                passes += 1.0;
+                if (!lists.refraction)
+                    continue;
+                glBindFramebuffer(GL_FRAMEBUFFER, reflections.refractionFramebuffer(planeLists.plane));
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                planeLists.refraction.commands.replay();
+                passes += 1.0;
+            }
+            if (modes[m] == ReflectionMode::Planar)
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+                glViewport(0, 0, width, height);
+                glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                lists.main.commands.replay();
+            }
+            else
+            {
+                screenSpace.beginScene();
+                lists.main.commands.replay();
+                screenSpace.buildHiZ();
+                lists.main.waterCommands.replay();
+                screenSpace.present(framebuffer, width, height);
+            }
+            passes += 1.0;
+            ring.fence();
+            glFinish();
+            if (frame < frames)
+                gpuSeconds += glfwGetTime() - start;
+        }
+        pixels[m].resize(width * height * 4);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels[m].data());
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        size_t targetBytes = reflections.stats().targetBytes + (modes[m] == ReflectionMode::Planar ? 0 : screenSpace.targetBytes());
+        report.add("screen_space_reflections", std::string(names[m]) + "_frame_ms", 1000.0 * gpuSeconds / frames);
+        report.add("screen_space_reflections", std::string(names[m]) + "_scene_passes_per_frame", passes / (frames + 1));
+        report.add("screen_space_reflections", std::string(names[m]) + "_target_bytes", static_cast<double>(targetBytes));
+        if (m == 0)
+            continue;
+        // against planar, the reference: mean difference and pixels off by more than a few steps
+        double sum = 0.0;
+        size_t differing = 0;
+        for (int i = 0; i < width * height; i++)
+        {
+            int difference = 0;
+            for (int c = 0; c < 3; c++)
+                difference = std::max(difference, std::abs(pixels[0][i * 4 + c] - pixels[m][i * 4 + c]));
+            sum += difference;
+            if (difference > 8)
+                differing++;
+        }
+        report.add("screen_space_reflections", std::string(names[m]) + "_mean_difference", sum / (width * height));
+        report.add("screen_space_reflections", std::string(names[m]) + "_differing_fraction", static_cast<double>(differing) / (width * height));
+    }
+    glDisable(GL_CLIP_DISTANCE0);
+    glDisable(GL_DEPTH_TEST);
+
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(2, renderbuffers);
+    pool.destroy();
+    for (unsigned int program : programs)
+        glDeleteProgram(program);
+    glDeleteProgram(hiZShader.ID);
+}
+
+// temporal reflections: the pool orbited with full-size planar targets, half-size ones, and half-size
+// ones jittered and accumulated; GPU frame time, target memory, and how close each reduced image
+// comes to the full-size one, mid-orbit and after the camera has held still for a while
+// ---------------------------------------------------------------------------------------------
+static void compareImages(const std::vector<unsigned char>& reference, const std::vector<unsigned char>& image, double& meanDifference, double& psnr)
+{
+    double sum = 0.0, squared = 0.0;
+    size_t pixels = reference.size() / 4;
+    for (size_t i = 0; i < pixels; i++)
+    {
+        int difference = 0;
+        for (int c = 0; c < 3; c++)
+        {
+            int channel = reference[i * 4 + c] - image[i * 4 + c];
+            difference = std::max(difference, std::abs(channel));
+            squared += channel * channel;
+        }
+        sum += difference;
+    }
+    meanDifference = sum / pixels;
+    double mse = squared / (pixels * 3);
+    psnr = mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+// one run of the pool through planar reflections, moving for FRAMES then holding still; GPU time of
+// the moving frames, of their refraction passes and of their main pass, and the images at the
+// capture frames
+struct PoolOrbit
+{
+    static const int FRAMES = 120, STILL_FRAMES = 16;
+    static const int CAPTURES = 3;      // two moving, one still
+
+    double frameMs = 0.0;
+    double refractionMs = 0.0;
+    double mainMs = 0.0;                // the scene and the water shaded over it
+    std::vector<unsigned char> captures[CAPTURES];
+    PipelineStatistics* statistics = nullptr;   // if given, brackets every scene pass
+
+    // toneMapper, if given, takes the main pass and maps it onto framebuffer
+    void run(const BenchmarkPool& pool, PlanarReflections& reflections, SceneResources& resources, UniformRing& ring,
+        JobSystem& jobs, unsigned int framebuffer, int width, int height, ToneMapper* toneMapper = nullptr);
+};
+
+void PoolOrbit::run(const BenchmarkPool& pool, PlanarReflections& reflections, SceneResources& resources, UniformRing& ring,
+    JobSystem& jobs, unsigned int framebuffer, int width, int height, ToneMapper* toneMapper)
+{
+    const int captureFrames[CAPTURES] = { 59, FRAMES - 1, FRAMES + STILL_FRAMES - 1 };
+    const float aspect = static_cast<float>(width) / height;
+    // the pool always reports full coverage; the tunables alone pick the size
+    std::vector<float> coverage(1, 1.0f);
+    FrameDrawLists lists;
+    double gpuSeconds = 0.0, refractionSeconds = 0.0, mainSeconds = 0.0;
+    int capture = 0;
+    for (int frame = 0; frame < FRAMES + STILL_FRAMES; frame++)
+    {
+        CameraState camera = BenchmarkPool::orbit(std::min(frame, FRAMES - 1) * 0.02f);
+
+        glFinish();
+        double start = glfwGetTime();
+        ring.beginFrame();
+        reflections.schedule(coverage);
+        // oblique projections clip the plane passes themselves
+        if (reflections.current().obliqueClip)
+            glDisable(GL_CLIP_DISTANCE0);
+        else
+            glEnable(GL_CLIP_DISTANCE0);
+        resources.planeTextures.clear();
+        resources.planeTextures.push_back({ reflections.reflectionTexture(0), reflections.refractionTexture(0),
+                                            reflections.reflectionDepthTexture(0), reflections.refractionDepthTexture(0) });
+        buildFrameDrawLists(jobs, pool.scene, camera, reflections.current(), aspect, lists, &resources);
+        ring.unmap();
+        if (statistics)
+            statistics->beginFrame();
+        for (size_t i = 0; i < lists.planeCount; i++)
+        {
+            const PlanePassLists& planeLists = lists.planes[i];
+            glm::ivec2 size = reflections.size(planeLists.plane);
+            glViewport(0, 0, size.x, size.y);
+            glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+            glBindFramebuffer(GL_FRAMEBUFFER, reflections.reflectionFramebuffer(planeLists.plane));
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            if (statistics)
+                statistics->begin(ScenePass::Reflection, planeLists.reflection.commands, size.x, size.y);
+            planeLists.reflection.commands.replay();
+            if (statistics)
+                statistics->end();
+
+            glFinish();
+            double refractionStart = glfwGetTime();
+            glBindFramebuffer(GL_FRAMEBUFFER, reflections.refractionFramebuffer(planeLists.plane));
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+            reflections.prepareRefraction(planeLists.plane);
+            if (statistics)
+                statistics->begin(ScenePass::Refraction, planeLists.refraction.commands, size.x, size.y);
+            planeLists.refraction.commands.replay();
+            if (statistics)
+                statistics->end();
+            reflections.resolve(planeLists.plane, planeLists.reflection.pass.stableViewProjection(),
+                planeLists.refraction.pass.stableViewProjection(), planeLists.reflection.pass.origin);
+            glFinish();
+            if (frame < FRAMES)
+                refractionSeconds += glfwGetTime() - refractionStart;
+        }
+        glFinish();
+        double mainStart = glfwGetTime();
+        if (toneMapper)
+            toneMapper->beginScene();
+        else
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+            glViewport(0, 0, width, height);
+            glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        }
+        if (statistics)
+            statistics->begin(ScenePass::Main, lists.main.commands, width, height);
+        lists.main.commands.replay();
+        if (statistics)
+            statistics->end();
+        if (toneMapper)
+            toneMapper->present(toneMapper->colorTexture(), framebuffer, width, height);
+        glFinish();
+        if (frame < FRAMES)
+            mainSeconds += glfwGetTime() - mainStart;
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        ring.fence();
+        glFinish();
+        if (frame < FRAMES)
+            gpuSeconds += glfwGetTime() - start;
+
+        if (capture < CAPTURES && frame == captureFrames[capture])
+        {
+            captures[capture].resize(width * height * 4);
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, captures[capture].data());
+            capture++;
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    frameMs = 1000.0 * gpuSeconds / FRAMES;
+    refractionMs = 1000.0 * refractionSeconds / FRAMES;
+    mainMs = 1000.0 * mainSeconds / FRAMES;
+}
+
+// how close a run came to the reference run's images, moving and still
+static void reportOrbitDifference(BenchmarkReport& report, const std::string& section, const std::string& name,
+    const PoolOrbit& reference, const PoolOrbit& orbit)
+{
+    double movingDifference = 0.0, movingPsnr = 0.0, stillDifference, stillPsnr;
+    for (int i = 0; i < 2; i++)
+    {
+        double difference, psnr;
+        compareImages(reference.captures[i], orbit.captures[i], difference, psnr);
+        movingDifference += 0.5 * difference;
+        movingPsnr += 0.5 * psnr;
+    }
+    compareImages(reference.captures[2], orbit.captures[2], stillDifference, stillPsnr);
+    report.add(section, name + "_moving_mean_difference", movingDifference);
+    report.add(section, name + "_moving_psnr", movingPsnr);
+    report.add(section, name + "_still_mean_difference", stillDifference);
+    report.add(section, name + "_still_psnr", stillPsnr);
+}
+
+void benchmarkTemporalReflections(BenchmarkReport& report)
+{
+    const int width = 800, height = 600;
+    BenchmarkPool pool;
+    pool.create();
+
+    Shader waterShader("water.vs", "water.fs");
+    Shader modelShader("basic_shader.vs", "basic_shader.fs");
+    Shader skyShader("sky.vs", "sky.fs");
+    Shader temporalShader("hiz.vs", "temporal.fs");
+    unsigned int programs[] = { waterShader.ID, modelShader.ID, skyShader.ID };
+    for (unsigned int program : programs)
+        bindUniformBlocks(program);
+
+    UniformRing ring(1 << 20);
+    JobSystem jobs(std::max(1u, std::thread::hardware_concurrency()));
+    SceneResources resources;
+    resources.waterProgram = ProgramUniforms(waterShader.ID);
+    resources.modelProgram = ProgramUniforms(modelShader.ID);
+    resources.skyProgram = ProgramUniforms(skyShader.ID);
+    resources.uniforms = &ring;
+    resources.reflectionMode = ReflectionMode::Planar;
+    pool.fill(resources);
+
+    unsigned int renderbuffers[2];
+    unsigned int framebuffer = createBenchmarkFramebuffer(width, height, renderbuffers);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CLIP_DISTANCE0);
+
+    // full coverage is under the threshold of 2 but over its quarter: half size
+    const char* names[] = { "full", "half", "temporal" };
+    const float fullCoverage[] = { 0.0f, 2.0f, 0.0f };
+    PoolOrbit orbits[3];
+    for (int c = 0; c < 3; c++)
+    {
+        PlanarReflections reflections;
+        reflections.Temporal = c == 2;
+        reflections.FullResolutionCoverage = fullCoverage[c];
+        reflections.create(pool.description, width, height, temporalShader.ID);
+        orbits[c].run(pool, reflections, resources, ring, jobs, framebuffer, width, height);
+
+        report.add("temporal_reflections", std::string(names[c]) + "_frame_ms", orbits[c].frameMs);
+        report.add("temporal_reflections", std::string(names[c]) + "_target_bytes", static_cast<double>(reflections.stats().targetBytes));
+        if (c > 0)
+            reportOrbitDifference(report, "temporal_reflections", names[c], orbits[0], orbits[c]);
+    }
+    glDisable(GL_CLIP_DISTANCE0);
+    glDisable(GL_DEPTH_TEST);
+
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(2, renderbuffers);
+    pool.destroy();
+    for (unsigned int program : programs)
+        glDeleteProgram(program);
+    glDeleteProgram(temporalShader.ID);
+}
+
+// checkerboard refraction: the pool orbited with the refraction shaded in full and in a
+// checkerboard; GPU time of the refraction passes and of the reconstruction alone, and how close
+// the reconstructed image comes to the full one
+// -----------------------------------------------------------------------------------------------
+void benchmarkCheckerboardRefraction(BenchmarkReport& report)
+{
+    const int width = 800, height = 600;
+    BenchmarkPool pool;
+    pool.create();
+
+    Shader waterShader("water.vs", "water.fs");
+    Shader modelShader("basic_shader.vs", "basic_shader.fs");
+    Shader skyShader("sky.vs", "sky.fs");
+    Shader checkerboardShader("hiz.vs", "checkerboard.fs");
+    unsigned int programs[] = { waterShader.ID, modelShader.ID, skyShader.ID };
+    for (unsigned int program : programs)
+        bindUniformBlocks(program);
+
+    UniformRing ring(1 << 20);
+    JobSystem jobs(std::max(1u, std::thread::hardware_concurrency()));
+    SceneResources resources;
+    resources.waterProgram = ProgramUniforms(waterShader.ID);
+    resources.modelProgram = ProgramUniforms(modelShader.ID);
+    resources.skyProgram = ProgramUniforms(skyShader.ID);
+    resources.uniforms = &ring;
+    resources.reflectionMode = ReflectionMode::Planar;
+    pool.fill(resources);
+
+    unsigned int renderbuffers[2];
+    unsigned int framebuffer = createBenchmarkFramebuffer(width, height, renderbuffers);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CLIP_DISTANCE0);
+
+    const char* names[] = { "full", "checkerboard" };
+    PoolOrbit orbits[2];
+    for (int c = 0; c < 2; c++)
+    {
+        PlanarReflections reflections;
+        reflections.Temporal = false;
+        reflections.Checkerboard = c == 1;
+        reflections.FullResolutionCoverage = 0.0f;
+        reflections.create(pool.description, width, height, 0, checkerboardShader.ID);
+        orbits[c].run(pool, reflections, resources, ring, jobs, framebuffer, width, height);
+
+        report.add("checkerboard_refraction", std::string(names[c]) + "_frame_ms", orbits[c].frameMs);
+        report.add("checkerboard_refraction", std::string(names[c]) + "_refraction_ms", orbits[c].refractionMs);
+        report.add("checkerboard_refraction", std::string(names[c]) + "_target_bytes", static_cast<double>(reflections.stats().targetBytes));
+        if (c == 0)
+            continue;
+        report.add("checkerboard_refraction", std::string(names[c]) + "_reconstruct_ms", reflections.stats().reconstructMs);
+        reportOrbitDifference(report, "checkerboard_refraction", names[c], orbits[0], orbits[c]);
+    }
+    glDisable(GL_CLIP_DISTANCE0);
+    glDisable(GL_DEPTH_TEST);
+
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(2, renderbuffers);
+    pool.destroy();
+    for (unsigned int program : programs)
+        glDeleteProgram(program);
+    glDeleteProgram(checkerboardShader.ID);
+}
+
+// render targets: the pool orbited with full-size planar targets in each format preset; target
+// memory, an estimate of the bytes a frame moves through the targets, GPU frame time, and how far
+// each preset's image strays from ldr's
+// ---------------------------------------------------------------------------------------------
+static double estimateFrameTraffic(const RenderFormats& formats, size_t planePixels, size_t screenPixels, bool toneMapped)
+{
+    // a pass clears and writes its colour once and clears, tests and writes its depth once; shared
+    // depth saves memory, not traffic
+    double colorBytes = static_cast<double>(formats.colorBytes()), depthBytes = static_cast<double>(formats.depthBytes());
+    double pass = colorBytes * 2.0 + depthBytes * 3.0;
+    double traffic = planePixels * pass * 2.0 + screenPixels * pass;
+    // the water reads reflection colour and depth and refraction colour once per screen pixel
+    traffic += screenPixels * (colorBytes * 2.0 + depthBytes);
+    // tone mapping reads the scene and writes the RGBA8 window
+    if (toneMapped)
+        traffic += screenPixels * (colorBytes + 4.0);
+    return traffic;
+}
+
+void benchmarkRenderTargets(BenchmarkReport& report)
+{
+    const int width = 800, height = 600;
+    BenchmarkPool pool;
+    pool.create();
+
+    Shader waterShader("water.vs", "water.fs");
+    Shader modelShader("basic_shader.vs", "basic_shader.fs");
+    Shader skyShader("sky.vs", "sky.fs");
+    Shader toneMapShader("hiz.vs", "tonemap.fs");
+    unsigned int programs[] = { waterShader.ID, modelShader.ID, skyShader.ID };
+    for (unsigned int program : programs)
+        bindUniformBlocks(program);
+
+    UniformRing ring(1 << 20);
+    JobSystem jobs(std::max(1u, std::thread::hardware_concurrency()));
+    SceneResources resources;
+    resources.waterProgram = ProgramUniforms(waterShader.ID);
+    resources.modelProgram = ProgramUniforms(modelShader.ID);
+    resources.skyProgram = ProgramUniforms(skyShader.ID);
+    resources.uniforms = &ring;
+    resources.reflectionMode = ReflectionMode::Planar;
+    pool.fill(resources);
+
+    unsigned int renderbuffers[2];
+    unsigned int framebuffer = createBenchmarkFramebuffer(width, height, renderbuffers);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CLIP_DISTANCE0);
+
+    const char* presets[] = { "ldr", "hdr", "compact" };
+    PoolOrbit orbits[3];
+    for (int c = 0; c < 3; c++)
+    {
+        RenderFormats formats = RenderFormats::preset(presets[c]);
+        PlanarReflections reflections;
+        reflections.Temporal = false;
+        reflections.FullResolutionCoverage = 0.0f;
+        reflections.Formats = formats;
+        reflections.create(pool.description, width, height);
+        ToneMapper toneMapper;
+        if (formats.hdr())
+            toneMapper.create(width, height, formats, toneMapShader.ID, reflections.sharedDepth());
+        orbits[c].run(pool, reflections, resources, ring, jobs, framebuffer, width, height, formats.hdr() ? &toneMapper : nullptr);
+
+        // ldr draws its main pass into the window, which is not counted
+        size_t pixels = static_cast<size_t>(width) * height;
+        size_t targetBytes = reflections.stats().targetBytes + (formats.hdr() ? toneMapper.targetBytes() : 0);
+        std::string name = presets[c];
+        report.add("render_targets", name + "_target_bytes", static_cast<double>(targetBytes));
+        report.add("render_targets", name + "_traffic_bytes_per_frame", estimateFrameTraffic(formats, pixels, pixels, formats.hdr()));
+        report.add("render_targets", name + "_frame_ms", orbits[c].frameMs);
+        if (c > 0)
+            reportOrbitDifference(report, "render_targets", name, orbits[0], orbits[c]);
+    }
+    glDisable(GL_CLIP_DISTANCE0);
+    glDisable(GL_DEPTH_TEST);
+
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(2, renderbuffers);
+    pool.destroy();
+    for (unsigned int program : programs)
+        glDeleteProgram(program);
+    glDeleteProgram(toneMapShader.ID);
+}
+
+// water depth: the pool orbited with the water shaded flat and with absorption and soft shores from
+// the refraction depth; GPU time of the frame and of the main pass, where water.fs runs, so their
+// difference is what the depth lookups and the extra shading cost, and the refraction depth that
+// can no longer be shared
+// ---------------------------------------------------------------------------------------------
+void benchmarkWaterDepth(BenchmarkReport& report)
+{
+    const int width = 800, height = 600;
+    BenchmarkPool pool;
+    pool.create();
+
+    ShaderVariants variants("");
+    Shader modelShader("basic_shader.vs", "basic_shader.fs");
+    Shader skyShader("sky.vs", "sky.fs");
+    unsigned int programs[] = { modelShader.ID, skyShader.ID };
+    for (unsigned int program : programs)
+        bindUniformBlocks(program);
+
+    UniformRing ring(1 << 20);
+    JobSystem jobs(std::max(1u, std::thread::hardware_concurrency()));
+    SceneResources resources;
+    resources.modelProgram = ProgramUniforms(modelShader.ID);
+    resources.skyProgram = ProgramUniforms(skyShader.ID);
+    resources.uniforms = &ring;
+    resources.reflectionMode = ReflectionMode::Planar;
+    pool.fill(resources);
+
+    unsigned int renderbuffers[2];
+    unsigned int framebuffer = createBenchmarkFramebuffer(width, height, renderbuffers);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CLIP_DISTANCE0);
+
+    // compact shares the refraction depth whenever nothing samples it
+    const char* names[] = { "flat", "depth" };
+    const unsigned int features = FEATURE_DISTORTION | FEATURE_FRESNEL | FEATURE_NORMAL_MAP;
+    PoolOrbit orbits[2];
+    for (int c = 0; c < 2; c++)
+    {
+        resources.waterProgram = variants.get("water.vs", "water.fs", c == 1 ? features | FEATURE_SOFT_EDGES : features);
+        PlanarReflections reflections;
+        reflections.Temporal = false;
+        reflections.FullResolutionCoverage = 0.0f;
+        reflections.Formats = RenderFormats::preset("compact");
+        reflections.RefractionDepthSampled = c == 1;
+        reflections.create(pool.description, width, height);
+        orbits[c].run(pool, reflections, resources, ring, jobs, framebuffer, width, height);
+
+        report.add("water_depth", std::string(names[c]) + "_frame_ms", orbits[c].frameMs);
+        report.add("water_depth", std::string(names[c]) + "_main_ms", orbits[c].mainMs);
+        report.add("water_depth", std::string(names[c]) + "_target_bytes", static_cast<double>(reflections.stats().targetBytes));
+    }
+    report.add("water_depth", "shading_cost_delta_ms", orbits[1].mainMs - orbits[0].mainMs);
+    report.add("water_depth", "frame_cost_delta_ms", orbits[1].frameMs - orbits[0].frameMs);
+    reportOrbitDifference(report, "water_depth", names[1], orbits[0], orbits[1]);
+    glDisable(GL_CLIP_DISTANCE0);
+    glDisable(GL_DEPTH_TEST);
+
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(2, renderbuffers);
+    pool.destroy();
+    for (unsigned int program : programs)
+        glDeleteProgram(program);
+}
+
+// water detail: one water tile filling the target from above, shaded over and over with the even
+// mix of reflection and refraction and with the normal and DuDv layers and Fresnel; GPU time per
+// shaded pixel of each, and what generating the layers costs at startup
+// ---------------------------------------------------------------------------------------------
+void benchmarkWaterDetail(BenchmarkReport& report)
+{
+    const int width = 800, height = 600;
+    const int patternSize = 64;
+    const int REPEATS = 40, RUNS = 5;
+
+    JobSystem jobs(std::max(1u, std::thread::hardware_concurrency()));
+    WaterNormals normals;
+    normals.create(jobs);
+
+    std::vector<unsigned char> checker(patternSize * patternSize * 4);
+    for (int i = 0; i < patternSize * patternSize; i++)
+    {
+        bool odd = ((i % patternSize / 8) + (i / patternSize / 8)) % 2 != 0;
+        checker[i * 4] = checker[i * 4 + 1] = checker[i * 4 + 2] = odd ? 200 : 60;
+        checker[i * 4 + 3] = 255;
+    }
+    std::vector<float> heights(patternSize * patternSize, 0.0f);
+    unsigned int patternTexture = createBenchmarkTexture(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, patternSize, checker.data());
+    unsigned int heightTexture = createBenchmarkTexture(GL_R32F, GL_RED, GL_FLOAT, patternSize, heights.data());
+
+    float square[] = { -0.5f, 0.5f, 0.0f, -0.5f, -0.5f, 0.0f, 0.5f, -0.5f, 0.0f, -0.5f, 0.5f, 0.0f, 0.5f, -0.5f, 0.0f, 0.5f, 0.5f, 0.0f };
+    unsigned int vertexArray, vertexBuffer;
+    glGenVertexArrays(1, &vertexArray);
+    glGenBuffers(1, &vertexBuffer);
+    glBindVertexArray(vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(square), square, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    // no floor under this water
+    ShaderVariants variants("");
+    UniformRing ring(64 * 1024);
+    SceneResources resources;
+    resources.uniforms = &ring;
+    resources.waterVertexArray = vertexArray;
+    resources.planeTextures.push_back({ patternTexture, patternTexture });
+    resources.heightTexture = heightTexture;
+    resources.waterNormalTexture = normals.texture();
+    resources.waterNormalTile = normals.tile();
+    resources.time = 12.5;
+    const ReflectionSchedule reflections = ReflectionSchedule::single(0.0);
+
+    // a tile far wider than the view, seen from straight above
+    SceneState scene;
+    glm::dmat4 model = glm::rotate(glm::dmat4(1.0), glm::radians(90.0), glm::dvec3(1, 0, 0));
+    model = glm::scale(model, glm::dvec3(400.0));
+    scene.waterTransforms.push_back(model);
+    scene.waterBounds.push_back(transformBounds(model, { glm::dvec3(0.0), 0.7072f }));
+    CameraState camera;
+    camera.Position = glm::dvec3(0.0, 3.0, 0.0);
+    camera.Pitch = -89.0f;
+
+    unsigned int renderbuffers[2];
+    unsigned int framebuffer = createBenchmarkFramebuffer(width, height, renderbuffers);
+    glEnable(GL_DEPTH_TEST);
+
+    const char* names[] = { "mix", "detail" };
+    double nsPerPixel[2];
+    for (int c = 0; c < 2; c++)
+    {
+        unsigned int features = c == 1 ? FEATURE_DISTORTION | FEATURE_FRESNEL | FEATURE_NORMAL_MAP : FEATURE_DISTORTION;
+        resources.waterProgram = variants.get("water.vs", "water.fs", features);
+        FrameDrawLists lists;
+        ring.beginFrame();
+        buildFrameDrawLists(jobs, scene, camera, reflections, static_cast<float>(width) / height, lists, &resources);
+        ring.unmap();
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glViewport(0, 0, width, height);
+
+        // the fastest of a few runs, every repeat shading the whole target again
+        double best = 1e30;
+        for (int run = 0; run < RUNS; run++)
+        {
+            glFinish();
+            double start = glfwGetTime();
+            for (int repeat = 0; repeat < REPEATS; repeat++)
+            {
+                glClear(GL_DEPTH_BUFFER_BIT);
+                lists.main.commands.replay();
+            }
+            glFinish();
+            best = std::min(best, glfwGetTime() - start);
+        }
+        ring.fence();
+        nsPerPixel[c] = 1e9 * best / (static_cast<double>(REPEATS) * width * height);
+        report.add("water_detail", std::string(names[c]) + "_ns_per_pixel", nsPerPixel[c]);
+    }
+    report.add("water_detail", "delta_ns_per_pixel", nsPerPixel[1] - nsPerPixel[0]);
+    report.add("water_detail", "generation_ms", normals.generationMs());
+    report.add("water_detail", "texture_bytes", static_cast<double>(normals.byteSize()));
+    glDisable(GL_DEPTH_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(2, renderbuffers);
+    unsigned int textures[] = { patternTexture, heightTexture };
+    glDeleteTextures(2, textures);
+    glDeleteVertexArrays(1, &vertexArray);
+    glDeleteBuffers(1, &vertexBuffer);
+}
+
+// quality presets: the pool orbited with each preset's shader variants and reflection settings;
+// GPU frame time and its main and refraction passes, how far each strays from ultra's image, and
+// what building the variants costs compiled from source and read back from the binary cache
+// ---------------------------------------------------------------------------------------------
+void benchmarkQualityPresets(BenchmarkReport& report)
+{
+    const int width = 800, height = 600;
+    const std::string cacheDirectory = "bench_shadercache";
+    BenchmarkPool pool;
+    pool.create();
+
+    Shader skyShader("sky.vs", "sky.fs");
+    Shader temporalShader("hiz.vs", "temporal.fs");
+    Shader checkerboardShader("hiz.vs", "checkerboard.fs");
+    bindUniformBlocks(skyShader.ID);
+
+    UniformRing ring(1 << 20);
+    JobSystem jobs(std::max(1u, std::thread::hardware_concurrency()));
+    WaterNormals normals;
+    normals.create(jobs);
+    SceneResources resources;
+    resources.skyProgram = ProgramUniforms(skyShader.ID);
+    resources.uniforms = &ring;
+    resources.reflectionMode = ReflectionMode::Planar;
+    resources.waterNormalTexture = normals.texture();
+    resources.waterNormalTile = normals.tile();
+    pool.fill(resources);
+
+    unsigned int renderbuffers[2];
+    unsigned int framebuffer = createBenchmarkFramebuffer(width, height, renderbuffers);
+    glEnable(GL_DEPTH_TEST);
+
+    // ultra last, the reference
+    ShaderVariants variants(cacheDirectory);
+    PoolOrbit orbits[QualityPreset::COUNT];
+    for (int c = QualityPreset::COUNT - 1; c >= 0; c--)
+    {
+        QualityPreset quality = QualityPreset::preset(QualityPreset::NAMES[c]);
+        resources.waterProgram = variants.get("water.vs", "water.fs", quality.features);
+        resources.modelProgram = variants.get("basic_shader.vs", "basic_shader.fs", quality.features & FEATURE_OBLIQUE_CLIP);
+        PlanarReflections reflections;
+        reflections.Temporal = quality.temporal;
+        reflections.Checkerboard = quality.checkerboard;
+        reflections.RefractionDepthSampled = (quality.features & FEATURE_SOFT_EDGES) != 0;
+        reflections.ObliqueClip = (quality.features & FEATURE_OBLIQUE_CLIP) != 0;
+        reflections.FullResolutionCoverage = 0.0f;
+        reflections.create(pool.description, width, height, temporalShader.ID, checkerboardShader.ID);
+        orbits[c].run(pool, reflections, resources, ring, jobs, framebuffer, width, height);
+
+        std::string name = quality.name;
+        report.add("quality_presets", name + "_frame_ms", orbits[c].frameMs);
+        report.add("quality_presets", name + "_main_ms", orbits[c].mainMs);
+        report.add("quality_presets", name + "_refraction_ms", orbits[c].refractionMs);
+        if (c < QualityPreset::COUNT - 1)
+            reportOrbitDifference(report, "quality_presets", name, orbits[QualityPreset::COUNT - 1], orbits[c]);
+    }
+    glDisable(GL_CLIP_DISTANCE0);
+    glDisable(GL_DEPTH_TEST);
+
+    // every variant the presets used once more: from source, then from the binaries written above
+    ShaderVariants uncached(""), cached(cacheDirectory);
+    for (int c = 0; c < QualityPreset::COUNT; c++)
+    {
+        unsigned int features = QualityPreset::preset(QualityPreset::NAMES[c]).features;
+        for (ShaderVariants* set : { &uncached, &cached })
+        {
+            set->get("water.vs", "water.fs", features);
+            set->get("basic_shader.vs", "basic_shader.fs", features & FEATURE_OBLIQUE_CLIP);
+        }
+    }
+    report.add("quality_presets", "variants", uncached.compiledCount());
+    report.add("quality_presets", "compile_ms", uncached.buildMs());
+    report.add("quality_presets", "cache_hits", cached.cachedCount());
+    report.add("quality_presets", "cached_build_ms", cached.buildMs());
+
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(2, renderbuffers);
+    pool.destroy();
+    glDeleteProgram(skyShader.ID);
+    glDeleteProgram(temporalShader.ID);
+    glDeleteProgram(checkerboardShader.ID);
+}
+
+// environment map: a finely checkered sky prefiltered on the GPU, then read back from the cache it
+// wrote; how long each takes and how much of the checker's contrast survives down the mips
+// ---------------------------------------------------------------------------------------------
+static double faceContrast(int level, int size)
+{
+    // standard deviation of the +X face's luminance at one level
+    std::vector<float> texels(size * size * 3);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X, level, GL_RGB, GL_FLOAT, texels.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    double sum = 0.0, squares = 0.0;
+    for (int i = 0; i < size * size; i++)
+    {
+        double luminance = 0.2126 * texels[i * 3] + 0.7152 * texels[i * 3 + 1] + 0.0722 * texels[i * 3 + 2];
+        sum += luminance;
+        squares += luminance * luminance;
+    }
+    double mean = sum / (size * size);
+    return std::sqrt(std::max(squares / (size * size) - mean * mean, 0.0));
+}
+
+void benchmarkEnvironmentMap(BenchmarkReport& report)
+{
+    const int size = 256;
+    const std::string cachePath = "bench_environment.ggx";
+    const std::string faces[6];
+    std::remove(cachePath.c_str());
+
+    unsigned int source;
+    glGenTextures(1, &source);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, source);
+    std::vector<unsigned char> pixels(size * size * 3);
+    for (int face = 0; face < 6; face++)
+    {
+        for (int y = 0; y < size; y++)
+        {
+            for (int x = 0; x < size; x++)
+            {
+                bool odd = ((x / 4) + (y / 4)) % 2 != 0;
+                unsigned char* texel = &pixels[(y * size + x) * 3];
+                texel[0] = texel[1] = texel[2] = odd ? 240 : 20;
+            }
+        }
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGB, size, size, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+    }
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    Shader prefilterShader("prefilter.vs", "prefilter.fs");
+    double seconds[2];
+    bool fromCache[2];
+    double contrast[EnvironmentMap::LEVELS];
+    for (int run = 0; run < 2; run++)
+    {
+        // the first run prefilters and writes the cache, the second only reads it
+        EnvironmentMap environment;
+        glFinish();
+        double start = glfwGetTime();
+        environment.create(source, faces, prefilterShader.ID, cachePath);
+        glFinish();
+        seconds[run] = glfwGetTime() - start;
+        fromCache[run] = environment.fromCache();
+        if (run == 1)
+        {
+            glBindTexture(GL_TEXTURE_CUBE_MAP, environment.texture());
+            for (int level = 0; level < EnvironmentMap::LEVELS; level++)
+                contrast[level] = faceContrast(level, EnvironmentMap::FACE_SIZE >> level);
+            report.add("environment_map", "cache_bytes", static_cast<double>(environment.byteSize()));
+            report.add("environment_map", "samples_per_texel", environment.SampleCount);
+        }
+    }
+    std::remove(cachePath.c_str());
+
+    report.add("environment_map", "levels", EnvironmentMap::LEVELS);
+    report.add("environment_map", "prefilter_ms", 1000.0 * seconds[0]);
+    report.add("environment_map", "cache_read_ms", 1000.0 * seconds[1]);
+    report.add("environment_map", "cache_hit", fromCache[1] && !fromCache[0] ? 1.0 : 0.0);
+    for (int level = 0; level < EnvironmentMap::LEVELS; level++)
+        report.add("environment_map", "level" + std::to_string(level) + "_contrast", contrast[level]);
+
+    glDeleteTextures(1, &source);
+    glDeleteProgram(prefilterShader.ID);
+}
+
+// frame stats: cost of recording a frame, how far the histogram's percentiles are from sorting the
+// window, whether injected hitches come out as stutters, and the overlay's one draw
+// ----------------------------------------------------------------------------------------------
+void benchmarkFrameStats(BenchmarkReport& report)
+{
+    const int frames = 1000000;
+    std::unique_ptr<FrameStats> stats(new FrameStats());
+    // 60 Hz with jitter, a hitch of 2.5 to 4 frames every 97, the odd long load
+    std::vector<double> times(frames);
+    std::mt19937 random(7);
+    std::normal_distribution<double> jitter(1.0 / 60.0, 0.0015);
+    std::uniform_real_distribution<double> hitch(2.5, 4.0);
+    for (int i = 0; i < frames; i++)
+    {
+        times[i] = std::max(jitter(random), 0.001);
+        if (i % 97 == 0)
+            times[i] *= hitch(random);
+        if (i % 100003 == 0)
+            times[i] = 0.5;
+    }
+
+    double start = glfwGetTime();
+    for (int i = 0; i < frames; i++)
+        stats->record(times[i]);
+    double recordSeconds = glfwGetTime() - start;
+
+    const int summaries = 1000;
+    FrameStats::Summary window;
+    start = glfwGetTime();
+    for (int i = 0; i < summaries; i++)
+        window = stats->window();
+    double summarySeconds = glfwGetTime() - start;
+    FrameStats::Summary total = stats->total();
+
+    // the window sorted, and its hitches judged against its exact median
+    std::vector<double> recent(times.end() - FrameStats::WINDOW, times.end());
+    std::sort(recent.begin(), recent.end());
+    auto exact = [&](double fraction) { return 1000.0 * recent[static_cast<size_t>(fraction * (recent.size() - 1))]; };
+    double worstError = 0.0;
+    const double fractions[] = { 0.5, 0.95, 0.99 };
+    const double measured[] = { window.p50Ms, window.p95Ms, window.p99Ms };
+    for (int i = 0; i < 3; i++)
+        worstError = std::max(worstError, std::abs(measured[i] - exact(fractions[i])) / exact(fractions[i]));
+    int hitches = 0, flagged = 0;
+    for (int i = 0; i < FrameStats::WINDOW; i++)
+    {
+        hitches += 1000.0 * times[frames - 1 - i] > stats->StutterFactor * exact(0.5) ? 1 : 0;
+        flagged += stats->recentStutter(i) ? 1 : 0;
+    }
+
+    report.add("frame_stats", "frames", frames);
+    report.add("frame_stats", "record_ns", 1.0e9 * recordSeconds / frames);
+    report.add("frame_stats", "window_summary_us", 1.0e6 * summarySeconds / summaries);
+    report.add("frame_stats", "bytes", static_cast<double>(sizeof(FrameStats)));
+    report.add("frame_stats", "window_p50_ms", window.p50Ms);
+    report.add("frame_stats", "window_p99_ms", window.p99Ms);
+    report.add("frame_stats", "window_max_ms", window.maxMs);
+    report.add("frame_stats", "percentile_worst_relative_error", worstError);
+    report.add("frame_stats", "window_hitches", hitches);
+    report.add("frame_stats", "window_stutters", flagged);
+    report.add("frame_stats", "total_stutters", static_cast<double>(total.stutters));
+    report.add("frame_stats", "total_max_ms", total.maxMs);
+
+    // the overlay over a blank frame
+    Shader hudShader("hud.vs", "hud.fs");
+    const float quad[] = { 0.0f, 0.0f, 0.0f, 0.0f,  0.0f, 0.0f, 0.0f, 1.0f,  0.0f, 0.0f, 1.0f, 1.0f,
+                           0.0f, 0.0f, 0.0f, 0.0f,  0.0f, 0.0f, 1.0f, 1.0f,  0.0f, 0.0f, 1.0f, 0.0f };
+    unsigned int quadVertexArray, quadBuffer;
+    glGenVertexArrays(1, &quadVertexArray);
+    glGenBuffers(1, &quadBuffer);
+    glBindVertexArray(quadVertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+    glBindVertexArray(0);
+    {
+        FrameStatsHud hud;
+        hud.create(hudShader.ID, quadVertexArray);
+        const int draws = 200;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, 1280, 720);
+        glFinish();
+        start = glfwGetTime();
+        for (int i = 0; i < draws; i++)
+            hud.draw(*stats, 1280, 720);
+        glFinish();
+        report.add("frame_stats", "hud_draw_ms", 1000.0 * (glfwGetTime() - start) / draws);
+        report.add("frame_stats", "hud_instances", hud.instanceCount());
+    }
+    glDeleteVertexArrays(1, &quadVertexArray);
+    glDeleteBuffers(1, &quadBuffer);
+    glDeleteProgram(hudShader.ID);
+}
+
+// pipeline statistics: what each scene pass of the pool orbit submits and, with
+// ARB_pipeline_statistics_query, what the GPU made of it, read from the still frames at the end;
+// fragments per pixel is the pass's overdraw. And what bracketing every pass costs.
+// ---------------------------------------------------------------------------------------------
+void benchmarkPipelineStatistics(BenchmarkReport& report)
+{
+    const int width = 800, height = 600;
+    BenchmarkPool pool;
+    pool.create();
+
+    ShaderVariants variants("");
+    Shader modelShader("basic_shader.vs", "basic_shader.fs");
+    Shader skyShader("sky.vs", "sky.fs");
+    unsigned int programs[] = { modelShader.ID, skyShader.ID };
+    for (unsigned int program : programs)
+        bindUniformBlocks(program);
+
+    UniformRing ring(1 << 20);
+    JobSystem jobs(std::max(1u, std::thread::hardware_concurrency()));
+    SceneResources resources;
+    resources.modelProgram = ProgramUniforms(modelShader.ID);
+    resources.skyProgram = ProgramUniforms(skyShader.ID);
+    resources.waterProgram = variants.get("water.vs", "water.fs", QualityPreset::preset("high").features);
+    resources.uniforms = &ring;
+    resources.reflectionMode = ReflectionMode::Planar;
+    pool.fill(resources);
+
+    unsigned int renderbuffers[2];
+    unsigned int framebuffer = createBenchmarkFramebuffer(width, height, renderbuffers);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CLIP_DISTANCE0);
+
+    PipelineStatistics statistics;
+    statistics.create();
+    PoolOrbit orbits[2];
+    for (int c = 0; c < 2; c++)
+    {
+        PlanarReflections reflections;
+        reflections.Temporal = false;
+        reflections.FullResolutionCoverage = 0.0f;
+        reflections.create(pool.description, width, height);
+        orbits[c].statistics = c == 1 ? &statistics : nullptr;
+        orbits[c].run(pool, reflections, resources, ring, jobs, framebuffer, width, height);
+    }
+
+    report.add("pipeline_statistics", "hardware_counters", statistics.hardware() ? 1.0 : 0.0);
+    for (int i = 0; i < SCENE_PASS_COUNT; i++)
+    {
+        const PassStatistics& pass = statistics.pass(static_cast<ScenePass>(i));
+        std::string name = PipelineStatistics::PASS_NAMES[i];
+        report.add("pipeline_statistics", name + "_draws", static_cast<double>(pass.draws));
+        report.add("pipeline_statistics", name + "_triangles", static_cast<double>(pass.triangles));
+        report.add("pipeline_statistics", name + "_indices", static_cast<double>(pass.indices));
+        if (!statistics.hardware())
+            continue;
+        report.add("pipeline_statistics", name + "_primitives", static_cast<double>(pass.primitives));
+        report.add("pipeline_statistics", name + "_clipped_primitives", static_cast<double>(pass.clippedPrimitives));
+        report.add("pipeline_statistics", name + "_vertex_invocations", static_cast<double>(pass.vertexInvocations));
+        report.add("pipeline_statistics", name + "_fragment_invocations", static_cast<double>(pass.fragmentInvocations));
+        report.add("pipeline_statistics", name + "_fragments_per_pixel", pass.overdraw());
+    }
+    report.add("pipeline_statistics", "frame_ms", orbits[0].frameMs);
+    report.add("pipeline_statistics", "overhead_delta_ms", orbits[1].frameMs - orbits[0].frameMs);
+    glDisable(GL_CLIP_DISTANCE0);
+    glDisable(GL_DEPTH_TEST);
+
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(2, renderbuffers);
+    pool.destroy();
+    for (unsigned int program : programs)
+        glDeleteProgram(program);
+}
@@ -0,0 +1,55 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Collects named metrics from the headless benchmark (Water --benchmark [report.json])
+// and writes them out as a JSON report grouped by section.
+// ------------------------------------------------------------------------------------
+class BenchmarkReport
+{
+public:
+    struct Entry
+    {
+        std::string section;
+        std::string metric;
+        double value;
+    };
+
+    void add(const std::string& section, const std::string& metric, double value);
+    const std::vector<Entry>& metrics() const { return entries; }
+
+    void print(std::ostream& out) const;
+    bool writeJson(const std::string& path) const;
+    // a report writeJson wrote, replacing what this one held
+    bool readJson(const std::string& path);
+
+private:
+    std::vector<Entry> entries;
+};
+
+// individual benchmarks, each expects a current GL context
+void benchmarkWaterSim(BenchmarkReport& report);
+void benchmarkHeightReadback(BenchmarkReport& report);
+void benchmarkJobSystem(BenchmarkReport& report);
+void benchmarkCommandList(BenchmarkReport& report);
+void benchmarkUniformRing(BenchmarkReport& report);
+void benchmarkSceneGraph(BenchmarkReport& report);
+void benchmarkTerrain(BenchmarkReport& report);
+void benchmarkOriginRebasing(BenchmarkReport& report);
+void benchmarkOcean(BenchmarkReport& report);
+void benchmarkPlanarReflections(BenchmarkReport& report);
+void benchmarkScreenSpaceReflections(BenchmarkReport& report);
+void benchmarkTemporalReflections(BenchmarkReport& report);
+void benchmarkCheckerboardRefraction(BenchmarkReport& report);
+void benchmarkRenderTargets(BenchmarkReport& report);
+void benchmarkWaterDepth(BenchmarkReport& report);
+void benchmarkWaterDetail(BenchmarkReport& report);
+void benchmarkQualityPresets(BenchmarkReport& report);
+void benchmarkEnvironmentMap(BenchmarkReport& report);
+void benchmarkFrameStats(BenchmarkReport& report);
+void benchmarkPipelineStatistics(BenchmarkReport& report);
+
+#endif
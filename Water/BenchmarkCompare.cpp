@@ -0,0 +1,307 @@
+#include "BenchmarkCompare.h"
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <sstream>
+
+// the same reports give the same intervals
+static const unsigned int RANDOM_SEED = 5489u;
+
+enum class MetricKind { Other, Time, Rate, Delta };
+
+// what a metric measures, from its name: a time when one of its words is a unit (frame_ms,
+// ms_per_step, record_ns), a rate when the unit follows "per" (commands_per_ms,
+// cell_updates_per_sec); toMs scales a time to milliseconds. A delta (frame_cost_delta_ms) is the
+// difference of two timings of one run, near zero or even negative: shown, never compared
+static MetricKind metricKind(const std::string& metric, double& toMs)
+{
+    std::vector<std::string> words;
+    std::istringstream parts(metric);
+    std::string word;
+    while (std::getline(parts, word, '_'))
+        words.push_back(word);
+    if (std::find(words.begin(), words.end(), "delta") != words.end())
+        return MetricKind::Delta;
+    for (size_t i = 0; i < words.size(); i++)
+    {
+        double scale = words[i] == "sec" ? 1000.0 : words[i] == "ms" ? 1.0 : words[i] == "us" ? 1.0e-3 : words[i] == "ns" ? 1.0e-6 : 0.0;
+        if (scale == 0.0)
+            continue;
+        if (i > 0 && words[i - 1] == "per")
+            return MetricKind::Rate;
+        toMs = scale;
+        return MetricKind::Time;
+    }
+    return MetricKind::Other;
+}
+
+static double average(const std::vector<double>& values)
+{
+    double sum = 0.0;
+    for (double value : values)
+        sum += value;
+    return values.empty() ? 0.0 : sum / values.size();
+}
+
+// per-run sums of the rows in ms, over the newest runs all of them have
+static std::vector<double> runTotals(const std::vector<const std::vector<double>*>& rows, const std::vector<double>& scales)
+{
+    size_t runs = rows.empty() ? 0 : rows[0]->size();
+    for (const std::vector<double>* row : rows)
+        runs = std::min(runs, row->size());
+    std::vector<double> totals(runs, 0.0);
+    for (size_t r = 0; r < rows.size(); r++)
+    {
+        const std::vector<double>& row = *rows[r];
+        for (size_t j = 0; j < runs; j++)
+            totals[j] += row[row.size() - runs + j] * scales[r];
+    }
+    return totals;
+}
+
+// comparison
+// ----------
+int BenchmarkComparison::run(const std::string& baselinePath, const std::string& candidatePath, std::ostream& out)
+{
+    BenchmarkReport baseline, candidate;
+    if (!baseline.readJson(baselinePath) || !candidate.readJson(candidatePath))
+        return 2;
+
+    History history;
+    if (!HistoryPath.empty())
+        loadHistory(history);
+    addRun(history, baseline);
+    if (!HistoryPath.empty())
+        saveHistory(history);
+
+    std::set<std::string> inBaseline, seen;
+    for (const BenchmarkReport::Entry& e : baseline.metrics())
+        inBaseline.insert(e.section + "/" + e.metric);
+
+    random.seed(RANDOM_SEED);
+    improved = 0;
+    int compared = 0, regressed = 0;
+    size_t baselineRuns = 0;
+
+    // each section's timings add up to its total, and all of them to the overall one
+    std::vector<const std::vector<double>*> sectionRows, allRows;
+    std::vector<double> sectionScales, allScales;
+    double sectionCandidate = 0.0, allCandidate = 0.0;
+    auto total = [&](const std::string& name, const std::vector<const std::vector<double>*>& rows, const std::vector<double>& scales, double candidateMs)
+    {
+        std::vector<double> totals = runTotals(rows, scales);
+        if (rows.size() < 2 || totals.empty() || average(totals) < FloorMs)
+            return;
+        compared++;
+        if (judge(out, name, totals, candidateMs, average(totals), candidateMs))
+            regressed++;
+    };
+
+    std::string section;
+    for (const BenchmarkReport::Entry& e : candidate.metrics())
+    {
+        if (e.section != section)
+        {
+            total("total_ms", sectionRows, sectionScales, sectionCandidate);
+            sectionRows.clear();
+            sectionScales.clear();
+            sectionCandidate = 0.0;
+            section = e.section;
+            out << "[" << section << "]" << std::endl;
+        }
+        std::string name = e.section + "/" + e.metric;
+        if (!seen.insert(name).second)
+            continue;
+        if (!inBaseline.count(name))
+        {
+            out << "  " << std::left << std::setw(40) << e.metric << " new" << std::endl;
+            continue;
+        }
+
+        const std::vector<double>& runs = history[name];
+        double baselineMean = average(runs);
+        double toMs = 1.0;
+        MetricKind kind = metricKind(e.metric, toMs);
+        if (kind == MetricKind::Rate && (e.value <= 0.0 || *std::min_element(runs.begin(), runs.end()) <= 0.0))
+            kind = MetricKind::Other;
+        if (kind == MetricKind::Delta)
+        {
+            // what it costs is in the timings it was taken from
+            out << "  " << std::left << std::setw(40) << e.metric << " " << baselineMean << " -> " << e.value << "  delta, not judged" << std::endl;
+            continue;
+        }
+        if (kind == MetricKind::Other)
+        {
+            // counts and sizes: worth a look when they move, not a failure
+            if (std::abs(e.value - baselineMean) > std::abs(baselineMean) * ThresholdPercent / 100.0)
+                out << "  " << std::left << std::setw(40) << e.metric << " " << baselineMean << " -> " << e.value << "  changed" << std::endl;
+            continue;
+        }
+        if (kind == MetricKind::Time && baselineMean * toMs < FloorMs)
+        {
+            out << "  " << std::left << std::setw(40) << e.metric << " " << baselineMean << " -> " << e.value << "  below the floor" << std::endl;
+            continue;
+        }
+
+        // a rate is compared as what it costs, so that positive is slower throughout
+        std::vector<double> costs = runs;
+        double candidateCost = e.value;
+        if (kind == MetricKind::Rate)
+        {
+            for (double& cost : costs)
+                cost = 1.0 / cost;
+            candidateCost = 1.0 / e.value;
+        }
+        compared++;
+        baselineRuns = std::max(baselineRuns, runs.size());
+        if (judge(out, e.metric, costs, candidateCost, baselineMean, e.value))
+            regressed++;
+
+        if (kind == MetricKind::Time)
+        {
+            sectionRows.push_back(&runs);
+            sectionScales.push_back(toMs);
+            sectionCandidate += e.value * toMs;
+            allRows.push_back(&runs);
+            allScales.push_back(toMs);
+            allCandidate += e.value * toMs;
+        }
+    }
+    total("total_ms", sectionRows, sectionScales, sectionCandidate);
+    out << "[all]" << std::endl;
+    total("total_ms", allRows, allScales, allCandidate);
+
+    for (const BenchmarkReport::Entry& e : baseline.metrics())
+    {
+        if (!seen.count(e.section + "/" + e.metric))
+            out << "  " << e.section << "/" << e.metric << " missing from the candidate" << std::endl;
+    }
+    out << compared << " metrics compared against up to " << baselineRuns << " baseline runs: " << regressed
+        << " regressed past " << ThresholdPercent << "%, " << improved << " improved" << std::endl;
+    return regressed > 0 ? 1 : 0;
+}
+
+bool BenchmarkComparison::judge(std::ostream& out, const std::string& name, const std::vector<double>& costs, double candidateCost,
+    double shownBaseline, double shownCandidate)
+{
+    Interval interval = bootstrap(costs, candidateCost);
+    bool regressed = interval.low > ThresholdPercent;
+    const char* verdict = "";
+    if (regressed)
+        verdict = "  REGRESSED";
+    else if (interval.high < -ThresholdPercent)
+    {
+        verdict = "  improved";
+        improved++;
+    }
+    char change[96];
+    std::snprintf(change, sizeof(change), "%+.1f%% [%+.1f%%, %+.1f%%] over %d runs", interval.delta, interval.low, interval.high, static_cast<int>(costs.size()));
+    out << "  " << std::left << std::setw(40) << name << " " << shownBaseline << " -> " << shownCandidate << "  " << change << verdict << std::endl;
+    return regressed;
+}
+
+// percent change of the candidate over the mean of the baseline runs, with a percentile bootstrap
+// interval: each resample draws the runs again, and since the candidate is a single run as noisy
+// as they are it is moved by one of their deviations from the mean
+BenchmarkComparison::Interval BenchmarkComparison::bootstrap(const std::vector<double>& costs, double candidateCost)
+{
+    double mean = average(costs);
+    Interval interval;
+    interval.delta = interval.low = interval.high = 100.0 * (candidateCost - mean) / mean;
+    if (costs.size() < 2 || Resamples < 1)
+        return interval;
+
+    std::uniform_int_distribution<size_t> pick(0, costs.size() - 1);
+    std::vector<double> deltas(Resamples);
+    for (double& delta : deltas)
+    {
+        double sum = 0.0;
+        for (size_t i = 0; i < costs.size(); i++)
+            sum += costs[pick(random)];
+        double resampled = sum / costs.size();
+        double noisy = candidateCost + costs[pick(random)] - mean;
+        delta = 100.0 * (noisy - resampled) / resampled;
+    }
+    std::sort(deltas.begin(), deltas.end());
+    double tail = (1.0 - Confidence) / 2.0;
+    interval.low = deltas[static_cast<size_t>(tail * (deltas.size() - 1))];
+    interval.high = deltas[static_cast<size_t>(std::ceil((1.0 - tail) * (deltas.size() - 1)))];
+    return interval;
+}
+
+// history
+// -------
+// a line per metric: "section/metric" and its runs oldest first, tab separated
+bool BenchmarkComparison::loadHistory(History& history) const
+{
+    std::ifstream in(HistoryPath);
+    if (!in)
+        return false;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::istringstream fields(line);
+        std::string name, value;
+        if (!std::getline(fields, name, '\t') || name.empty())
+            continue;
+        std::vector<double>& runs = history[name];
+        while (std::getline(fields, value, '\t'))
+            runs.push_back(std::atof(value.c_str()));
+    }
+    return true;
+}
+
+void BenchmarkComparison::saveHistory(const History& history) const
+{
+    std::ofstream out(HistoryPath);
+    if (!out)
+    {
+        std::cout << "ERROR::BENCHMARK:: could not write history to " << HistoryPath << std::endl;
+        return;
+    }
+    out << std::setprecision(9);
+    for (const auto& row : history)
+    {
+        out << row.first;
+        for (double value : row.second)
+            out << '\t' << value;
+        out << '\n';
+    }
+}
+
+void BenchmarkComparison::addRun(History& history, const BenchmarkReport& baseline) const
+{
+    std::map<std::string, double> values;
+    for (const BenchmarkReport::Entry& e : baseline.metrics())
+        values[e.section + "/" + e.metric] = e.value;
+
+    // the same baseline report compared again is not another run
+    bool repeated = !history.empty();
+    for (const auto& value : values)
+    {
+        History::const_iterator row = history.find(value.first);
+        if (row == history.end() || row->second.empty() || row->second.back() != value.second)
+        {
+            repeated = false;
+            break;
+        }
+    }
+    if (repeated)
+        return;
+
+    size_t keep = KeepRuns > 1 ? static_cast<size_t>(KeepRuns) : 1;
+    for (const auto& value : values)
+    {
+        std::vector<double>& runs = history[value.first];
+        runs.push_back(value.second);
+        if (runs.size() > keep)
+            runs.erase(runs.begin(), runs.end() - keep);
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef BENCHMARK_COMPARE_H
+#define BENCHMARK_COMPARE_H
+
+#include <map>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+class BenchmarkReport;
+
+// Compares a candidate benchmark report against a baseline one, Water --compare baseline.json
+// candidate.json, for CI to gate on. Every timing in the candidate (frame_ms, ms_per_step,
+// record_ns ...) and every rate (commands_per_ms ...) is set against the baseline's, and each
+// section's timings and all of them together as totals. One run of a shared llvmpipe runner says
+// little, so the baseline's runs are kept in a rolling history file, a line per metric with its
+// last KeepRuns values: each comparison adds the baseline report there and measures the candidate
+// against the mean of those runs, with a bootstrap interval drawn from their spread. A metric
+// counts as regressed only when the whole interval lies past ThresholdPercent; run() then returns
+// 1. Counts and sizes are listed when they changed but never fail, and deltas (*_delta_ms), the
+// differences of two timings, are listed but neither judged nor added to the totals.
+// ----------------------------------------------------------------------------------------------
+class BenchmarkComparison
+{
+public:
+    double ThresholdPercent = 10.0;     // slower than this, confidently, fails
+    double FloorMs = 0.05;              // timings below this are all noise, they are shown only
+    double Confidence = 0.95;
+    int Resamples = 2000;
+    int KeepRuns = 20;                  // baseline runs the history holds per metric
+    std::string HistoryPath = "bench_history.tsv";     // empty keeps none
+
+    // 0 when nothing regressed, 1 when something did, 2 when a report could not be read
+    int run(const std::string& baselinePath, const std::string& candidatePath, std::ostream& out);
+
+private:
+    struct Interval
+    {
+        double delta = 0.0;     // percent, positive is slower
+        double low = 0.0, high = 0.0;
+    };
+    // a line per metric, "section/metric" to its values oldest first
+    typedef std::map<std::string, std::vector<double>> History;
+
+    bool loadHistory(History& history) const;
+    void saveHistory(const History& history) const;
+    void addRun(History& history, const BenchmarkReport& baseline) const;
+    Interval bootstrap(const std::vector<double>& costs, double candidateCost);
+    // prints the line, true if it regressed
+    bool judge(std::ostream& out, const std::string& name, const std::vector<double>& costs, double candidateCost,
+        double shownBaseline, double shownCandidate);
+
+    std::mt19937 random;
+    int improved = 0;
+};
+
+#endif
@@ -0,0 +1,307 @@
+#include "CommandList.h"
+
+#include <glad/glad.h>
+
+#include <cstring>
+
+static const size_t NO_BLOCK = static_cast<size_t>(-1);
+static const unsigned int UNKNOWN = ~0u;
+
+// program uniforms
+// ----------------
+ProgramUniforms::ProgramUniforms(unsigned int program)
+    : id(program)
+{
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<char> name(static_cast<size_t>(maxLength) + 1);
+    for (GLint i = 0; i < count; i++)
+    {
+        GLint size;
+        GLenum type;
+        GLsizei length = 0;
+        glGetActiveUniform(program, i, static_cast<GLsizei>(name.size()), &length, &size, &type, name.data());
+        std::string uniform(name.data(), length);
+        int location = glGetUniformLocation(program, uniform.c_str());
+        if (location < 0)
+            continue;    // block members
+        locations[uniform] = location;
+        // arrays are reported as "name[0]", also accept the bare name
+        size_t bracket = uniform.find("[0]");
+        if (bracket != std::string::npos && bracket + 3 == uniform.size())
+            locations[uniform.substr(0, bracket)] = location;
+    }
+}
+
+int ProgramUniforms::location(const std::string& name) const
+{
+    auto it = locations.find(name);
+    return it == locations.end() ? -1 : it->second;
+}
+
+// recording
+// ---------
+CommandList::CommandList()
+{
+    clear();
+}
+
+void CommandList::clear()
+{
+    stream.clear();
+    commands = 0;
+    draws = 0;
+    indices = 0;
+    openUniforms = NO_BLOCK;
+    boundProgram = UNKNOWN;
+    boundVertexArray = UNKNOWN;
+    for (unsigned int& texture : boundTextures)
+        texture = UNKNOWN;
+    depthFunc = -1;
+}
+
+unsigned char* CommandList::begin(Type type, size_t payload)
+{
+    openUniforms = NO_BLOCK;
+    size_t offset = stream.size();
+    Header header = { type, static_cast<uint32_t>(sizeof(Header) + payload) };
+    stream.resize(offset + header.size);
+    std::memcpy(&stream[offset], &header, sizeof(Header));
+    commands++;
+    return &stream[offset + sizeof(Header)];
+}
+
+void CommandList::bindProgram(unsigned int program)
+{
+    if (program == boundProgram)
+        return;
+    boundProgram = program;
+    uint32_t value = program;
+    std::memcpy(begin(Type::BindProgram, sizeof(value)), &value, sizeof(value));
+}
+
+void CommandList::bindVertexArray(unsigned int vertexArray)
+{
+    if (vertexArray == boundVertexArray)
+        return;
+    boundVertexArray = vertexArray;
+    uint32_t value = vertexArray;
+    std::memcpy(begin(Type::BindVertexArray, sizeof(value)), &value, sizeof(value));
+}
+
+void CommandList::bindTexture(unsigned int unit, TextureTarget target, unsigned int texture)
+{
+    if (unit < MAX_TEXTURE_UNITS)
+    {
+        if (boundTextures[unit] == texture)
+            return;
+        boundTextures[unit] = texture;
+    }
+    uint32_t values[3] = { unit, static_cast<uint32_t>(target), texture };
+    std::memcpy(begin(Type::BindTexture, sizeof(values)), values, sizeof(values));
+}
+
+void CommandList::setDepthFunc(DepthFunc func)
+{
+    if (depthFunc == static_cast<int>(func))
+        return;
+    depthFunc = static_cast<int>(func);
+    uint32_t value = static_cast<uint32_t>(func);
+    std::memcpy(begin(Type::DepthFunc, sizeof(value)), &value, sizeof(value));
+}
+
+void CommandList::bindUniformRange(unsigned int binding, unsigned int buffer, size_t offset, size_t size)
+{
+    uint32_t values[4] = { binding, buffer, static_cast<uint32_t>(offset), static_cast<uint32_t>(size) };
+    std::memcpy(begin(Type::UniformRange, sizeof(values)), values, sizeof(values));
+}
+
+void CommandList::setUniform(int location, UniformType type, const void* data, size_t size)
+{
+    if (location < 0)
+        return;
+    // keep extending the open block, or start a new one
+    if (openUniforms == NO_BLOCK)
+    {
+        begin(Type::Uniforms, 0);
+        openUniforms = stream.size() - sizeof(Header);
+    }
+    UniformEntry entry = { location, type };
+    size_t offset = stream.size();
+    stream.resize(offset + sizeof(entry) + size);
+    std::memcpy(&stream[offset], &entry, sizeof(entry));
+    std::memcpy(&stream[offset + sizeof(entry)], data, size);
+
+    Header header;
+    std::memcpy(&header, &stream[openUniforms], sizeof(Header));
+    header.size += static_cast<uint32_t>(sizeof(entry) + size);
+    std::memcpy(&stream[openUniforms], &header, sizeof(Header));
+}
+
+void CommandList::setInt(int location, int value)
+{
+    setUniform(location, UniformType::Int, &value, sizeof(value));
+}
+
+void CommandList::setFloat(int location, float value)
+{
+    setUniform(location, UniformType::Float, &value, sizeof(value));
+}
+
+void CommandList::setVec2(int location, const glm::vec2& value)
+{
+    setUniform(location, UniformType::Vec2, &value[0], sizeof(float) * 2);
+}
+
+void CommandList::setVec3(int location, const glm::vec3& value)
+{
+    setUniform(location, UniformType::Vec3, &value[0], sizeof(float) * 3);
+}
+
+void CommandList::setVec4(int location, const glm::vec4& value)
+{
+    setUniform(location, UniformType::Vec4, &value[0], sizeof(float) * 4);
+}
+
+void CommandList::setMat4(int location, const glm::mat4& value)
+{
+    setUniform(location, UniformType::Mat4, &value[0][0], sizeof(float) * 16);
+}
+
+void CommandList::drawArrays(Primitive primitive, int first, int count)
+{
+    int32_t values[3] = { static_cast<int32_t>(primitive), first, count };
+    std::memcpy(begin(Type::DrawArrays, sizeof(values)), values, sizeof(values));
+    draws++;
+    indices += count;
+}
+
+void CommandList::drawElements(Primitive primitive, int count, size_t byteOffset)
+{
+    uint32_t values[3] = { static_cast<uint32_t>(primitive), static_cast<uint32_t>(count), static_cast<uint32_t>(byteOffset) };
+    std::memcpy(begin(Type::DrawElements, sizeof(values)), values, sizeof(values));
+    draws++;
+    indices += count;
+}
+
+void CommandList::drawElementsInstanced(Primitive primitive, int count, size_t byteOffset, int instances)
+{
+    uint32_t values[4] = { static_cast<uint32_t>(primitive), static_cast<uint32_t>(count), static_cast<uint32_t>(byteOffset), static_cast<uint32_t>(instances) };
+    std::memcpy(begin(Type::DrawElementsInstanced, sizeof(values)), values, sizeof(values));
+    draws++;
+    indices += static_cast<uint64_t>(count) * instances;
+}
+
+void CommandList::append(const CommandList& other)
+{
+    stream.insert(stream.end(), other.stream.begin(), other.stream.end());
+    commands += other.commands;
+    draws += other.draws;
+    indices += other.indices;
+    // the other list leaves state we did not track
+    openUniforms = NO_BLOCK;
+    boundProgram = UNKNOWN;
+    boundVertexArray = UNKNOWN;
+    for (unsigned int& texture : boundTextures)
+        texture = UNKNOWN;
+    depthFunc = -1;
+}
+
+// replay
+// ------
+static const GLenum textureTargets[] = { GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_ARRAY };
+static const GLenum depthFuncs[] = { GL_LESS, GL_LEQUAL };
+static const GLenum primitives[] = { GL_TRIANGLES };
+
+void CommandList::replay() const
+{
+    const unsigned char* p = stream.data();
+    const unsigned char* end = p + stream.size();
+    while (p < end)
+    {
+        Header header;
+        std::memcpy(&header, p, sizeof(Header));
+        const unsigned char* payload = p + sizeof(Header);
+        uint32_t v[4];
+        switch (header.type)
+        {
+        case Type::BindProgram:
+            std::memcpy(v, payload, sizeof(uint32_t));
+            glUseProgram(v[0]);
+            break;
+        case Type::BindVertexArray:
+            std::memcpy(v, payload, sizeof(uint32_t));
+            glBindVertexArray(v[0]);
+            break;
+        case Type::BindTexture:
+            std::memcpy(v, payload, sizeof(uint32_t) * 3);
+            glActiveTexture(GL_TEXTURE0 + v[0]);
+            glBindTexture(textureTargets[v[1]], v[2]);
+            break;
+        case Type::DepthFunc:
+            std::memcpy(v, payload, sizeof(uint32_t));
+            glDepthFunc(depthFuncs[v[0]]);
+            break;
+        case Type::UniformRange:
+            std::memcpy(v, payload, sizeof(uint32_t) * 4);
+            glBindBufferRange(GL_UNIFORM_BUFFER, v[0], v[1], v[2], v[3]);
+            break;
+        case Type::Uniforms:
+        {
+            const unsigned char* u = payload;
+            const unsigned char* blockEnd = p + header.size;
+            while (u < blockEnd)
+            {
+                UniformEntry entry;
+                std::memcpy(&entry, u, sizeof(entry));
+                u += sizeof(entry);
+                // the stream keeps floats 4-byte aligned, so the data can be handed to GL in place
+                const GLfloat* f = reinterpret_cast<const GLfloat*>(u);
+                switch (entry.type)
+                {
+                case UniformType::Int:
+                    glUniform1iv(entry.location, 1, reinterpret_cast<const GLint*>(u));
+                    u += 4;
+                    break;
+                case UniformType::Float:
+                    glUniform1fv(entry.location, 1, f);
+                    u += 4;
+                    break;
+                case UniformType::Vec2:
+                    glUniform2fv(entry.location, 1, f);
+                    u += 8;
+                    break;
+                case UniformType::Vec3:
+                    glUniform3fv(entry.location, 1, f);
+                    u += 12;
+                    break;
+                case UniformType::Vec4:
+                    glUniform4fv(entry.location, 1, f);
+                    u += 16;
+                    break;
+                case UniformType::Mat4:
+                    glUniformMatrix4fv(entry.location, 1, GL_FALSE, f);
+                    u += 64;
+                    break;
+                }
+            }
+            break;
+        }
+        case Type::DrawArrays:
+            std::memcpy(v, payload, sizeof(uint32_t) * 3);
+            glDrawArrays(primitives[v[0]], static_cast<GLint>(v[1]), static_cast<GLsizei>(v[2]));
+            break;
+        case Type::DrawElements:
+            std::memcpy(v, payload, sizeof(uint32_t) * 3);
+            glDrawElements(primitives[v[0]], static_cast<GLsizei>(v[1]), GL_UNSIGNED_INT, reinterpret_cast<const void*>(static_cast<uintptr_t>(v[2])));
+            break;
+        case Type::DrawElementsInstanced:
+            std::memcpy(v, payload, sizeof(uint32_t) * 4);
+            glDrawElementsInstanced(primitives[v[0]], static_cast<GLsizei>(v[1]), GL_UNSIGNED_INT,
+                reinterpret_cast<const void*>(static_cast<uintptr_t>(v[2])), static_cast<GLsizei>(v[3]));
+            break;
+        }
+        p += header.size;
+    }
+}
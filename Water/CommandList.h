@@ -0,0 +1,114 @@
+#ifndef COMMAND_LIST_H
+#define COMMAND_LIST_H
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Backend-neutral state the recorded commands refer to; replay() maps them to GL
+enum class TextureTarget : uint8_t { Texture2D, CubeMap, Texture2DArray };
+enum class DepthFunc : uint8_t { Less, LessEqual };
+enum class Primitive : uint8_t { Triangles };
+
+// Uniform locations of a linked program, queried once on the GL thread. Read-only afterwards,
+// so recording threads can resolve names without touching GL.
+// ------------------------------------------------------------------------------------------
+class ProgramUniforms
+{
+public:
+    ProgramUniforms() = default;
+    explicit ProgramUniforms(unsigned int program);
+
+    unsigned int program() const { return id; }
+    // -1 when the program has no active uniform of that name
+    int location(const std::string& name) const;
+
+private:
+    unsigned int id = 0;
+    std::unordered_map<std::string, int> locations;
+};
+
+// A replayable list of draw commands. Any thread can record one; only the GL thread replays it.
+// Commands are packed back to back in one byte stream, consecutive uniform writes share a single
+// packed block, and binds that would not change state are dropped while recording.
+// ---------------------------------------------------------------------------------------------
+class CommandList
+{
+public:
+    CommandList();
+
+    void clear();
+
+    void bindProgram(unsigned int program);
+    void bindVertexArray(unsigned int vertexArray);
+    void bindTexture(unsigned int unit, TextureTarget target, unsigned int texture);
+    void setDepthFunc(DepthFunc func);
+    // bind size bytes of a uniform buffer at offset to a uniform block binding point
+    void bindUniformRange(unsigned int binding, unsigned int buffer, size_t offset, size_t size);
+
+    // uniforms go to the program bound last, writes to location -1 are dropped
+    void setInt(int location, int value);
+    void setFloat(int location, float value);
+    void setVec2(int location, const glm::vec2& value);
+    void setVec3(int location, const glm::vec3& value);
+    void setVec4(int location, const glm::vec4& value);
+    void setMat4(int location, const glm::mat4& value);
+
+    void drawArrays(Primitive primitive, int first, int count);
+    // 32-bit indices from the bound vertex array's element buffer
+    void drawElements(Primitive primitive, int count, size_t byteOffset);
+    void drawElementsInstanced(Primitive primitive, int count, size_t byteOffset, int instances);
+
+    // append every command of another list
+    void append(const CommandList& other);
+
+    // GL thread only
+    void replay() const;
+
+    size_t commandCount() const { return commands; }
+    size_t byteSize() const { return stream.size(); }
+    // what the draws submit, counted while recording: vertices or indices, instances included; every
+    // primitive is a triangle
+    size_t drawCount() const { return draws; }
+    uint64_t indexCount() const { return indices; }
+    uint64_t triangleCount() const { return indices / 3; }
+
+    static const unsigned int MAX_TEXTURE_UNITS = 16;
+
+private:
+    enum class Type : uint32_t { BindProgram, BindVertexArray, BindTexture, DepthFunc, UniformRange, Uniforms, DrawArrays, DrawElements, DrawElementsInstanced };
+    enum class UniformType : uint32_t { Int, Float, Vec2, Vec3, Vec4, Mat4 };
+
+    // every command starts with its type and total size, payloads stay 4-byte aligned
+    struct Header
+    {
+        Type type;
+        uint32_t size;
+    };
+    struct UniformEntry
+    {
+        int32_t location;
+        UniformType type;
+    };
+
+    unsigned char* begin(Type type, size_t payload);
+    void setUniform(int location, UniformType type, const void* data, size_t size);
+
+    std::vector<unsigned char> stream;
+    size_t commands = 0;
+    size_t draws = 0;
+    uint64_t indices = 0;
+    size_t openUniforms;    // offset of the uniform block still being appended to
+
+    // last recorded state, to drop redundant binds
+    unsigned int boundProgram;
+    unsigned int boundVertexArray;
+    unsigned int boundTextures[MAX_TEXTURE_UNITS];
+    int depthFunc;
+};
+
+#endif
@@ -0,0 +1,532 @@
+#include "DrawList.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// bounds and culling
+// ------------------
+DrawBounds computeBounds(const std::vector<Mesh>& meshes)
+{
+    glm::vec3 lo(1e30f), hi(-1e30f);
+    for (const Mesh& mesh : meshes)
+    {
+        for (const Vertex& vertex : mesh.vertices)
+        {
+            lo = glm::min(lo, vertex.Position);
+            hi = glm::max(hi, vertex.Position);
+        }
+    }
+    DrawBounds bounds;
+    if (lo.x > hi.x)
+        return bounds;
+    bounds.center = glm::dvec3((lo + hi) * 0.5f);
+    bounds.radius = glm::length(hi - lo) * 0.5f;
+    return bounds;
+}
+
+Frustum::Frustum(const glm::mat4& m)
+{
+    // Gribb/Hartmann: rows of the combined matrix give the clip planes
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+    planes[0] = row3 + row0;
+    planes[1] = row3 - row0;
+    planes[2] = row3 + row1;
+    planes[3] = row3 - row1;
+    planes[4] = row3 + row2;
+    planes[5] = row3 - row2;
+    for (glm::vec4& plane : planes)
+        plane /= glm::length(glm::vec3(plane.x, plane.y, plane.z));
+}
+
+bool Frustum::intersects(const glm::vec3& center, float radius) const
+{
+    for (const glm::vec4& plane : planes)
+    {
+        if (glm::dot(glm::vec3(plane.x, plane.y, plane.z), center) + plane.w < -radius)
+            return false;
+    }
+    return true;
+}
+
+// pass views
+// ----------
+PassView cameraView(const CameraState& camera, float aspect, const glm::dvec3& origin)
+{
+    PassView view;
+    view.view = camera.viewMatrix(origin);
+    view.projection = glm::perspective(glm::radians(camera.Zoom), aspect, 0.1f, 100.0f);
+    view.position = toRenderSpace(camera.Position, origin);
+    view.origin = origin;
+    return view;
+}
+
+PassView reflectionView(const CameraState& camera, double waterHeight, float aspect, const glm::dvec3& origin)
+{
+    double distance = 2.0 * (camera.Position.y - waterHeight);
+    glm::dvec3 worldPosition = camera.Position;
+    worldPosition.y -= distance;
+    glm::vec3 newPosition = toRenderSpace(worldPosition, origin);
+    float newPitch = -1.0f * camera.Pitch;
+    glm::vec3 newFront;
+    newFront.x = cos(glm::radians(camera.Yaw)) * cos(glm::radians(newPitch));
+    newFront.y = sin(glm::radians(newPitch));
+    newFront.z = sin(glm::radians(camera.Yaw)) * cos(glm::radians(newPitch));
+    newFront = glm::normalize(newFront);
+    glm::vec3 newRight = glm::normalize(glm::cross(newFront, glm::vec3(0, 1, 0)));
+    glm::vec3 newUp = glm::normalize(glm::cross(newRight, newFront));
+
+    PassView view;
+    view.view = glm::lookAt(newPosition, newPosition + newFront, newUp);
+    view.projection = glm::perspective(glm::radians(camera.Zoom), aspect, 0.1f, 100.0f);
+    view.position = newPosition;
+    view.origin = origin;
+    return view;
+}
+
+// recording
+// ---------
+void recordMeshes(CommandList& commands, const std::vector<Mesh>& meshes, const ProgramUniforms& program)
+{
+    for (const Mesh& mesh : meshes)
+    {
+        // same sampler naming as Mesh::Draw: texture_diffuseN, texture_specularN, ...
+        unsigned int diffuseNr = 1;
+        unsigned int specularNr = 1;
+        unsigned int normalNr = 1;
+        unsigned int heightNr = 1;
+        for (unsigned int i = 0; i < mesh.textures.size(); i++)
+        {
+            const std::string& name = mesh.textures[i].type;
+            std::string number;
+            if (name == "texture_diffuse")
+                number = std::to_string(diffuseNr++);
+            else if (name == "texture_specular")
+                number = std::to_string(specularNr++);
+            else if (name == "texture_normal")
+                number = std::to_string(normalNr++);
+            else if (name == "texture_height")
+                number = std::to_string(heightNr++);
+            commands.setInt(program.location(name + number), i);
+            commands.bindTexture(i, TextureTarget::Texture2D, mesh.textures[i].id);
+        }
+        commands.bindVertexArray(mesh.VAO);
+        commands.drawElements(Primitive::Triangles, static_cast<int>(mesh.indices.size()), 0);
+    }
+}
+
+// program and inputs shared by the water tiles and the ocean, both shaded by water.fs; the
+// reflection and refraction images are bound per plane
+static void recordWaterState(CommandList& commands, const ProgramUniforms& program, const SceneResources& resources, const PassView& pass)
+{
+    commands.setDepthFunc(DepthFunc::Less);
+    commands.bindProgram(program.program());
+    commands.setInt(program.location("reflectionTexture"), 0);
+    commands.setInt(program.location("refractionTexture"), 1);
+    commands.setInt(program.location("heightField"), 2);
+    commands.setVec2(program.location("simOrigin"), glm::vec2(glm::dvec2(resources.simOrigin) - glm::dvec2(pass.origin.x, pass.origin.z)));
+    commands.setFloat(program.location("simExtent"), resources.simExtent);
+    commands.setFloat(program.location("rippleStrength"), resources.rippleStrength);
+    commands.bindTexture(2, TextureTarget::Texture2D, resources.heightTexture);
+    // units are set in every mode: a cube and a 2D sampler left on the same unit fail the draw
+    commands.setInt(program.location("sceneColor"), 3);
+    commands.setInt(program.location("hiZ"), 4);
+    commands.setInt(program.location("environment"), 5);
+    commands.setInt(program.location("reflectionDepth"), 6);
+    commands.setInt(program.location("refractionDepth"), 7);
+    commands.setVec3(program.location("absorption"), resources.waterAbsorption);
+    commands.setVec3(program.location("deepColor"), resources.deepWaterColor);
+    commands.setFloat(program.location("shoreSoftness"), resources.shoreSoftness);
+    // the detail tiles, so only the origin's place within a tile matters and fits a float anywhere
+    float tile = resources.waterNormalTile;
+    commands.setInt(program.location("waterNormals"), 8);
+    commands.setVec2(program.location("detailOrigin"), glm::vec2(std::fmod(pass.origin.x, tile), std::fmod(pass.origin.z, tile)));
+    commands.setFloat(program.location("detailTile"), tile);
+    commands.setFloat(program.location("detailStrength"), resources.detailStrength);
+    commands.setFloat(program.location("dudvStrength"), resources.dudvStrength);
+    commands.bindTexture(8, TextureTarget::Texture2DArray, resources.waterNormalTexture);
+    commands.setInt(program.location("environmentLevels"), resources.environmentLevels);
+    commands.setFloat(program.location("roughness"), resources.waterRoughness);
+    commands.bindTexture(5, TextureTarget::CubeMap, resources.environmentTexture);
+    commands.setInt(program.location("reflectionMode"), static_cast<int>(resources.reflectionMode));
+    if (resources.reflectionMode == ReflectionMode::Planar)
+        return;
+    commands.setInt(program.location("hiZLevels"), resources.hiZLevels);
+    commands.bindTexture(3, TextureTarget::Texture2D, resources.sceneColorTexture);
+    commands.bindTexture(4, TextureTarget::Texture2D, resources.hiZTexture);
+}
+
+static void recordPlaneTextures(CommandList& commands, const PlaneTextures& textures)
+{
+    commands.bindTexture(0, TextureTarget::Texture2D, textures.reflection);
+    commands.bindTexture(1, TextureTarget::Texture2D, textures.refraction);
+    commands.bindTexture(6, TextureTarget::Texture2D, textures.reflectionDepth);
+    commands.bindTexture(7, TextureTarget::Texture2D, textures.refractionDepth);
+}
+
+void recordPass(PassDrawList& list, const SceneResources& resources)
+{
+    const PassView& pass = list.pass;
+    list.commands.clear();
+    list.waterCommands.clear();
+    if (!resources.uniforms)
+        return;
+    UniformRing& ring = *resources.uniforms;
+
+    // camera, clip plane and time once per pass, shared by every program
+    float time = static_cast<float>(std::fmod(resources.time, WATER_TIME_PERIOD));
+    size_t passOffset = ring.push(PassBlock{ pass.view, pass.projection, pass.clipPlane, glm::vec4(pass.position, time) });
+    if (passOffset == UniformRing::NO_SPACE)
+        return;
+    // the screen-space modes replay the water on its own, after the opaque scene has been copied
+    bool separateWater = resources.reflectionMode != ReflectionMode::Planar;
+    CommandList* targets[2] = { &list.commands, separateWater ? &list.waterCommands : &list.commands };
+    for (int i = 0; i < (separateWater ? 2 : 1); i++)
+    {
+        targets[i]->bindUniformRange(PASS_BLOCK_BINDING, ring.buffer(), passOffset, sizeof(PassBlock));
+        targets[i]->setDepthFunc(DepthFunc::Less);
+    }
+
+    // per-kind state is recorded when the kind changes, the model block for every item
+    bool first = true;
+    DrawKind current = DrawKind::Model;
+    unsigned int currentPlane = ReflectionSchedule::NO_PLANE;
+    for (const DrawItem& item : list.items)
+    {
+        bool change = first || item.kind != current;
+        first = false;
+        current = item.kind;
+        CommandList& commands = *targets[item.kind == DrawKind::Water || item.kind == DrawKind::Ocean ? 1 : 0];
+
+        const std::vector<Mesh>* meshes = nullptr;
+        if (item.kind == DrawKind::Model)
+        {
+            meshes = item.asset < resources.models.size() ? resources.models[item.asset] : nullptr;
+            if (!meshes)
+                continue;
+        }
+        if (item.kind == DrawKind::Skybox && resources.cubemapTexture == 0)
+            continue;
+        if (item.kind == DrawKind::Terrain && (!resources.terrain || item.asset >= list.terrain.chunks.size()))
+            continue;
+        if (item.kind == DrawKind::Ocean && (!resources.ocean || !resources.ocean->ready()))
+            continue;
+        if (item.kind == DrawKind::Water && item.asset >= resources.planeTextures.size())
+            continue;
+        if (item.kind == DrawKind::Ocean && list.oceanPlane >= resources.planeTextures.size())
+            continue;
+
+        if (item.kind == DrawKind::Model || item.kind == DrawKind::Water)
+        {
+            // a full ring drops the draw rather than overwriting data in flight; counted in overflows()
+            size_t drawOffset = ring.push(DrawBlock{ item.transform });
+            if (drawOffset == UniformRing::NO_SPACE)
+                continue;
+            commands.bindUniformRange(DRAW_BLOCK_BINDING, ring.buffer(), drawOffset, sizeof(DrawBlock));
+        }
+
+        switch (item.kind)
+        {
+        case DrawKind::Model:
+            if (change)
+            {
+                commands.setDepthFunc(DepthFunc::Less);
+                commands.bindProgram(resources.modelProgram.program());
+            }
+            recordMeshes(commands, *meshes, resources.modelProgram);
+            break;
+        case DrawKind::Water:
+        {
+            const ProgramUniforms& program = resources.waterProgram;
+            if (change)
+            {
+                recordWaterState(commands, program, resources, pass);
+                commands.bindVertexArray(resources.waterVertexArray);
+            }
+            if (change || item.asset != currentPlane)
+            {
+                currentPlane = item.asset;
+                recordPlaneTextures(commands, resources.planeTextures[currentPlane]);
+            }
+            commands.drawArrays(Primitive::Triangles, 0, 6);
+            break;
+        }
+        case DrawKind::Ocean:
+        {
+            const ProgramUniforms& program = resources.oceanProgram;
+            const Ocean& ocean = *resources.ocean;
+            if (change)
+            {
+                recordWaterState(commands, program, resources, pass);
+                commands.setFloat(program.location("oceanHeight"), list.ocean.height);
+                commands.bindVertexArray(ocean.vertexArray());
+                currentPlane = list.oceanPlane;
+                recordPlaneTextures(commands, resources.planeTextures[currentPlane]);
+            }
+            // one instanced draw per level, split only if a level outgrows one block
+            int first = list.ocean.levelFirst[item.asset];
+            int remaining = list.ocean.levelCount[item.asset];
+            while (remaining > 0)
+            {
+                int instances = std::min(remaining, OCEAN_BLOCK_CHUNKS);
+                void* data;
+                size_t blockOffset = ring.allocate(sizeof(OceanBlock), data);
+                if (blockOffset == UniformRing::NO_SPACE)
+                    break;
+                std::memcpy(data, &list.ocean.chunks[first], instances * sizeof(glm::vec4));
+                commands.bindUniformRange(OCEAN_BLOCK_BINDING, ring.buffer(), blockOffset, sizeof(OceanBlock));
+                commands.drawElementsInstanced(Primitive::Triangles, ocean.indexCount(), 0, instances);
+                first += instances;
+                remaining -= instances;
+            }
+            break;
+        }
+        case DrawKind::Terrain:
+        {
+            const ProgramUniforms& program = resources.terrainProgram;
+            const Terrain& terrain = *resources.terrain;
+            if (change)
+            {
+                commands.setDepthFunc(DepthFunc::Less);
+                commands.bindProgram(program.program());
+                commands.setInt(program.location("tiles"), 0);
+                // morph distances are measured from the pass's own camera, mirrored for reflections
+                commands.setVec3(program.location("lodCenter"), pass.position);
+                commands.setFloat(program.location("terrainBase"), static_cast<float>(terrain.placement().center.y - pass.origin.y));
+                commands.setFloat(program.location("heightScale"), terrain.placement().heightScale);
+                commands.bindVertexArray(terrain.vertexArray());
+                commands.bindTexture(0, TextureTarget::Texture2DArray, terrain.texture());
+            }
+            const TerrainChunk& chunk = list.terrain.chunks[item.asset];
+            size_t chunkOffset = ring.push(TerrainBlock{ chunk.area, chunk.tile, chunk.morph });
+            if (chunkOffset == UniformRing::NO_SPACE)
+                continue;
+            commands.bindUniformRange(TERRAIN_BLOCK_BINDING, ring.buffer(), chunkOffset, sizeof(TerrainBlock));
+            commands.drawElements(Primitive::Triangles, terrain.indexCount(), 0);
+            break;
+        }
+        case DrawKind::Skybox:
+            // depth test passes when values are equal to the cleared depth
+            commands.setDepthFunc(DepthFunc::LessEqual);
+            commands.bindProgram(resources.skyProgram.program());
+            commands.bindVertexArray(resources.skyboxVertexArray);
+            commands.bindTexture(0, TextureTarget::CubeMap, resources.cubemapTexture);
+            commands.drawArrays(Primitive::Triangles, 0, 36);
+            break;
+        }
+    }
+    for (int i = 0; i < (separateWater ? 2 : 1); i++)
+    {
+        targets[i]->bindVertexArray(0);
+        targets[i]->setDepthFunc(DepthFunc::Less);
+    }
+}
+
+// frame building
+// --------------
+static void addInstances(PassDrawList& list, const SceneState& scene, float waterHeight, float side)
+{
+    Frustum frustum(list.pass.projection * list.pass.view);
+    for (const InstanceState& instance : scene.instances)
+    {
+        if (instance.bounds.radius <= 0.0f)
+            continue;
+        glm::vec3 center = toRenderSpace(instance.bounds.center, list.pass.origin);
+        float radius = instance.bounds.radius;
+        // side > 0 keeps what is above the water, side < 0 what is below, 0 everything
+        if (side > 0.0f && center.y + radius < waterHeight)
+            continue;
+        if (side < 0.0f && center.y - radius > waterHeight)
+            continue;
+        if (!frustum.intersects(center, radius))
+            continue;
+        list.items.push_back({ DrawKind::Model, instance.model, toRenderSpace(instance.transform, list.pass.origin) });
+    }
+}
+
+static void addTerrain(PassDrawList& list, const Terrain* terrain, float waterHeight, float side)
+{
+    if (!terrain)
+    {
+        list.terrain.chunks.clear();
+        list.terrain.requests.clear();
+        return;
+    }
+    terrain->select(Frustum(list.pass.projection * list.pass.view), list.pass.origin, list.pass.position, waterHeight, side, list.terrain);
+    for (size_t i = 0; i < list.terrain.chunks.size(); i++)
+        list.items.push_back({ DrawKind::Terrain, static_cast<unsigned int>(i), glm::mat4(1.0f) });
+}
+
+static void addOcean(PassDrawList& list, const Ocean* ocean)
+{
+    if (!ocean)
+    {
+        list.ocean.count = 0;
+        return;
+    }
+    ocean->select(Frustum(list.pass.projection * list.pass.view), list.pass.origin, list.pass.position, list.ocean);
+    for (int level = 0; level < OceanSelection::MAX_LEVELS; level++)
+    {
+        if (list.ocean.levelCount[level] > 0)
+            list.items.push_back({ DrawKind::Ocean, static_cast<unsigned int>(level), glm::mat4(1.0f) });
+    }
+}
+
+void frameTerrainSelections(const FrameDrawLists& lists, std::vector<const TerrainSelection*>& selections)
+{
+    selections.clear();
+    for (size_t i = 0; i < lists.planeCount; i++)
+    {
+        selections.push_back(&lists.planes[i].reflection.terrain);
+        if (lists.refraction)
+            selections.push_back(&lists.planes[i].refraction.terrain);
+    }
+    selections.push_back(&lists.main.terrain);
+}
+
+// fraction of the screen a sphere covers, from its projected disc; 1 once the camera is inside
+static float screenCoverage(const PassView& pass, const glm::vec3& center, float radius)
+{
+    float depth = -(pass.view * glm::vec4(center, 1.0f)).z;
+    if (depth <= radius)
+        return 1.0f;
+    float rx = radius * pass.projection[0][0] / depth;
+    float ry = radius * pass.projection[1][1] / depth;
+    // the screen is 2 x 2 in NDC
+    return std::min(3.14159265f * rx * ry / 4.0f, 1.0f);
+}
+
+// Lengyel's oblique near plane: the projection's near plane is moved onto clipPlane (render space,
+// the kept side positive), so the pass clips at the water without a clip distance per vertex. The
+// far plane tilts with it. A camera on the kept side has no such projection and is left unclipped.
+static glm::mat4 obliqueProjection(const glm::mat4& projection, const glm::mat4& view, const glm::vec4& clipPlane)
+{
+    glm::vec4 plane = glm::transpose(glm::inverse(view)) * clipPlane;
+    if (plane.w >= 0.0f)
+        return projection;
+    // the frustum corner opposite the plane, in view space
+    glm::vec2 side(plane.x < 0.0f ? -1.0f : 1.0f, plane.y < 0.0f ? -1.0f : 1.0f);
+    glm::vec4 corner((side.x + projection[2][0]) / projection[0][0], (side.y + projection[2][1]) / projection[1][1],
+        -1.0f, (1.0f + projection[2][2]) / projection[3][2]);
+    glm::vec4 nearPlane = plane * (2.0f / glm::dot(plane, corner));
+    // the third row becomes the near plane minus the fourth, (0, 0, -1, 0)
+    glm::mat4 oblique = projection;
+    oblique[0][2] = nearPlane.x;
+    oblique[1][2] = nearPlane.y;
+    oblique[2][2] = nearPlane.z + 1.0f;
+    oblique[3][2] = nearPlane.w;
+    return oblique;
+}
+
+static void buildPlanePass(PassDrawList& list, const SceneState& scene, const PassView& view, double height, float side,
+    const glm::vec2& jitter, bool obliqueClip, const SceneResources* resources, const Terrain* terrain)
+{
+    float waterLevel = static_cast<float>(height - view.origin.y);
+    list.items.clear();
+    list.pass = view;
+    // side > 0: reflection, keep what is above the plane; side < 0: refraction, what is below
+    list.pass.clipPlane = side > 0.0f ? glm::vec4(0, 1, 0, -waterLevel) : glm::vec4(0, -1, 0, waterLevel);
+    if (obliqueClip)
+        list.pass.projection = obliqueProjection(list.pass.projection, list.pass.view, list.pass.clipPlane);
+    // shifts the whole image by jitter in NDC, under a pixel, so culling can use the shifted frustum
+    list.pass.jitter = jitter;
+    list.pass.projection[2][0] -= jitter.x;
+    list.pass.projection[2][1] -= jitter.y;
+    addInstances(list, scene, waterLevel, side);
+    addTerrain(list, terrain, waterLevel, side);
+    // no sky: the water fills whatever the reflection leaves empty from the prefiltered environment
+    if (resources)
+        recordPass(list, *resources);
+}
+
+void buildFrameDrawLists(JobSystem& jobs, const SceneState& scene, const CameraState& camera,
+    const ReflectionSchedule& reflections, float aspect, FrameDrawLists& lists, const SceneResources* resources,
+    const Terrain* terrain, const Ocean* ocean)
+{
+    Job* frame = jobs.create([](Job&) {});
+    // one origin for every pass
+    glm::dvec3 origin = renderOrigin(camera.Position);
+
+    // reflection and refraction of every plane due this frame; the lists only ever grow, so their
+    // command buffers are reused
+    lists.planeCount = reflections.renders.size();
+    lists.refraction = reflections.refraction;
+    if (lists.planes.size() < lists.planeCount)
+        lists.planes.resize(lists.planeCount);
+    for (size_t i = 0; i < lists.planeCount; i++)
+    {
+        PlanePassLists* planeLists = &lists.planes[i];
+        planeLists->plane = reflections.renders[i];
+        double height = reflections.heights[planeLists->plane];
+        glm::vec2 jitter = i < reflections.jitter.size() ? reflections.jitter[i] : glm::vec2(0.0f);
+
+        // mirrored camera, keep what is above the water plane
+        jobs.run(jobs.createChild(frame, [&, planeLists, height, jitter](Job&)
+        {
+            buildPlanePass(planeLists->reflection, scene, reflectionView(camera, height, aspect, origin), height, 1.0f, jitter, reflections.obliqueClip, resources, terrain);
+        }));
+        // primary camera, keep what is below the water plane; the screen-space modes refract the main pass
+        if (!reflections.refraction)
+            continue;
+        jobs.run(jobs.createChild(frame, [&, planeLists, height, jitter](Job&)
+        {
+            buildPlanePass(planeLists->refraction, scene, cameraView(camera, aspect, origin), height, -1.0f, jitter, reflections.obliqueClip, resources, terrain);
+        }));
+    }
+
+    // main: models, terrain, every visible water tile, the ocean, then the sky
+    jobs.run(jobs.createChild(frame, [&](Job&)
+    {
+        PassDrawList& list = lists.main;
+        list.items.clear();
+        list.pass = cameraView(camera, aspect, origin);
+        list.pass.clipPlane = glm::vec4(0.0f);
+        addInstances(list, scene, 0.0f, 0.0f);
+        addTerrain(list, terrain, 0.0f, 0.0f);
+
+        const std::vector<glm::dmat4>& tiles = scene.waterTransforms;
+        Frustum frustum(list.pass.projection * list.pass.view);
+        lists.waterVisible.resize(tiles.size());
+        jobs.parallelFor(tiles.size(), 256, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+                lists.waterVisible[i] = frustum.intersects(toRenderSpace(scene.waterBounds[i].center, origin), scene.waterBounds[i].radius);
+        });
+        lists.planeCoverage.assign(reflections.heights.size(), 0.0f);
+        for (size_t i = 0; i < tiles.size(); i++)
+        {
+            if (!lists.waterVisible[i])
+                continue;
+            unsigned int plane = reflections.planeOfBody(i < scene.waterBodies.size() ? scene.waterBodies[i] : 0);
+            glm::vec3 center = toRenderSpace(scene.waterBounds[i].center, origin);
+            if (plane < lists.planeCoverage.size())
+                lists.planeCoverage[plane] += screenCoverage(list.pass, center, scene.waterBounds[i].radius);
+            list.items.push_back({ DrawKind::Water, plane, toRenderSpace(tiles[i], origin) });
+        }
+        list.oceanPlane = reflections.oceanPlane;
+        addOcean(list, ocean);
+        if (list.oceanPlane < lists.planeCoverage.size())
+        {
+            for (size_t i = 0; i < list.ocean.count; i++)
+            {
+                const glm::vec4& chunk = list.ocean.chunks[i];
+                glm::vec3 center(chunk.x + 0.5f * chunk.z, list.ocean.height, chunk.y + 0.5f * chunk.z);
+                lists.planeCoverage[list.oceanPlane] += screenCoverage(list.pass, center, chunk.z * 0.7072f);
+            }
+        }
+        for (float& coverage : lists.planeCoverage)
+            coverage = std::min(coverage, 1.0f);
+
+        list.items.push_back({ DrawKind::Skybox, 0, glm::mat4(1.0f) });
+        if (resources)
+            recordPass(list, *resources);
+    }));
+
+    jobs.run(frame);
+    jobs.wait(frame);
+}
@@ -0,0 +1,176 @@
+#ifndef DRAW_LIST_H
+#define DRAW_LIST_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader_m.h>
+#include <learnopengl/mesh.h>
+
+#include "CommandList.h"
+#include "JobSystem.h"
+#include "Ocean.h"
+#include "PlanarReflections.h"
+#include "UniformRing.h"
+#include "SimulationThread.h"
+#include "Terrain.h"
+#include "WorldSpace.h"
+
+#include <vector>
+
+// What a draw packet renders; the GL thread maps each kind to its shader and geometry
+enum class DrawKind { Model, Water, Ocean, Terrain, Skybox };
+
+struct DrawItem
+{
+    DrawKind kind;
+    unsigned int asset;     // model index for Model, reflection plane for Water, LOD level for Ocean, chunk index for Terrain
+    glm::mat4 transform;    // render space
+};
+
+// Camera and clip plane shared by every draw in a pass. Everything but origin is in render space,
+// relative to origin (see WorldSpace.h).
+struct PassView
+{
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    glm::vec4 clipPlane = glm::vec4(0.0f);
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::dvec3 origin = glm::dvec3(0.0);    // world position of the render-space origin
+    glm::vec2 jitter = glm::vec2(0.0f);     // NDC offset folded into projection
+
+    // projection * view as it would be without the jitter, what temporal resolves reproject with
+    glm::mat4 stableViewProjection() const
+    {
+        glm::mat4 stable = projection;
+        stable[2][0] += jitter.x;
+        stable[2][1] += jitter.y;
+        return stable * view;
+    }
+};
+
+struct PassDrawList
+{
+    PassView pass;
+    std::vector<DrawItem> items;    // what survived culling, in draw order
+    TerrainSelection terrain;       // chunks the terrain items refer to
+    OceanSelection ocean;           // chunk pool the ocean items draw from, main pass only
+    unsigned int oceanPlane = 0;    // reflection plane the ocean samples
+    CommandList commands;           // items recorded for replay on the GL thread
+    CommandList waterCommands;      // water and ocean, when the screen-space modes draw them after the rest
+};
+
+// The reflection and refraction passes of one water plane
+struct PlanePassLists
+{
+    unsigned int plane = 0;
+    PassDrawList reflection;
+    PassDrawList refraction;
+};
+
+// The scene passes of a frame, rebuilt every frame
+struct FrameDrawLists
+{
+    std::vector<PlanePassLists> planes;     // the first planeCount are this frame's, in schedule order
+    size_t planeCount = 0;
+    bool refraction = true;                 // whether their refraction lists are this frame's too
+    PassDrawList main;
+
+    std::vector<float> planeCoverage;           // screen fraction of each plane's water in the main pass
+    std::vector<unsigned char> waterVisible;    // scratch for parallel culling
+};
+
+// model-space bounding sphere of a loaded model
+DrawBounds computeBounds(const std::vector<Mesh>& meshes);
+
+// The images the water of one plane samples
+struct PlaneTextures
+{
+    unsigned int reflection = 0;
+    unsigned int refraction = 0;
+    unsigned int reflectionDepth = 0;   // tells the water where the sky shows
+    unsigned int refractionDepth = 0;   // the floor under the water, for its thickness
+};
+
+// seconds PassBlock's time wraps over: water.fs scrolls its detail layers by whole tiles in it
+const double WATER_TIME_PERIOD = 64.0;
+
+// GL objects and settings the recorded commands refer to, gathered on the GL thread
+struct SceneResources
+{
+    ProgramUniforms modelProgram;
+    ProgramUniforms waterProgram;
+    ProgramUniforms skyProgram;
+    ProgramUniforms terrainProgram;
+    ProgramUniforms oceanProgram;
+    std::vector<const std::vector<Mesh>*> models;    // per scene model, null until it streamed in
+    UniformRing* uniforms = nullptr;    // per-pass and per-draw blocks, open for the current frame
+
+    unsigned int waterVertexArray = 0;
+    unsigned int skyboxVertexArray = 0;
+    std::vector<PlaneTextures> planeTextures;    // per reflection plane
+    ReflectionMode reflectionMode = ReflectionMode::Planar;
+    unsigned int sceneColorTexture = 0;     // the opaque main pass and its depth pyramid, screen-space modes
+    unsigned int hiZTexture = 0;
+    int hiZLevels = 0;
+    unsigned int heightTexture = 0;
+    unsigned int cubemapTexture = 0;    // 0 skips the sky until it streamed in
+    unsigned int environmentTexture = 0;    // prefiltered sky the water reflects, see EnvironmentMap
+    int environmentLevels = 1;
+    float waterRoughness = 0.05f;
+    const Terrain* terrain = nullptr;   // null skips the terrain until it streamed in
+    const Ocean* ocean = nullptr;       // null when the scene has no ocean
+
+    glm::vec2 simOrigin = glm::vec2(0.0f);
+    float simExtent = 1.0f;
+    float rippleStrength = 4.0f;
+
+    // light lost through the water column, per metre and channel, towards deepWaterColor; the
+    // ripples and the water itself fade out over shoreSoftness metres of depth at the shore
+    // (FEATURE_SOFT_EDGES)
+    glm::vec3 waterAbsorption = glm::vec3(0.45f, 0.09f, 0.06f);
+    glm::vec3 deepWaterColor = glm::vec3(0.02f, 0.12f, 0.16f);
+    float shoreSoftness = 0.6f;
+
+    // scrolling normal and DuDv detail, see WaterNormals (FEATURE_NORMAL_MAP)
+    unsigned int waterNormalTexture = 0;
+    float waterNormalTile = 8.0f;
+    float detailStrength = 0.5f;
+    float dudvStrength = 0.015f;
+    double time = 0.0;                  // seconds the detail has been scrolling
+};
+
+// what Mesh::Draw does for each mesh, recorded instead of issued
+void recordMeshes(CommandList& commands, const std::vector<Mesh>& meshes, const ProgramUniforms& program);
+// turn a culled pass into commands; outside the planar mode the water goes into waterCommands
+void recordPass(PassDrawList& list, const SceneResources& resources);
+
+// View frustum planes (inward facing) extracted from a view-projection matrix
+struct Frustum
+{
+    glm::vec4 planes[6];
+
+    explicit Frustum(const glm::mat4& viewProjection);
+    bool intersects(const glm::vec3& center, float radius) const;
+};
+
+// The camera mirrored about the water plane with pitch inverted, for the reflection texture.
+// The mirrored position is computed in world space and rebased like everything else.
+PassView reflectionView(const CameraState& camera, double waterHeight, float aspect, const glm::dvec3& origin);
+PassView cameraView(const CameraState& camera, float aspect, const glm::dvec3& origin);
+
+// every pass's terrain selection this frame, for Terrain::stream
+void frameTerrainSelections(const FrameDrawLists& lists, std::vector<const TerrainSelection*>& selections);
+
+// Cull the scene for the reflection and refraction passes of every plane the schedule renders and
+// for the main pass, and record their command lists. The passes are built as sibling jobs, the
+// water tiles of the main pass with a parallel for. All passes share one render origin near the
+// camera; world transforms and bounds are rebased to it as they are culled. Instances without
+// bounds (radius 0) are not resident yet and skipped. Terrain chunks are selected per pass from
+// that pass's camera, ocean chunks for the main pass as one item per LOD level. The main pass
+// also measures how much of the screen each plane covers, for the next schedule. Without
+// resources only the culled items are produced.
+void buildFrameDrawLists(JobSystem& jobs, const SceneState& scene, const CameraState& camera,
+    const ReflectionSchedule& reflections, float aspect, FrameDrawLists& lists, const SceneResources* resources = nullptr,
+    const Terrain* terrain = nullptr, const Ocean* ocean = nullptr);
+
+#endif
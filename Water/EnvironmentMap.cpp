@@ -0,0 +1,230 @@
+#include "EnvironmentMap.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <sys/stat.h>
+
+static const char ENVIRONMENT_MAGIC[4] = { 'W', 'E', 'N', 'V' };
+static const uint32_t ENVIRONMENT_VERSION = 1;
+
+EnvironmentMap::~EnvironmentMap()
+{
+    if (cubemap)
+        glDeleteTextures(1, &cubemap);
+}
+
+size_t EnvironmentMap::byteSize() const
+{
+    // RGB16F, every level of all six faces
+    size_t bytes = 0;
+    for (int level = 0; level < LEVELS; level++)
+        bytes += static_cast<size_t>(FACE_SIZE >> level) * (FACE_SIZE >> level) * 6 * 6;
+    return bytes;
+}
+
+void EnvironmentMap::create(unsigned int source, const std::string (&faces)[6], unsigned int program, const std::string& cachePath)
+{
+    if (cubemap)
+        glDeleteTextures(1, &cubemap);
+    glGenTextures(1, &cubemap);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+    for (int level = 0; level < LEVELS; level++)
+    {
+        int size = FACE_SIZE >> level;
+        for (int face = 0; face < 6; face++)
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, GL_RGB16F, size, size, 0, GL_RGB, GL_HALF_FLOAT, NULL);
+    }
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, LEVELS - 1);
+
+    cached = readCache(cachePath, faces);
+    if (!cached)
+    {
+        prefilter(source, program);
+        if (!writeCache(cachePath, faces))
+            std::cout << "ERROR::ENVIRONMENT::CACHE_NOT_WRITTEN: " << cachePath << std::endl;
+    }
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+}
+
+// convolution
+// -----------
+void EnvironmentMap::prefilter(unsigned int source, unsigned int program)
+{
+    // the source's own mips let each sample cover its share of the lobe instead of aliasing
+    int sourceSize = 0;
+    glBindTexture(GL_TEXTURE_CUBE_MAP, source);
+    glGetTexLevelParameteriv(GL_TEXTURE_CUBE_MAP_POSITIVE_X, 0, GL_TEXTURE_WIDTH, &sourceSize);
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+    // unit cube around the capture camera, in the context that draws it
+    std::vector<glm::vec3> cube;
+    for (int face = 0; face < 6; face++)
+    {
+        int axis = face / 2;
+        glm::vec3 normal(0.0f), u(0.0f), v(0.0f);
+        normal[axis] = face % 2 ? -1.0f : 1.0f;
+        u[(axis + 1) % 3] = 1.0f;
+        v[(axis + 2) % 3] = 1.0f;
+        glm::vec3 corners[4] = { normal - u - v, normal + u - v, normal + u + v, normal - u + v };
+        int quad[6] = { 0, 1, 2, 0, 2, 3 };
+        for (int corner : quad)
+            cube.push_back(corners[corner]);
+    }
+    unsigned int vertexArray, vertexBuffer, framebuffer;
+    glGenVertexArrays(1, &vertexArray);
+    glGenBuffers(1, &vertexBuffer);
+    glBindVertexArray(vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, cube.size() * sizeof(glm::vec3), cube.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    glEnableVertexAttribArray(0);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    bool depthTest = glIsEnabled(GL_DEPTH_TEST) == GL_TRUE;
+    bool clipping = glIsEnabled(GL_CLIP_DISTANCE0) == GL_TRUE;
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CLIP_DISTANCE0);
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
+    // one camera per face, the orientation GL expects of each
+    glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
+    glm::mat4 views[6] = {
+        glm::lookAt(glm::vec3(0.0f), glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+        glm::lookAt(glm::vec3(0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+        glm::lookAt(glm::vec3(0.0f), glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)),
+        glm::lookAt(glm::vec3(0.0f), glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)),
+        glm::lookAt(glm::vec3(0.0f), glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+        glm::lookAt(glm::vec3(0.0f), glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
+    };
+    glUseProgram(program);
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform1i(glGetUniformLocation(program, "source"), 0);
+    glUniform1f(glGetUniformLocation(program, "sourceSize"), static_cast<float>(sourceSize));
+    glUniform1i(glGetUniformLocation(program, "sampleCount"), SampleCount);
+    int viewLocation = glGetUniformLocation(program, "view");
+    int roughnessLocation = glGetUniformLocation(program, "roughness");
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, source);
+    for (int level = 0; level < LEVELS; level++)
+    {
+        int size = FACE_SIZE >> level;
+        glViewport(0, 0, size, size);
+        glUniform1f(roughnessLocation, static_cast<float>(level) / (LEVELS - 1));
+        for (int face = 0; face < 6; face++)
+        {
+            glUniformMatrix4fv(viewLocation, 1, GL_FALSE, glm::value_ptr(views[face]));
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, cubemap, level);
+            glDrawArrays(GL_TRIANGLES, 0, static_cast<int>(cube.size()));
+        }
+    }
+
+    if (depthTest)
+        glEnable(GL_DEPTH_TEST);
+    if (clipping)
+        glEnable(GL_CLIP_DISTANCE0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &vertexArray);
+    glDeleteBuffers(1, &vertexBuffer);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+}
+
+// cache
+// -----
+// modification time, 0 if the file does not exist
+static long long modifiedTime(const std::string& path)
+{
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? static_cast<long long>(info.st_mtime) : 0;
+}
+
+// what the cache was made from and with: format, sizes and every face with its time
+static std::string cacheKey(const std::string (&faces)[6], int faceSize, int levels, int samples)
+{
+    std::string key(ENVIRONMENT_MAGIC, sizeof(ENVIRONMENT_MAGIC));
+    uint32_t header[4] = { ENVIRONMENT_VERSION, static_cast<uint32_t>(faceSize), static_cast<uint32_t>(levels), static_cast<uint32_t>(samples) };
+    key.append(reinterpret_cast<const char*>(header), sizeof(header));
+    for (int face = 0; face < 6; face++)
+    {
+        long long time = modifiedTime(faces[face]);
+        uint32_t length = static_cast<uint32_t>(faces[face].size());
+        key.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        key.append(faces[face]);
+        key.append(reinterpret_cast<const char*>(&time), sizeof(time));
+    }
+    return key;
+}
+
+bool EnvironmentMap::readCache(const std::string& path, const std::string (&faces)[6])
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+    std::string key = cacheKey(faces, FACE_SIZE, LEVELS, SampleCount);
+    std::string stored(key.size(), '\0');
+    if (!in.read(&stored[0], stored.size()) || stored != key)
+        return false;
+
+    // check the whole file arrived before touching the texture
+    std::vector<char> data(byteSize());
+    if (!in.read(data.data(), data.size()))
+        return false;
+    const char* texels = data.data();
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int level = 0; level < LEVELS; level++)
+    {
+        int size = FACE_SIZE >> level;
+        for (int face = 0; face < 6; face++)
+        {
+            glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, 0, 0, size, size, GL_RGB, GL_HALF_FLOAT, texels);
+            texels += size * size * 6;
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    return true;
+}
+
+bool EnvironmentMap::writeCache(const std::string& path, const std::string (&faces)[6]) const
+{
+    std::vector<char> data(byteSize());
+    char* texels = data.data();
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    for (int level = 0; level < LEVELS; level++)
+    {
+        int size = FACE_SIZE >> level;
+        for (int face = 0; face < 6; face++)
+        {
+            glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, GL_RGB, GL_HALF_FLOAT, texels);
+            texels += size * size * 6;
+        }
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+        return false;
+    std::string key = cacheKey(faces, FACE_SIZE, LEVELS, SampleCount);
+    out.write(key.data(), key.size());
+    out.write(data.data(), data.size());
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,44 @@
+#ifndef ENVIRONMENT_MAP_H
+#define ENVIRONMENT_MAP_H
+
+#include <cstddef>
+#include <string>
+
+// The sky cubemap convolved with the GGX lobe for rising roughness down a short mip chain, what
+// water.fs samples for sky reflections (level = roughness * (LEVELS - 1)). The convolution runs
+// on the GPU once, by importance sampling the mipmapped source, and the result is written to a
+// cache file next to the sky; later runs read it back unless a face image is newer.
+// ---------------------------------------------------------------------------------------------
+class EnvironmentMap
+{
+public:
+    static const int FACE_SIZE = 128;   // level 0, roughness 0
+    static const int LEVELS = 5;        // down to 8 x 8 at roughness 1
+
+    int SampleCount = 512;              // GGX samples per texel
+
+    EnvironmentMap() = default;
+    ~EnvironmentMap();
+    EnvironmentMap(const EnvironmentMap&) = delete;
+    EnvironmentMap& operator=(const EnvironmentMap&) = delete;
+
+    // any thread with a current context (the loader's is fine, nothing here outlives the call but
+    // the texture): read cachePath if it was made from these faces, otherwise prefilter source
+    // with program (prefilter.vs / prefilter.fs) and write the cache. faces only key the cache.
+    void create(unsigned int source, const std::string (&faces)[6], unsigned int program, const std::string& cachePath);
+
+    unsigned int texture() const { return cubemap; }
+    int levels() const { return LEVELS; }
+    bool fromCache() const { return cached; }
+    size_t byteSize() const;
+
+private:
+    bool readCache(const std::string& path, const std::string (&faces)[6]);
+    bool writeCache(const std::string& path, const std::string (&faces)[6]) const;
+    void prefilter(unsigned int source, unsigned int program);
+
+    unsigned int cubemap = 0;
+    bool cached = false;
+};
+
+#endif
@@ -0,0 +1,258 @@
+#include "FrameStats.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static const uint32_t STUTTER_BIT = 1u << 31;
+static const uint64_t MIN_STUTTER_FRAMES = 16;     // a median of fewer frames says little
+
+static int highestBit(uint32_t value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse(&index, value);
+    return static_cast<int>(index);
+#else
+    return 31 - __builtin_clz(value);
+#endif
+}
+
+// buckets
+// -------
+// 0..255 us one bucket each, then SUB_BUCKETS / 2 buckets per power of two
+int FrameStats::bucketOf(uint32_t us)
+{
+    if (us > MAX_US)
+        us = MAX_US;
+    if (us < 2 * SUB_BUCKETS)
+        return static_cast<int>(us);
+    int shift = highestBit(us) - 7;
+    return SUB_BUCKETS * shift + static_cast<int>(us >> shift);
+}
+
+uint32_t FrameStats::bucketLow(int bucket)
+{
+    if (bucket < 2 * SUB_BUCKETS)
+        return static_cast<uint32_t>(bucket);
+    int shift = bucket / SUB_BUCKETS - 1;
+    return static_cast<uint32_t>(bucket - SUB_BUCKETS * shift) << shift;
+}
+
+static double bucketMiddleMs(int bucket)
+{
+    uint32_t low = FrameStats::bucketLow(bucket), high = FrameStats::bucketLow(bucket + 1);
+    return (low + (high - low - 1) * 0.5) / 1000.0;
+}
+
+// recording
+// ---------
+FrameStats::FrameStats()
+{
+    reset();
+}
+
+void FrameStats::reset()
+{
+    for (int i = 0; i < BUCKETS; i++)
+    {
+        all.counts[i].store(0, std::memory_order_relaxed);
+        recent.counts[i].store(0, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < WINDOW; i++)
+        ring[i].store(0, std::memory_order_relaxed);
+    recorded.store(0, std::memory_order_relaxed);
+    totalSum.store(0, std::memory_order_relaxed);
+    windowSum.store(0, std::memory_order_relaxed);
+    totalMax.store(0, std::memory_order_relaxed);
+    totalStutters.store(0, std::memory_order_relaxed);
+    windowStutters.store(0, std::memory_order_relaxed);
+    median = 0;
+    belowMedian = 0;
+}
+
+// one writer: a plain load and store per count, no read-modify-write
+void FrameStats::add(Histogram& histogram, int bucket, int delta)
+{
+    std::atomic<uint32_t>& count = histogram.counts[bucket];
+    count.store(count.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+void FrameStats::record(double frameSeconds)
+{
+    uint32_t us = static_cast<uint32_t>(std::min(std::max(frameSeconds * 1.0e6, 0.0), static_cast<double>(MAX_US)));
+    int bucket = bucketOf(us);
+    uint64_t frame = recorded.load(std::memory_order_relaxed);
+
+    // judged against the window before this frame joins it, and the top of the median's bucket so
+    // its width never makes a stutter
+    bool stutter = frame >= MIN_STUTTER_FRAMES && us > StutterFactor * bucketLow(median + 1);
+    uint32_t entry = us | (stutter ? STUTTER_BIT : 0);
+
+    std::atomic<uint32_t>& slot = ring[frame % WINDOW];
+    uint32_t evicted = slot.load(std::memory_order_relaxed);
+    bool full = frame >= WINDOW;
+    uint64_t sum = windowSum.load(std::memory_order_relaxed) + us;
+    uint32_t windowStutter = windowStutters.load(std::memory_order_relaxed) + (stutter ? 1 : 0);
+    if (full)
+    {
+        int old = bucketOf(evicted & ~STUTTER_BIT);
+        add(recent, old, -1);
+        if (old < median)
+            belowMedian--;
+        sum -= evicted & ~STUTTER_BIT;
+        windowStutter -= (evicted & STUTTER_BIT) ? 1 : 0;
+    }
+    add(recent, bucket, 1);
+    add(all, bucket, 1);
+    if (bucket < median)
+        belowMedian++;
+    slot.store(entry, std::memory_order_relaxed);
+    windowSum.store(sum, std::memory_order_relaxed);
+    windowStutters.store(windowStutter, std::memory_order_relaxed);
+    totalSum.store(totalSum.load(std::memory_order_relaxed) + us, std::memory_order_relaxed);
+    totalMax.store(std::max(totalMax.load(std::memory_order_relaxed), us), std::memory_order_relaxed);
+    if (stutter)
+        totalStutters.store(totalStutters.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    // walk the median to the bucket holding the middle frame; a step or none unless the
+    // distribution moved
+    uint32_t middle = static_cast<uint32_t>((std::min<uint64_t>(frame + 1, WINDOW) - 1) / 2);
+    while (belowMedian > middle)
+    {
+        median--;
+        belowMedian -= recent.counts[median].load(std::memory_order_relaxed);
+    }
+    while (belowMedian + recent.counts[median].load(std::memory_order_relaxed) <= middle)
+    {
+        belowMedian += recent.counts[median].load(std::memory_order_relaxed);
+        median++;
+    }
+    recorded.store(frame + 1, std::memory_order_release);
+}
+
+// reading
+// -------
+FrameStats::Summary FrameStats::summarize(const Histogram& histogram, uint64_t sumUs, uint64_t stutters)
+{
+    Summary summary;
+    uint32_t counts[BUCKETS];
+    for (int i = 0; i < BUCKETS; i++)
+    {
+        counts[i] = histogram.counts[i].load(std::memory_order_relaxed);
+        summary.frames += counts[i];
+    }
+    summary.stutters = stutters;
+    if (summary.frames == 0)
+        return summary;
+    summary.meanMs = sumUs / 1000.0 / summary.frames;
+
+    // the bucket holding the frame at each rank, reported as its middle
+    const double fractions[] = { 0.5, 0.95, 0.99 };
+    double* values[] = { &summary.p50Ms, &summary.p95Ms, &summary.p99Ms };
+    uint64_t seen = 0;
+    int next = 0;
+    for (int i = 0; i < BUCKETS && next < 3; i++)
+    {
+        seen += counts[i];
+        while (next < 3 && seen > static_cast<uint64_t>(fractions[next] * (summary.frames - 1)))
+            *values[next++] = bucketMiddleMs(i);
+    }
+    return summary;
+}
+
+FrameStats::Summary FrameStats::window() const
+{
+    Summary summary = summarize(recent, windowSum.load(std::memory_order_relaxed), windowStutters.load(std::memory_order_relaxed));
+    for (int i = 0; i < WINDOW; i++)
+        summary.maxMs = std::max(summary.maxMs, recentMs(i));
+    return summary;
+}
+
+FrameStats::Summary FrameStats::total() const
+{
+    Summary summary = summarize(all, totalSum.load(std::memory_order_relaxed), totalStutters.load(std::memory_order_relaxed));
+    summary.maxMs = totalMax.load(std::memory_order_relaxed) / 1000.0;
+    return summary;
+}
+
+uint32_t FrameStats::recentEntry(int i) const
+{
+    uint64_t frames = recorded.load(std::memory_order_acquire);
+    if (i < 0 || i >= WINDOW || static_cast<uint64_t>(i) >= frames)
+        return 0;
+    return ring[(frames - 1 - i) % WINDOW].load(std::memory_order_relaxed);
+}
+
+double FrameStats::recentMs(int i) const
+{
+    return (recentEntry(i) & ~STUTTER_BIT) / 1000.0;
+}
+
+bool FrameStats::recentStutter(int i) const
+{
+    return (recentEntry(i) & STUTTER_BIT) != 0;
+}
+
+// export
+// ------
+bool FrameStats::writeCsv(const std::string& path) const
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        std::cout << "ERROR::FRAME_STATS:: could not write " << path << std::endl;
+        return false;
+    }
+    uint64_t frames = 0;
+    for (int i = 0; i < BUCKETS; i++)
+        frames += all.counts[i].load(std::memory_order_relaxed);
+    out << "bucket_low_ms,bucket_high_ms,frames,cumulative_fraction\n";
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++)
+    {
+        uint32_t count = all.counts[i].load(std::memory_order_relaxed);
+        if (count == 0)
+            continue;
+        seen += count;
+        out << bucketLow(i) / 1000.0 << "," << bucketLow(i + 1) / 1000.0 << "," << count << "," << static_cast<double>(seen) / frames << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+static void writeSummary(std::ostream& out, const char* name, const FrameStats::Summary& summary)
+{
+    out << "  \"" << name << "\": { \"frames\": " << summary.frames << ", \"mean_ms\": " << summary.meanMs
+        << ", \"p50_ms\": " << summary.p50Ms << ", \"p95_ms\": " << summary.p95Ms << ", \"p99_ms\": " << summary.p99Ms
+        << ", \"max_ms\": " << summary.maxMs << ", \"stutters\": " << summary.stutters << " },\n";
+}
+
+bool FrameStats::writeJson(const std::string& path) const
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        std::cout << "ERROR::FRAME_STATS:: could not write " << path << std::endl;
+        return false;
+    }
+    out << std::setprecision(6) << "{\n";
+    writeSummary(out, "total", total());
+    writeSummary(out, "window", window());
+    out << "  \"stutter_factor\": " << StutterFactor << ",\n  \"histogram\": [";
+    bool first = true;
+    for (int i = 0; i < BUCKETS; i++)
+    {
+        uint32_t count = all.counts[i].load(std::memory_order_relaxed);
+        if (count == 0)
+            continue;
+        out << (first ? "\n" : ",\n") << "    { \"low_ms\": " << bucketLow(i) / 1000.0 << ", \"frames\": " << count << " }";
+        first = false;
+    }
+    out << (first ? "]\n}\n" : "\n  ]\n}\n");
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,80 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Frame times in a fixed-size log-linear histogram, HdrHistogram style: values in microseconds,
+// exact below 256 us and within 1/128 (0.8%) above it, up to 10 s. One histogram covers the whole
+// run and one the last WINDOW frames, whose times are kept in a ring so the oldest can leave it;
+// the window's median bucket is tracked as frames come and go, so a frame longer than
+// StutterFactor times the median counts as a stutter without any sorting.
+// record() is for one thread, the render thread; every count is an atomic it stores with relaxed
+// order, so summary(), the HUD and the exports read from any thread without locks and at worst
+// see a frame half recorded.
+// ------------------------------------------------------------------------------------------------
+class FrameStats
+{
+public:
+    static const int WINDOW = 1024;         // frames the rolling percentiles cover
+    static const int SUB_BUCKETS = 128;
+    static const int BUCKETS = SUB_BUCKETS * 18;
+    static const uint32_t MAX_US = 10000000;
+
+    float StutterFactor = 2.0f;
+
+    struct Summary
+    {
+        uint64_t frames = 0;            // in what the summary covers
+        double meanMs = 0.0;
+        double p50Ms = 0.0, p95Ms = 0.0, p99Ms = 0.0, maxMs = 0.0;
+        uint64_t stutters = 0;
+    };
+
+    FrameStats();
+    FrameStats(const FrameStats&) = delete;
+    FrameStats& operator=(const FrameStats&) = delete;
+
+    // render thread, once a frame
+    void record(double frameSeconds);
+    void reset();
+
+    // any thread: the rolling window, or everything since the start / reset()
+    Summary window() const;
+    Summary total() const;
+    // the i-th most recent frame, i < WINDOW: its time, 0 before there was one, and whether it stuttered
+    double recentMs(int i) const;
+    bool recentStutter(int i) const;
+
+    // run histogram and both summaries; CSV is one row per filled bucket
+    bool writeCsv(const std::string& path) const;
+    bool writeJson(const std::string& path) const;
+
+    static int bucketOf(uint32_t us);
+    static uint32_t bucketLow(int bucket);
+
+private:
+    struct Histogram
+    {
+        std::atomic<uint32_t> counts[BUCKETS];
+    };
+
+    static Summary summarize(const Histogram& histogram, uint64_t sumUs, uint64_t stutters);
+    static void add(Histogram& histogram, int bucket, int delta);
+    uint32_t recentEntry(int i) const;
+
+    Histogram all, recent;
+    std::atomic<uint32_t> ring[WINDOW];     // window frame times in us, oldest overwritten
+    std::atomic<uint64_t> recorded;         // frames since reset
+    std::atomic<uint64_t> totalSum, windowSum;  // us
+    std::atomic<uint32_t> totalMax;
+    std::atomic<uint64_t> totalStutters;
+    std::atomic<uint32_t> windowStutters;   // bit 31 of a ring entry marks a stutter, counted here
+
+    // the window's median bucket and how many window frames lie below it, writer only
+    int median = 0;
+    uint32_t belowMedian = 0;
+};
+
+#endif
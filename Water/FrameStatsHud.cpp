@@ -0,0 +1,133 @@
+#include "FrameStatsHud.h"
+#include "FrameStats.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+
+// layout, in pixels from the bottom-left corner
+static const float MARGIN = 16.0f;
+static const float BAR_WIDTH = 2.0f;
+static const float GRAPH_HEIGHT = 120.0f;
+static const float GLYPH_SCALE = 3.0f;      // pixels per font cell
+static const float LINE_SPACING = 24.0f;
+
+static const float BAR_COLOR[3] = { 0.6f, 0.8f, 1.0f };
+static const float STUTTER_COLOR[3] = { 1.0f, 0.2f, 0.2f };
+static const float P50_COLOR[3] = { 0.3f, 1.0f, 0.3f };
+static const float P95_COLOR[3] = { 1.0f, 1.0f, 0.3f };
+static const float P99_COLOR[3] = { 1.0f, 0.6f, 0.2f };
+static const float MAX_COLOR[3] = { 1.0f, 0.3f, 0.9f };
+static const float BACKDROP_COLOR[3] = { 0.0f, 0.0f, 0.0f };
+
+FrameStatsHud::~FrameStatsHud()
+{
+    if (instanceBuffer)
+        glDeleteBuffers(1, &instanceBuffer);
+}
+
+void FrameStatsHud::create(unsigned int hudProgram, unsigned int quadVertexArray)
+{
+    program = hudProgram;
+    vertexArray = quadVertexArray;
+    instances.reserve(MAX_INSTANCES);
+
+    glGenBuffers(1, &instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, MAX_INSTANCES * sizeof(Instance), NULL, GL_STREAM_DRAW);
+
+    // the quad's own attributes stay as they are, the instances step through these
+    glBindVertexArray(vertexArray);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offsetof(Instance, rect));
+    glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offsetof(Instance, color));
+    glVertexAttribDivisor(3, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// instances
+// ---------
+void FrameStatsHud::addRect(float x, float y, float w, float h, const float (&rgb)[3], float glyph)
+{
+    if (instances.size() >= static_cast<size_t>(MAX_INSTANCES))
+        return;
+    Instance instance = { { x, y, w, h }, { rgb[0], rgb[1], rgb[2], glyph } };
+    instances.push_back(instance);
+}
+
+void FrameStatsHud::addNumber(double value, float x, float y, float pixelWidth, float pixelHeight, const float (&rgb)[3])
+{
+    char text[16];
+    std::snprintf(text, sizeof(text), value < 1000.0 && value != static_cast<long long>(value) ? "%.1f" : "%.0f", value);
+    float advance = 4.0f * GLYPH_SCALE * pixelWidth;
+    for (const char* c = text; *c && c < text + 8; c++, x += advance)
+    {
+        float glyph = *c == '.' ? 10.0f : static_cast<float>(*c - '0');
+        addRect(x, y, 3.0f * GLYPH_SCALE * pixelWidth, 5.0f * GLYPH_SCALE * pixelHeight, rgb, glyph);
+    }
+}
+
+// frame
+// -----
+void FrameStatsHud::draw(const FrameStats& stats, int width, int height)
+{
+    if (!program || width <= 0 || height <= 0)
+        return;
+    FrameStats::Summary summary = stats.window();
+
+    // one pixel in clip space
+    float px = 2.0f / width, py = 2.0f / height;
+    float left = -1.0f + MARGIN * px, bottom = -1.0f + MARGIN * py;
+    float graphWidth = BARS * BAR_WIDTH * px, graphHeight = GRAPH_HEIGHT * py;
+    auto heightOf = [&](double ms) { return graphHeight * static_cast<float>(std::min(ms / GraphMs, 1.0)); };
+
+    instances.clear();
+    float textLeft = left + graphWidth + 8.0f * px;
+    addRect(left - 4.0f * px, bottom - 4.0f * py, graphWidth + 8.0f * px + 8.0f * 4.0f * GLYPH_SCALE * px + 8.0f * px,
+            graphHeight + 8.0f * py, BACKDROP_COLOR, -2.0f);
+
+    // oldest frame on the left
+    for (int i = 0; i < BARS; i++)
+    {
+        int frame = BARS - 1 - i;
+        double ms = stats.recentMs(frame);
+        if (ms <= 0.0)
+            continue;
+        addRect(left + i * BAR_WIDTH * px, bottom, (BAR_WIDTH - 0.5f) * px, heightOf(ms),
+                stats.recentStutter(frame) ? STUTTER_COLOR : BAR_COLOR);
+    }
+
+    const double values[] = { summary.maxMs, summary.p99Ms, summary.p95Ms, summary.p50Ms };
+    const float (*colors[])[3] = { &MAX_COLOR, &P99_COLOR, &P95_COLOR, &P50_COLOR };
+    for (int i = 0; i < 4; i++)
+    {
+        addRect(left, bottom + heightOf(values[i]), graphWidth, py, *colors[i]);
+        addNumber(values[i], textLeft, bottom + graphHeight - (i + 1) * LINE_SPACING * py, px, py, *colors[i]);
+    }
+    addNumber(static_cast<double>(summary.stutters), textLeft, bottom + graphHeight - 5 * LINE_SPACING * py, px, py, STUTTER_COLOR);
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, MAX_INSTANCES * sizeof(Instance), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(Instance), instances.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // hud.vs writes no clip distance
+    bool clipping = glIsEnabled(GL_CLIP_DISTANCE0) == GL_TRUE;
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CLIP_DISTANCE0);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glUseProgram(program);
+    glBindVertexArray(vertexArray);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, static_cast<GLsizei>(instances.size()));
+    glBindVertexArray(0);
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+    if (clipping)
+        glEnable(GL_CLIP_DISTANCE0);
+}
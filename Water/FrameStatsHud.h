@@ -0,0 +1,51 @@
+#ifndef FRAME_STATS_HUD_H
+#define FRAME_STATS_HUD_H
+
+#include <vector>
+
+class FrameStats;
+
+// The frame-time overlay, H toggles it: the last BARS frames as a bar graph in the bottom-left
+// corner with the stutters in red, lines across it at the window's p50, p95, p99 and max, and the
+// same values in milliseconds beside it in their lines' colours, stutter count last. Every bar,
+// line and digit is one instance of the screen quad (quadVAO), so the overlay is one instanced draw.
+// ------------------------------------------------------------------------------------------------
+class FrameStatsHud
+{
+public:
+    static const int BARS = 240;
+    static const int MAX_INSTANCES = 1 + BARS + 4 + 5 * 8;  // backdrop, bars, lines, five numbers
+
+    float GraphMs = 50.0f;      // frame time at the top of the graph
+
+    FrameStatsHud() = default;
+    ~FrameStatsHud();
+    FrameStatsHud(const FrameStatsHud&) = delete;
+    FrameStatsHud& operator=(const FrameStatsHud&) = delete;
+
+    // GL thread: program is hud.vs / hud.fs; the instance attributes are added to quadVertexArray
+    void create(unsigned int program, unsigned int quadVertexArray);
+
+    // GL thread: draw over whatever framebuffer is bound, at width x height pixels; GL_CLIP_DISTANCE0
+    // is left as it was found
+    void draw(const FrameStats& stats, int width, int height);
+
+    int instanceCount() const { return static_cast<int>(instances.size()); }
+
+private:
+    struct Instance
+    {
+        float rect[4];      // corner and size, in clip space
+        float color[4];     // rgb, a is the glyph: -1 fills the quad, 0-9 digits, 10 the point
+    };
+
+    void addRect(float x, float y, float w, float h, const float (&rgb)[3], float glyph = -1.0f);
+    void addNumber(double value, float x, float y, float pixelWidth, float pixelHeight, const float (&rgb)[3]);
+
+    std::vector<Instance> instances;
+    unsigned int program = 0;
+    unsigned int vertexArray = 0;
+    unsigned int instanceBuffer = 0;
+};
+
+#endif
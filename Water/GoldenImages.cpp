@@ -0,0 +1,292 @@
+#include "GoldenImages.h"
+#include "JobSystem.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/wait.h>
+#endif
+
+// poses and configurations
+// ------------------------
+// around the fountain's basin, which lies at the origin with the water at 0
+struct GoldenPose
+{
+    glm::dvec3 eye;
+    glm::dvec3 target;
+    double time;        // animation time the water scrolls to
+};
+
+static const GoldenPose POSES[GoldenImages::POSE_COUNT] = {
+    { glm::dvec3(0.0, 5.0, 11.0), glm::dvec3(0.0, 0.5, 0.0), 10.0 },        // the whole basin and fountain
+    { glm::dvec3(7.0, 0.4, 5.0), glm::dvec3(0.0, 0.0, 0.0), 11.0 },         // grazing, mostly reflection
+    { glm::dvec3(0.5, 12.0, 1.5), glm::dvec3(0.0, 0.0, 0.0), 12.0 },        // straight down, mostly refraction
+    { glm::dvec3(-3.2, 1.2, -3.4), glm::dvec3(2.0, 0.0, 2.0), 13.0 },       // across the water to the rim, the soft edges
+};
+
+const char* const GoldenImages::POSE_NAMES[POSE_COUNT] = { "overview", "grazing", "top_down", "rim" };
+
+// the minimums leave room for what differs from run to run: where the temporal reflections' jitter
+// sequence happens to be when a pose is read, the checkerboard's reconstruction of it, and the
+// screen-space trace's hits along depth discontinuities
+const GoldenConfiguration GoldenImages::CONFIGURATIONS[CONFIGURATION_COUNT] = {
+    { "high", "--quality high", 0.98 },
+    { "ultra", "--quality ultra", 0.99 },
+    { "medium", "--quality medium", 0.98 },
+    { "low", "--quality low", 0.96 },
+    { "ldr_targets", "--quality high --targets ldr", 0.98 },
+    { "compact_targets", "--quality high --targets compact", 0.97 },
+    { "ssr", "--quality high --reflections ssr", 0.96 },
+    { "blended", "--quality high --reflections blended", 0.96 },
+};
+
+const GoldenConfiguration* GoldenImages::find(const std::string& name)
+{
+    for (const GoldenConfiguration& configuration : CONFIGURATIONS)
+    {
+        if (name == configuration.name)
+            return &configuration;
+    }
+    return nullptr;
+}
+
+static void makeDirectory(const std::string& directory)
+{
+#ifdef _WIN32
+    _mkdir(directory.c_str());
+#else
+    mkdir(directory.c_str(), 0755);
+#endif
+}
+
+// test
+// ----
+void GoldenImages::begin(const GoldenConfiguration& golden, bool update)
+{
+    configuration = &golden;
+    updating = update;
+    pose = 0;
+    frame = 0;
+    status = 0;
+}
+
+CameraState GoldenImages::camera() const
+{
+    const GoldenPose& golden = POSES[pose];
+    glm::dvec3 direction = glm::normalize(golden.target - golden.eye);
+    CameraState camera;
+    camera.Position = golden.eye;
+    camera.Yaw = static_cast<float>(glm::degrees(std::atan2(direction.z, direction.x)));
+    camera.Pitch = static_cast<float>(glm::degrees(std::asin(direction.y)));
+    return camera;
+}
+
+double GoldenImages::time() const
+{
+    return POSES[pose].time;
+}
+
+void GoldenImages::frameDone(int width, int height)
+{
+    if (!running() || ++frame < POSE_FRAMES)
+        return;
+
+    // a stall, but one per pose
+    std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * 4);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glReadBuffer(GL_BACK);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    std::vector<unsigned char> image(static_cast<size_t>(width) * height * 3);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            for (int c = 0; c < 3; c++)
+                image[(static_cast<size_t>(height - 1 - y) * width + x) * 3 + c] = pixels[(static_cast<size_t>(y) * width + x) * 4 + c];
+        }
+    }
+    check(image, width, height);
+    pose++;
+    frame = 0;
+}
+
+void GoldenImages::check(const std::vector<unsigned char>& image, int width, int height)
+{
+    std::string name = std::string(configuration->name) + "_" + POSE_NAMES[pose];
+    std::string path = Directory + "/" + name + ".ppm";
+    if (updating)
+    {
+        makeDirectory(Directory);
+        if (writePpm(path, image, width, height))
+            std::cout << "Golden: wrote " << path << std::endl;
+        else
+            status = std::max(status, 1);
+        return;
+    }
+
+    std::vector<unsigned char> golden;
+    int goldenWidth = 0, goldenHeight = 0;
+    if (!readPpm(path, golden, goldenWidth, goldenHeight))
+    {
+        std::cout << "ERROR::GOLDEN:: no golden image " << path << ", write it with --update-golden" << std::endl;
+        status = 2;
+        return;
+    }
+    // a golden of another size is no match at all
+    double ssim = goldenWidth == width && goldenHeight == height ? imageSsim(golden, image, width, height) : 0.0;
+    bool passed = ssim >= configuration->minimumSsim;
+    std::cout << "Golden: " << configuration->name << " " << POSE_NAMES[pose] << " SSIM " << ssim << " (minimum "
+        << configuration->minimumSsim << ")" << (passed ? "" : " FAILED") << std::endl;
+    if (passed)
+        return;
+
+    status = std::max(status, 1);
+    makeDirectory(OutputDirectory);
+    writePpm(OutputDirectory + "/" + name + ".ppm", image, width, height);
+    if (goldenWidth == width && goldenHeight == height)
+    {
+        // four times the difference, so that small shifts still show
+        std::vector<unsigned char> difference(image.size());
+        for (size_t i = 0; i < image.size(); i++)
+            difference[i] = static_cast<unsigned char>(std::min(255, 4 * std::abs(image[i] - golden[i])));
+        writePpm(OutputDirectory + "/" + name + "_diff.ppm", difference, width, height);
+    }
+}
+
+// suite
+// -----
+// what the process returned, -1 if it did not exit by itself
+static int exitCode(int status)
+{
+#ifdef _WIN32
+    return status;
+#else
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+}
+
+int GoldenImages::runSuite(const std::string& executable, bool update, std::ostream& out)
+{
+    makeDirectory(OutputDirectory);
+    int results[CONFIGURATION_COUNT] = {};
+    {
+        // every configuration renders in a process of its own, each job just waits on one
+        JobSystem jobs(std::max(1u, std::thread::hardware_concurrency()));
+        jobs.parallelFor(CONFIGURATION_COUNT, 1, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                const GoldenConfiguration& golden = CONFIGURATIONS[i];
+                std::string command = "\"" + executable + "\" --golden " + golden.name + (update ? " --update-golden" : "")
+                    + " > \"" + OutputDirectory + "/" + golden.name + ".log\" 2>&1";
+#ifdef _WIN32
+                // cmd.exe takes off the outermost quotes
+                command = "\"" + command + "\"";
+#endif
+                results[i] = exitCode(std::system(command.c_str()));
+            }
+        });
+    }
+
+    int failed = 0, missing = 0;
+    for (int i = 0; i < CONFIGURATION_COUNT; i++)
+    {
+        const GoldenConfiguration& golden = CONFIGURATIONS[i];
+        const char* verdict = results[i] == 0 ? (update ? "updated" : "passed") : results[i] == 2 ? "missing goldens" : "FAILED";
+        out << "  " << golden.name << " (" << golden.options << "): " << verdict << std::endl;
+        if (results[i] == 0)
+            continue;
+        // the configuration's own output, what it compared and why it failed
+        failed++;
+        if (results[i] == 2)
+            missing++;
+        std::ifstream log(OutputDirectory + "/" + golden.name + ".log");
+        std::string line;
+        while (std::getline(log, line))
+            out << "    " << line << std::endl;
+    }
+    out << CONFIGURATION_COUNT - failed << " of " << CONFIGURATION_COUNT << " configurations " << (update ? "updated" : "passed") << std::endl;
+    if (missing == CONFIGURATION_COUNT)
+        out << "no goldens in " << Directory << "/: write them with --golden-suite --update-golden and commit them" << std::endl;
+    return failed > 0 ? 1 : 0;
+}
+
+// images
+// ------
+bool writePpm(const std::string& path, const std::vector<unsigned char>& image, int width, int height)
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+    {
+        std::cout << "ERROR::GOLDEN:: could not write " << path << std::endl;
+        return false;
+    }
+    out << "P6\n" << width << " " << height << "\n255\n";
+    out.write(reinterpret_cast<const char*>(image.data()), image.size());
+    return static_cast<bool>(out);
+}
+
+bool readPpm(const std::string& path, std::vector<unsigned char>& image, int& width, int& height)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::string magic;
+    int maximum = 0;
+    if (!(in >> magic >> width >> height >> maximum) || magic != "P6" || maximum != 255 || width <= 0 || height <= 0)
+        return false;
+    in.get();
+    image.resize(static_cast<size_t>(width) * height * 3);
+    in.read(reinterpret_cast<char*>(image.data()), image.size());
+    return static_cast<bool>(in);
+}
+
+// Wang et al.'s SSIM with the usual constants over 8 x 8 windows every 4 pixels, per channel: a
+// shifted water tint shows in one channel where the luma alone could hide it
+double imageSsim(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b, int width, int height)
+{
+    const int window = 8, stride = 4;
+    const double c1 = (0.01 * 255.0) * (0.01 * 255.0), c2 = (0.03 * 255.0) * (0.03 * 255.0);
+    const double n = window * window;
+    double lowest = 1.0;
+    for (int c = 0; c < 3; c++)
+    {
+        double sum = 0.0;
+        int windows = 0;
+        for (int y = 0; y + window <= height; y += stride)
+        {
+            for (int x = 0; x + window <= width; x += stride)
+            {
+                double sa = 0.0, sb = 0.0, saa = 0.0, sbb = 0.0, sab = 0.0;
+                for (int j = 0; j < window; j++)
+                {
+                    for (int i = 0; i < window; i++)
+                    {
+                        size_t texel = (static_cast<size_t>(y + j) * width + x + i) * 3 + c;
+                        double va = a[texel], vb = b[texel];
+                        sa += va;
+                        sb += vb;
+                        saa += va * va;
+                        sbb += vb * vb;
+                        sab += va * vb;
+                    }
+                }
+                double ma = sa / n, mb = sb / n;
+                double varianceA = saa / n - ma * ma, varianceB = sbb / n - mb * mb, covariance = sab / n - ma * mb;
+                sum += (2.0 * ma * mb + c1) * (2.0 * covariance + c2) / ((ma * ma + mb * mb + c1) * (varianceA + varianceB + c2));
+                windows++;
+            }
+        }
+        lowest = std::min(lowest, windows ? sum / windows : 1.0);
+    }
+    return lowest;
+}
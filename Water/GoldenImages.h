@@ -0,0 +1,74 @@
+#ifndef GOLDEN_IMAGES_H
+#define GOLDEN_IMAGES_H
+
+#include "SimulationThread.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// a render path the golden-image suite covers: the app's own options it runs with, and how
+// similar (SSIM) its images have to stay to their goldens
+struct GoldenConfiguration
+{
+    const char* name;
+    const char* options;
+    double minimumSsim;
+};
+
+// The golden-image regression test, Water --golden <configuration> [--update-golden]. Once the
+// fountain scene has streamed in, the app renders each of POSE_COUNT fixed camera poses for
+// POSE_FRAMES frames at a fixed animation time, so targets, terrain tiles and temporal histories
+// have settled, and reads the last one back. Each image is compared with the stored golden
+// goldens/<configuration>_<pose>.ppm by SSIM; one under the configuration's minimum fails the run,
+// and the image and its difference go to golden_out/ to look at. --update-golden writes the goldens
+// instead. Water --golden-suite runs every configuration, one process each, as many at once as
+// there are cores.
+// ----------------------------------------------------------------------------------------------
+class GoldenImages
+{
+public:
+    static const int POSE_COUNT = 4;
+    static const int POSE_FRAMES = 48;
+    static const char* const POSE_NAMES[POSE_COUNT];
+    static const int CONFIGURATION_COUNT = 8;
+    static const GoldenConfiguration CONFIGURATIONS[CONFIGURATION_COUNT];
+
+    std::string Directory = "goldens";
+    std::string OutputDirectory = "golden_out";
+
+    // configuration by name, nullptr if there is none
+    static const GoldenConfiguration* find(const std::string& name);
+
+    // start with the first pose; update writes the goldens instead of comparing
+    void begin(const GoldenConfiguration& configuration, bool update);
+    bool running() const { return configuration && pose < POSE_COUNT; }
+    // camera and animation time of the frame about to be rendered
+    CameraState camera() const;
+    double time() const;
+    // GL thread, after the frame was rendered into the window's back buffer at width x height
+    void frameDone(int width, int height);
+    // 0 when every pose matched, 1 when one did not, 2 when a golden was missing
+    int result() const { return status; }
+
+    // every configuration through executable, 0 when all of them passed
+    int runSuite(const std::string& executable, bool update, std::ostream& out);
+
+private:
+    void check(const std::vector<unsigned char>& image, int width, int height);
+
+    const GoldenConfiguration* configuration = nullptr;
+    bool updating = false;
+    int pose = 0;
+    int frame = 0;
+    int status = 0;
+};
+
+// images here are 8-bit RGB, rows top to bottom
+bool writePpm(const std::string& path, const std::vector<unsigned char>& image, int width, int height);
+bool readPpm(const std::string& path, std::vector<unsigned char>& image, int& width, int& height);
+// mean structural similarity of a and b over 8 x 8 windows, the lowest of the three channels';
+// 1 when they are identical
+double imageSsim(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b, int width, int height);
+
+#endif
@@ -0,0 +1,138 @@
+#include "HeightReadback.h"
+
+#include <algorithm>
+#include <cstring>
+
+HeightReadback::HeightReadback(int width, int height, int ringSize)
+    : width(width), height(height), ring(std::max(ringSize, 2))
+{
+    for (Slot& slot : ring)
+    {
+        glGenBuffers(1, &slot.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(width) * height * sizeof(float), NULL, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glGenFramebuffers(1, &readFramebuffer);
+}
+
+HeightReadback::~HeightReadback()
+{
+    for (Slot& slot : ring)
+    {
+        if (slot.fence)
+            glDeleteSync(slot.fence);
+        glDeleteBuffers(1, &slot.pbo);
+    }
+    glDeleteFramebuffers(1, &readFramebuffer);
+}
+
+void HeightReadback::bindSource(unsigned int texture)
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+}
+
+bool HeightReadback::request(unsigned int texture, uint64_t frame, double time)
+{
+    if (inFlight == static_cast<int>(ring.size()))
+    {
+        dropped++;
+        return false;
+    }
+
+    Slot& slot = ring[head];
+    bindSource(texture);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    // with a pack buffer bound the last argument is an offset and the call returns immediately
+    glReadPixels(0, 0, width, height, GL_RED, GL_FLOAT, (void*)0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.frame = frame;
+    slot.time = time;
+    head = (head + 1) % ring.size();
+    inFlight++;
+    return true;
+}
+
+bool HeightReadback::poll(uint64_t currentFrame)
+{
+    bool arrived = false;
+    while (inFlight > 0)
+    {
+        Slot& slot = ring[tail];
+        // timeout 0: only ask, never wait
+        GLenum status = glClientWaitSync(slot.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+        glDeleteSync(slot.fence);
+        slot.fence = 0;
+
+        std::swap(previous, latest);
+        latest.heights.resize(static_cast<size_t>(width) * height);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, latest.heights.size() * sizeof(float), GL_MAP_READ_BIT);
+        if (data)
+        {
+            std::memcpy(latest.heights.data(), data, latest.heights.size() * sizeof(float));
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        latest.frame = slot.frame;
+        latest.time = slot.time;
+        latency = static_cast<int>(currentFrame - slot.frame);
+        arrived = true;
+
+        tail = (tail + 1) % ring.size();
+        inFlight--;
+    }
+    return arrived;
+}
+
+void HeightReadback::readSynchronous(unsigned int texture, uint64_t frame, double time)
+{
+    std::swap(previous, latest);
+    latest.heights.resize(static_cast<size_t>(width) * height);
+    bindSource(texture);
+    glReadPixels(0, 0, width, height, GL_RED, GL_FLOAT, latest.heights.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    latest.frame = frame;
+    latest.time = time;
+    latency = 0;
+}
+
+float HeightReadback::sample(const Result& result, glm::vec2 uv) const
+{
+    if (result.heights.empty())
+        return 0.0f;
+    float fx = glm::clamp(uv.x * width - 0.5f, 0.0f, width - 1.0f);
+    float fy = glm::clamp(uv.y * height - 0.5f, 0.0f, height - 1.0f);
+    int x0 = static_cast<int>(fx), y0 = static_cast<int>(fy);
+    int x1 = std::min(x0 + 1, width - 1), y1 = std::min(y0 + 1, height - 1);
+    float tx = fx - x0, ty = fy - y0;
+    const float* h = result.heights.data();
+    float top = h[y0 * width + x0] * (1.0f - tx) + h[y0 * width + x1] * tx;
+    float bottom = h[y1 * width + x0] * (1.0f - tx) + h[y1 * width + x1] * tx;
+    return top * (1.0f - ty) + bottom * ty;
+}
+
+float HeightReadback::sample(glm::vec2 uv) const
+{
+    return sample(latest, uv);
+}
+
+float HeightReadback::predict(glm::vec2 uv, double time) const
+{
+    float h1 = sample(latest, uv);
+    if (previous.frame == INVALID || latest.time <= previous.time)
+        return h1;
+    float h0 = sample(previous, uv);
+    float t = static_cast<float>((time - latest.time) / (latest.time - previous.time));
+    return h1 + (h1 - h0) * t;
+}
@@ -0,0 +1,82 @@
+#ifndef HEIGHT_READBACK_H
+#define HEIGHT_READBACK_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Asynchronous GPU -> CPU copy of a single channel float texture (the water heightfield).
+// Each request() packs the texture into the next pixel buffer object of a small ring and
+// drops a fence behind it; poll() maps whichever buffers the GPU has finished with.
+// Results therefore arrive one or two frames late but the CPU never waits on the GPU.
+// ---------------------------------------------------------------------------------------
+class HeightReadback
+{
+public:
+    HeightReadback(int width, int height, int ringSize = 3);
+    ~HeightReadback();
+
+    // queue a copy of texture (GL_R32F, width x height), tagged with the frame and time it represents.
+    // returns false if every buffer is still in flight and the request was dropped
+    bool request(unsigned int texture, uint64_t frame, double time);
+    // collect finished copies without blocking, returns true if newer heights arrived
+    bool poll(uint64_t currentFrame);
+    // the blocking equivalent (glReadPixels into client memory), kept for comparison
+    void readSynchronous(unsigned int texture, uint64_t frame, double time);
+
+    bool valid() const { return latest.frame != INVALID; }
+    const std::vector<float>& heights() const { return latest.heights; }
+    // frame / time the newest heights were captured at
+    uint64_t sourceFrame() const { return latest.frame; }
+    double sourceTime() const { return latest.time; }
+    // frames between the request and the moment the newest heights became readable
+    int latencyFrames() const { return latency; }
+    // seconds between the newest heights and now
+    double staleness(double now) const { return valid() ? now - latest.time : 0.0; }
+
+    // bilinear lookup in normalized [0, 1] grid coordinates
+    float sample(glm::vec2 uv) const;
+    // linear extrapolation from the two newest readbacks to the given time, for callers that
+    // prefer prediction over showing stale data
+    float predict(glm::vec2 uv, double time) const;
+
+    // number of requests dropped because the ring was full
+    unsigned int droppedRequests() const { return dropped; }
+
+private:
+    static const uint64_t INVALID = ~0ull;
+
+    struct Slot
+    {
+        unsigned int pbo = 0;
+        GLsync fence = 0;
+        uint64_t frame = 0;
+        double time = 0.0;
+    };
+    struct Result
+    {
+        std::vector<float> heights;
+        uint64_t frame = INVALID;
+        double time = 0.0;
+    };
+
+    float sample(const Result& result, glm::vec2 uv) const;
+    void bindSource(unsigned int texture);
+
+    int width;
+    int height;
+    std::vector<Slot> ring;
+    int head = 0;      // next slot to write
+    int tail = 0;      // oldest slot in flight
+    int inFlight = 0;
+    unsigned int readFramebuffer = 0;
+
+    Result latest;
+    Result previous;
+    int latency = 0;
+    unsigned int dropped = 0;
+};
+
+#endif
@@ -0,0 +1,219 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+
+// the worker a thread belongs to, set for the creating thread and every pool thread
+static thread_local JobSystem* currentSystem = nullptr;
+static thread_local unsigned int currentIndex = 0;
+
+// deque
+// -----
+bool JobDeque::push(Job* job)
+{
+    long b = bottom.load(std::memory_order_relaxed);
+    long t = top.load(std::memory_order_acquire);
+    if (b - t >= CAPACITY)
+        return false;
+    jobs[b & (CAPACITY - 1)].store(job, std::memory_order_relaxed);
+    bottom.store(b + 1, std::memory_order_release);
+    return true;
+}
+
+Job* JobDeque::pop()
+{
+    long b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long t = top.load(std::memory_order_relaxed);
+    if (t > b)
+    {
+        // empty
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    Job* job = jobs[b & (CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (t == b)
+    {
+        // last job: race the thieves for it
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            job = nullptr;
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+Job* JobDeque::steal()
+{
+    long t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long b = bottom.load(std::memory_order_acquire);
+    if (t >= b)
+        return nullptr;
+    Job* job = jobs[t & (CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return nullptr;
+    return job;
+}
+
+// job system
+// ----------
+JobSystem::JobSystem(unsigned int threadCount)
+    : creator(std::this_thread::get_id())
+{
+    threadCount = std::max(threadCount, 1u);
+    // the workers, then the external slot
+    for (unsigned int i = 0; i <= threadCount; i++)
+    {
+        Worker* worker = new Worker();
+        // value-initialised: every slot starts out finished
+        worker->ring.reset(new Job[JOBS_PER_THREAD]());
+        worker->random = 0x9E3779B9u * (i + 1);
+        if (i < threadCount)
+            workers.push_back(worker);
+        else
+            external = worker;
+    }
+    currentSystem = this;
+    currentIndex = 0;
+    for (unsigned int i = 1; i < threadCount; i++)
+        threads.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    running = false;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_all();
+    for (std::thread& t : threads)
+        t.join();
+    for (Worker* worker : workers)
+        delete worker;
+    delete external;
+    if (currentSystem == this)
+        currentSystem = nullptr;
+}
+
+bool JobSystem::onWorker() const
+{
+    return currentSystem == this || std::this_thread::get_id() == creator;
+}
+
+JobSystem::Worker& JobSystem::current()
+{
+    if (currentSystem == this)
+        return *workers[currentIndex];
+    // the creating thread stays worker 0 while another system on it is current
+    return std::this_thread::get_id() == creator ? *workers[0] : *external;
+}
+
+Job* JobSystem::allocateSlot()
+{
+    Worker& worker = current();
+    // the next finished slot: one still running since the ring last came round (a parent waiting on
+    // its children, say) is skipped rather than overwritten, and with every slot taken this thread
+    // runs other jobs until one frees up
+    for (;;)
+    {
+        for (size_t tried = 0; tried < JOBS_PER_THREAD; tried++)
+        {
+            Job* job = &worker.ring[worker.next];
+            worker.next = (worker.next + 1) % JOBS_PER_THREAD;
+            if (job->unfinished.load(std::memory_order_acquire) == 0)
+                return job;
+        }
+        if (Job* other = findJob())
+            execute(other);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::run(Job* job)
+{
+    // a full deque runs the job right away rather than dropping it
+    if (!current().deque.push(job))
+    {
+        execute(job);
+        return;
+    }
+    if (sleeping.load(std::memory_order_relaxed) > 0)
+        wake.notify_one();
+}
+
+Job* JobSystem::findJob()
+{
+    Worker& worker = current();
+    if (Job* job = worker.deque.pop())
+        return job;
+
+    // steal from a random victim, then sweep the rest; the external slot is one of them
+    unsigned int count = threadCount() + 1;
+    worker.random ^= worker.random << 13;
+    worker.random ^= worker.random >> 17;
+    worker.random ^= worker.random << 5;
+    unsigned int start = worker.random % count;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        unsigned int index = (start + i) % count;
+        Worker* victim = index < threadCount() ? workers[index] : external;
+        if (victim == &worker)
+            continue;
+        if (Job* job = victim->deque.steal())
+            return job;
+    }
+    return nullptr;
+}
+
+void JobSystem::execute(Job* job)
+{
+    job->function(*job);
+    finish(job);
+}
+
+void JobSystem::finish(Job* job)
+{
+    // read before the count drops, after that the slot may be handed out again
+    Job* parent = job->parent;
+    if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1 && parent)
+        finish(parent);
+}
+
+void JobSystem::wait(const Job* job)
+{
+    while (job->unfinished.load(std::memory_order_acquire) > 0)
+    {
+        if (Job* next = findJob())
+            execute(next);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::workerLoop(unsigned int index)
+{
+    currentSystem = this;
+    currentIndex = index;
+    int idle = 0;
+    while (running.load(std::memory_order_relaxed))
+    {
+        if (Job* job = findJob())
+        {
+            execute(job);
+            idle = 0;
+            continue;
+        }
+        // spin briefly, then doze so an idle pool does not burn a core per thread
+        if (++idle < 64)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleeping++;
+        wake.wait_for(lock, std::chrono::milliseconds(1));
+        sleeping--;
+    }
+}
@@ -0,0 +1,161 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// A unit of work. Jobs are allocated from per-thread rings, carry their callable inline and
+// count their unfinished children: a job is done once it and every child it spawned ran.
+// ----------------------------------------------------------------------------------------
+struct alignas(64) Job
+{
+    static const size_t PAYLOAD_SIZE = 88;
+
+    void (*function)(Job&);
+    Job* parent;
+    std::atomic<int> unfinished;
+    alignas(8) unsigned char payload[PAYLOAD_SIZE];
+};
+
+// Chase-Lev work-stealing deque: the owning thread pushes and pops at the bottom,
+// every other thread steals from the top
+// -------------------------------------------------------------------------------
+class JobDeque
+{
+public:
+    static const long CAPACITY = 4096;
+
+    bool push(Job* job);
+    Job* pop();
+    Job* steal();
+
+private:
+    std::atomic<Job*> jobs[CAPACITY];
+    alignas(64) std::atomic<long> top{ 0 };
+    alignas(64) std::atomic<long> bottom{ 0 };
+};
+
+// Work-stealing scheduler with one deque per thread. The thread that creates the system
+// takes part as worker 0; wait() keeps the waiting thread busy with other jobs.
+// Only worker threads may create, run and wait on jobs. Any other thread may call parallelFor():
+// those take turns at one extra slot, which the workers steal from like any other.
+// -------------------------------------------------------------------------------------
+class JobSystem
+{
+public:
+    static const size_t JOBS_PER_THREAD = 4096;    // jobs in flight per thread; past that allocate() runs others until one is done
+
+    // threadCount includes the calling thread
+    explicit JobSystem(unsigned int threadCount);
+    ~JobSystem();
+
+    unsigned int threadCount() const { return static_cast<unsigned int>(workers.size()); }
+
+    // allocate a job around a callable taking (Job&), children keep their parent from finishing
+    template <typename F>
+    Job* create(F&& function) { return allocate(nullptr, std::forward<F>(function)); }
+    template <typename F>
+    Job* createChild(Job* parent, F&& function) { return allocate(parent, std::forward<F>(function)); }
+
+    // queue a job on the calling thread's deque
+    void run(Job* job);
+    // execute other jobs until job and all of its children have finished
+    void wait(const Job* job);
+
+    // split [0, count) into chunks of at most grain elements and call body(begin, end) on each, in parallel
+    template <typename F>
+    void parallelFor(size_t count, size_t grain, const F& body);
+    // the calling thread is one of the workers
+    bool onWorker() const;
+
+private:
+    struct Worker
+    {
+        JobDeque deque;
+        std::unique_ptr<Job[]> ring;
+        size_t next = 0;
+        unsigned int random = 0;
+    };
+
+    template <typename F>
+    Job* allocate(Job* parent, F&& function);
+    template <typename F>
+    Job* createRange(Job* parent, size_t begin, size_t end, size_t grain, const F* body);
+
+    Job* allocateSlot();
+    Job* findJob();
+    void execute(Job* job);
+    void finish(Job* job);
+    void workerLoop(unsigned int index);
+    Worker& current();
+
+    std::vector<Worker*> workers;
+    Worker* external = nullptr;         // the slot other threads take turns at, under externalMutex
+    std::mutex externalMutex;
+    std::thread::id creator;
+    std::vector<std::thread> threads;
+    std::atomic<bool> running{ true };
+    std::atomic<int> sleeping{ 0 };
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+};
+
+template <typename F>
+Job* JobSystem::allocate(Job* parent, F&& function)
+{
+    using Callable = typename std::decay<F>::type;
+    static_assert(sizeof(Callable) <= Job::PAYLOAD_SIZE, "job callable too large, capture by reference or pointer");
+
+    Job* job = allocateSlot();
+    job->parent = parent;
+    job->unfinished.store(1, std::memory_order_relaxed);
+    if (parent)
+        parent->unfinished.fetch_add(1, std::memory_order_relaxed);
+    new (job->payload) Callable(std::forward<F>(function));
+    job->function = [](Job& self)
+    {
+        Callable* callable = reinterpret_cast<Callable*>(self.payload);
+        (*callable)(self);
+        callable->~Callable();
+    };
+    return job;
+}
+
+template <typename F>
+Job* JobSystem::createRange(Job* parent, size_t begin, size_t end, size_t grain, const F* body)
+{
+    return createChild(parent, [this, begin, end, grain, body](Job& self)
+    {
+        if (end - begin > grain)
+        {
+            size_t middle = begin + (end - begin) / 2;
+            run(createRange(&self, begin, middle, grain, body));
+            run(createRange(&self, middle, end, grain, body));
+        }
+        else
+            (*body)(begin, end);
+    });
+}
+
+template <typename F>
+void JobSystem::parallelFor(size_t count, size_t grain, const F& body)
+{
+    if (count == 0)
+        return;
+    std::unique_lock<std::mutex> turn(externalMutex, std::defer_lock);
+    if (!onWorker())
+        turn.lock();
+    Job* root = create([](Job&) {});
+    run(createRange(root, 0, count, grain > 0 ? grain : 1, &body));
+    run(root);
+    wait(root);
+}
+
+#endif
@@ -0,0 +1,134 @@
+#include "Ocean.h"
+#include "DrawList.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+
+Ocean::~Ocean()
+{
+    if (gridVertexArray)
+    {
+        glDeleteVertexArrays(1, &gridVertexArray);
+        glDeleteBuffers(1, &gridVertexBuffer);
+        glDeleteBuffers(1, &gridElementBuffer);
+    }
+}
+
+void Ocean::configure(const SceneOcean& oceanSettings)
+{
+    settings = oceanSettings;
+    levelCount = 0;
+    if (!settings.enabled())
+        return;
+    levelCount = 1;
+    while (levelCount < OceanSelection::MAX_LEVELS && chunkSize(levelCount - 1) < settings.range)
+        levelCount++;
+}
+
+void Ocean::createGpuResources()
+{
+    if (levelCount == 0 || gridVertexArray)
+        return;
+
+    // chunk mesh: a unit grid in xz, placed per instance in ocean.vs
+    std::vector<glm::vec2> vertices;
+    for (int z = 0; z <= GRID; z++)
+    {
+        for (int x = 0; x <= GRID; x++)
+            vertices.push_back(glm::vec2(x, z) / static_cast<float>(GRID));
+    }
+    std::vector<unsigned int> indices;
+    for (int z = 0; z < GRID; z++)
+    {
+        for (int x = 0; x < GRID; x++)
+        {
+            unsigned int corner = z * (GRID + 1) + x;
+            unsigned int quad[6] = { corner, corner + GRID + 1, corner + 1, corner + 1, corner + GRID + 1, corner + GRID + 2 };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+    glGenVertexArrays(1, &gridVertexArray);
+    glGenBuffers(1, &gridVertexBuffer);
+    glGenBuffers(1, &gridElementBuffer);
+    glBindVertexArray(gridVertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, gridVertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec2), vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gridElementBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+    glBindVertexArray(0);
+}
+
+// selection
+// ---------
+void Ocean::select(const Frustum& frustum, const glm::dvec3& origin, const glm::vec3& eye, OceanSelection& selection) const
+{
+    // the pool is sized once; later frames only overwrite it
+    if (selection.chunks.size() != POOL_CHUNKS)
+    {
+        selection.chunks.resize(POOL_CHUNKS);
+        selection.scratch.resize(POOL_CHUNKS);
+    }
+    std::fill(selection.levelFirst, selection.levelFirst + OceanSelection::MAX_LEVELS, 0);
+    std::fill(selection.levelCount, selection.levelCount + OceanSelection::MAX_LEVELS, 0);
+    selection.count = 0;
+    selection.dropped = 0;
+    selection.origin = origin;
+    selection.height = static_cast<float>(settings.height - origin.y);
+    if (levelCount == 0)
+        return;
+
+    // root cells on the world grid that reach within range of the camera
+    int top = levelCount - 1;
+    double rootSize = chunkSize(top);
+    glm::dvec3 camera = origin + glm::dvec3(eye);
+    long long x0 = static_cast<long long>(std::floor((camera.x - settings.range) / rootSize));
+    long long x1 = static_cast<long long>(std::floor((camera.x + settings.range) / rootSize));
+    long long z0 = static_cast<long long>(std::floor((camera.z - settings.range) / rootSize));
+    long long z1 = static_cast<long long>(std::floor((camera.z + settings.range) / rootSize));
+    for (long long z = z0; z <= z1; z++)
+    {
+        for (long long x = x0; x <= x1; x++)
+            selectNode(top, x, z, frustum, eye, selection);
+    }
+
+    // bucket by level, finest first, so every level is one contiguous instance range
+    for (size_t i = 0; i < selection.count; i++)
+        selection.levelCount[static_cast<int>(selection.scratch[i].w)]++;
+    for (int level = 1; level < OceanSelection::MAX_LEVELS; level++)
+        selection.levelFirst[level] = selection.levelFirst[level - 1] + selection.levelCount[level - 1];
+    int next[OceanSelection::MAX_LEVELS];
+    std::copy(selection.levelFirst, selection.levelFirst + OceanSelection::MAX_LEVELS, next);
+    for (size_t i = 0; i < selection.count; i++)
+        selection.chunks[next[static_cast<int>(selection.scratch[i].w)]++] = selection.scratch[i];
+}
+
+void Ocean::selectNode(int level, long long x, long long z, const Frustum& frustum, const glm::vec3& eye, OceanSelection& selection) const
+{
+    double size = chunkSize(level);
+    glm::vec3 lo = toRenderSpace(glm::dvec3(x * size, settings.height, z * size), selection.origin);
+    float edge = static_cast<float>(size);
+    glm::vec3 hi = lo + glm::vec3(edge, 0.0f, edge);
+
+    float distance = glm::length(glm::max(glm::max(lo - eye, eye - hi), glm::vec3(0.0f)));
+    if (distance > settings.range)
+        return;
+    if (!frustum.intersects((lo + hi) * 0.5f, edge * 0.7072f))
+        return;
+
+    if (level > 0 && distance < LodRange * edge)
+    {
+        for (int i = 0; i < 4; i++)
+            selectNode(level - 1, x * 2 + i % 2, z * 2 + i / 2, frustum, eye, selection);
+        return;
+    }
+    if (selection.count >= POOL_CHUNKS)
+    {
+        selection.dropped++;
+        return;
+    }
+    selection.scratch[selection.count++] = glm::vec4(lo.x, lo.z, edge, static_cast<float>(level));
+}
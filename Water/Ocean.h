@@ -0,0 +1,77 @@
+#ifndef OCEAN_H
+#define OCEAN_H
+
+#include <glm/glm.hpp>
+
+#include "SceneFile.h"
+#include "WorldSpace.h"
+
+#include <cstddef>
+#include <vector>
+
+struct Frustum;
+
+// What one pass selected, bucketed by LOD level so each level is one instanced draw. The chunk
+// arrays are sized on first use and only overwritten afterwards, whatever the camera does.
+struct OceanSelection
+{
+    static const int MAX_LEVELS = 16;
+
+    std::vector<glm::vec4> chunks;      // min corner x, z in render space, size, LOD level; finest level first
+    int levelFirst[MAX_LEVELS] = {};
+    int levelCount[MAX_LEVELS] = {};
+    size_t count = 0;
+    size_t dropped = 0;                 // chunks that did not fit the pool this frame
+    float height = 0.0f;                // render space
+    glm::dvec3 origin = glm::dvec3(0.0);
+
+    std::vector<glm::vec4> scratch;     // selection order, before bucketing
+};
+
+// Unbounded water drawn as a quadtree of chunks laid on a fixed world grid. Every frame the root
+// cells near the camera are walked and split while the camera is closer than LodRange chunk sizes,
+// so the chunk size grows with distance. Chunks are culled against the frustum one by one and go
+// into a pool of POOL_CHUNKS records owned by the selection; nothing is allocated per frame.
+// --------------------------------------------------------------------------------------------
+class Ocean
+{
+public:
+    static const int GRID = 16;             // quads per chunk side
+    static const int POOL_CHUNKS = 2048;    // chunks one selection can hold
+
+    // tuning, read by select()
+    float LodRange = 3.0f;      // a chunk splits while the camera is closer than this many chunk sizes
+
+    Ocean() = default;
+    ~Ocean();
+    Ocean(const Ocean&) = delete;
+    Ocean& operator=(const Ocean&) = delete;
+
+    // any thread, no GL: enough levels that the root chunk spans the range
+    void configure(const SceneOcean& settings);
+    // GL thread: the chunk mesh
+    void createGpuResources();
+    bool ready() const { return gridVertexArray != 0; }
+
+    // pick the chunks for one pass camera; frustum and eye are in the render space of origin.
+    // Safe to call from several threads at once.
+    void select(const Frustum& frustum, const glm::dvec3& origin, const glm::vec3& eye, OceanSelection& selection) const;
+
+    const SceneOcean& placement() const { return settings; }
+    unsigned int vertexArray() const { return gridVertexArray; }
+    int indexCount() const { return GRID * GRID * 6; }
+    int levels() const { return levelCount; }
+
+private:
+    void selectNode(int level, long long x, long long z, const Frustum& frustum, const glm::vec3& eye, OceanSelection& selection) const;
+    double chunkSize(int level) const { return settings.chunkSize * static_cast<double>(1 << level); }
+
+    SceneOcean settings;
+    int levelCount = 0;
+
+    unsigned int gridVertexArray = 0;
+    unsigned int gridVertexBuffer = 0;
+    unsigned int gridElementBuffer = 0;
+};
+
+#endif
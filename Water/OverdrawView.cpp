@@ -0,0 +1,121 @@
+#include "OverdrawView.h"
+
+#include <glad/glad.h>
+
+#include <iostream>
+
+OverdrawView::~OverdrawView()
+{
+    destroy();
+}
+
+void OverdrawView::destroy()
+{
+    if (!depth)
+        return;
+    glDeleteFramebuffers(SCENE_PASS_COUNT, framebuffers);
+    glDeleteTextures(SCENE_PASS_COUNT, counts);
+    glDeleteRenderbuffers(1, &depth);
+    glDeleteVertexArrays(1, &emptyVertexArray);
+    depth = 0;
+}
+
+// setup
+// -----
+void OverdrawView::create(int width, int height, unsigned int overdrawProgram)
+{
+    destroy();
+    targetWidth = width;
+    targetHeight = height;
+    program = overdrawProgram;
+
+    // one depth buffer does for all: every pass clears it before it draws
+    glGenRenderbuffers(1, &depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenTextures(SCENE_PASS_COUNT, counts);
+    glGenFramebuffers(SCENE_PASS_COUNT, framebuffers);
+    for (int i = 0; i < SCENE_PASS_COUNT; i++)
+    {
+        // half floats add whole counts exactly well past where the colours stop
+        glBindTexture(GL_TEXTURE_2D, counts[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R16F, width, height, 0, GL_RED, GL_HALF_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, counts[i], 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glGenVertexArrays(1, &emptyVertexArray);
+}
+
+size_t OverdrawView::targetBytes() const
+{
+    return static_cast<size_t>(targetWidth) * targetHeight * (2 * SCENE_PASS_COUNT + 4);
+}
+
+// frame
+// -----
+void OverdrawView::beginFrame()
+{
+    for (bool& pass : drawn)
+        pass = false;
+}
+
+void OverdrawView::begin(ScenePass pass, int width, int height)
+{
+    int index = static_cast<int>(pass);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[index]);
+    glViewport(0, 0, width, height);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(drawn[index] ? GL_DEPTH_BUFFER_BIT : GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    drawn[index] = true;
+    passWidth[index] = width;
+    passHeight[index] = height;
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+}
+
+void OverdrawView::present(unsigned int framebuffer, int width, int height) const
+{
+    glDisable(GL_BLEND);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, width, height);
+    // hiz.vs writes no clip distance
+    bool clipping = glIsEnabled(GL_CLIP_DISTANCE0) == GL_TRUE;
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CLIP_DISTANCE0);
+    glUseProgram(program);
+    const char* samplers[SCENE_PASS_COUNT] = { "reflectionCounts", "refractionCounts", "mainCounts" };
+    const char* scales[SCENE_PASS_COUNT] = { "reflectionScale", "refractionScale", "mainScale" };
+    for (int i = 0; i < SCENE_PASS_COUNT; i++)
+    {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, counts[i]);
+        glUniform1i(glGetUniformLocation(program, samplers[i]), i);
+        // the part of the target the pass drew into; a pass that did not run shows as empty
+        float x = drawn[i] ? static_cast<float>(passWidth[i]) / targetWidth : 0.0f;
+        float y = drawn[i] ? static_cast<float>(passHeight[i]) / targetHeight : 0.0f;
+        glUniform2f(glGetUniformLocation(program, scales[i]), x, y);
+    }
+    glUniform2f(glGetUniformLocation(program, "targetSize"), static_cast<float>(width), static_cast<float>(height));
+    glUniform1f(glGetUniformLocation(program, "maxCount"), MaxCount);
+    glBindVertexArray(emptyVertexArray);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glActiveTexture(GL_TEXTURE0);
+    glEnable(GL_DEPTH_TEST);
+    if (clipping)
+        glEnable(GL_CLIP_DISTANCE0);
+}
@@ -0,0 +1,52 @@
+#ifndef OVERDRAW_VIEW_H
+#define OVERDRAW_VIEW_H
+
+#include "PipelineStatistics.h"
+
+#include <cstddef>
+
+// The overdraw heatmap, O toggles it. While it is on the frame is recorded with the OVERDRAW
+// variants of every program, whose fragments write 1, and each scene pass is replayed into its
+// own R16F count target here with additive blending, its depth test as usual: a texel ends up
+// holding how many fragments were shaded there. present() then colours the main pass's counts
+// over the window, with the reflection and refraction passes' in insets at the top. All the plane
+// passes of a frame add into the same two targets, and the refraction is counted without its
+// checkerboard mask.
+// ------------------------------------------------------------------------------------------------
+class OverdrawView
+{
+public:
+    float MaxCount = 8.0f;      // counts from here on are the hottest colour
+
+    OverdrawView() = default;
+    ~OverdrawView();
+    OverdrawView(const OverdrawView&) = delete;
+    OverdrawView& operator=(const OverdrawView&) = delete;
+
+    // GL thread: count targets at width x height, the most any pass draws; program is
+    // hiz.vs / overdraw.fs
+    void create(int width, int height, unsigned int program);
+
+    // GL thread, once a frame: the targets are cleared by their first pass
+    void beginFrame();
+    // bind the pass's target at width x height, depth cleared, and start adding
+    void begin(ScenePass pass, int width, int height);
+    // the heatmap onto framebuffer (0 is the window), blending off again, GL_CLIP_DISTANCE0 as it was
+    void present(unsigned int framebuffer, int targetWidth, int targetHeight) const;
+
+    size_t targetBytes() const;
+
+private:
+    void destroy();
+
+    int targetWidth = 0, targetHeight = 0;
+    unsigned int framebuffers[SCENE_PASS_COUNT] = {};
+    unsigned int counts[SCENE_PASS_COUNT] = {};
+    unsigned int depth = 0;
+    int passWidth[SCENE_PASS_COUNT] = {}, passHeight[SCENE_PASS_COUNT] = {};
+    bool drawn[SCENE_PASS_COUNT] = {};
+    unsigned int program = 0;
+    unsigned int emptyVertexArray = 0;
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include "PipelineStatistics.h"
+#include "CommandList.h"
+
+#include <glad/glad.h>
+
+#include <cstring>
+
+const char* const PipelineStatistics::PASS_NAMES[SCENE_PASS_COUNT] = { "reflection", "refraction", "main" };
+
+static const GLenum COUNTER_TARGETS[PipelineStatistics::COUNTERS] = {
+    GL_PRIMITIVES_SUBMITTED_ARB, GL_CLIPPING_OUTPUT_PRIMITIVES_ARB, GL_VERTEX_SHADER_INVOCATIONS_ARB, GL_FRAGMENT_SHADER_INVOCATIONS_ARB };
+
+static bool hasExtension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++)
+    {
+        const GLubyte* extension = glGetStringi(GL_EXTENSIONS, i);
+        if (extension && std::strcmp(reinterpret_cast<const char*>(extension), name) == 0)
+            return true;
+    }
+    return false;
+}
+
+PipelineStatistics::~PipelineStatistics()
+{
+    for (QueryFrame& queries : frames)
+    {
+        if (!queries.queries.empty())
+            glDeleteQueries(static_cast<GLsizei>(queries.queries.size()), queries.queries.data());
+    }
+}
+
+void PipelineStatistics::create()
+{
+    supported = GLAD_GL_VERSION_4_6 || hasExtension("GL_ARB_pipeline_statistics_query");
+}
+
+// frame
+// -----
+void PipelineStatistics::beginFrame()
+{
+    for (int i = 0; i < SCENE_PASS_COUNT; i++)
+    {
+        PassStatistics& result = results[i];
+        result.draws = counting[i].draws;
+        result.indices = counting[i].indices;
+        result.triangles = counting[i].triangles;
+        result.pixels = counting[i].pixels;
+        counting[i] = PassStatistics();
+    }
+    frame++;
+    if (supported)
+        readQueries(frames[frame % FRAMES]);
+}
+
+void PipelineStatistics::begin(ScenePass pass, const CommandList& commands, int width, int height)
+{
+    int index = static_cast<int>(pass);
+    counting[index].pixels += static_cast<uint64_t>(width) * height;
+    submitted(pass, commands);
+    if (!supported)
+        return;
+
+    QueryFrame& queries = frames[frame % FRAMES];
+    if (queries.queries.size() < (queries.used + 1) * COUNTERS)
+    {
+        queries.queries.resize((queries.used + 1) * COUNTERS);
+        glGenQueries(COUNTERS, &queries.queries[queries.used * COUNTERS]);
+        queries.passes.resize(queries.used + 1);
+    }
+    queries.passes[queries.used] = index;
+    for (int i = 0; i < COUNTERS; i++)
+        glBeginQuery(COUNTER_TARGETS[i], queries.queries[queries.used * COUNTERS + i]);
+    queries.used++;
+    open = true;
+}
+
+void PipelineStatistics::submitted(ScenePass pass, const CommandList& commands)
+{
+    PassStatistics& statistics = counting[static_cast<int>(pass)];
+    statistics.draws += commands.drawCount();
+    statistics.indices += commands.indexCount();
+    statistics.triangles += commands.triangleCount();
+}
+
+void PipelineStatistics::end()
+{
+    if (!open)
+        return;
+    for (int i = 0; i < COUNTERS; i++)
+        glEndQuery(COUNTER_TARGETS[i]);
+    open = false;
+}
+
+// the counters written FRAMES frames ago, normally long finished; a result still pending leaves
+// the last figures standing rather than stall
+void PipelineStatistics::readQueries(QueryFrame& queries)
+{
+    if (queries.used > 0)
+    {
+        int available = 0;
+        glGetQueryObjectiv(queries.queries[queries.used * COUNTERS - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available)
+        {
+            for (PassStatistics& result : results)
+                result.primitives = result.clippedPrimitives = result.vertexInvocations = result.fragmentInvocations = 0;
+            for (size_t run = 0; run < queries.used; run++)
+            {
+                GLuint64 counters[COUNTERS] = {};
+                for (int i = 0; i < COUNTERS; i++)
+                    glGetQueryObjectui64v(queries.queries[run * COUNTERS + i], GL_QUERY_RESULT, &counters[i]);
+                PassStatistics& result = results[queries.passes[run]];
+                result.primitives += counters[0];
+                result.clippedPrimitives += counters[1];
+                result.vertexInvocations += counters[2];
+                result.fragmentInvocations += counters[3];
+            }
+        }
+    }
+    queries.used = 0;
+}
@@ -0,0 +1,82 @@
+#ifndef PIPELINE_STATISTICS_H
+#define PIPELINE_STATISTICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class CommandList;
+
+// the three passes that draw the scene: into the water planes' reflection and refraction targets
+// and onto the screen
+enum class ScenePass : int { Reflection, Refraction, Main };
+const int SCENE_PASS_COUNT = 3;
+
+struct PassStatistics
+{
+    // submitted, counted from the recorded lists; always there
+    uint64_t draws = 0;
+    uint64_t indices = 0;               // vertices and indices, instances included
+    uint64_t triangles = 0;
+    uint64_t pixels = 0;                // of the targets the pass drew into
+    // from ARB_pipeline_statistics_query, FRAMES frames behind; all 0 without it
+    uint64_t primitives = 0;            // what the vertex stage was handed
+    uint64_t clippedPrimitives = 0;     // what came out of clipping, so what rasterised
+    uint64_t vertexInvocations = 0;
+    uint64_t fragmentInvocations = 0;
+
+    // shaded fragments per target pixel: how many times over the pass paints its target
+    double overdraw() const { return pixels ? static_cast<double>(fragmentInvocations) / pixels : 0.0; }
+};
+
+// How much each scene pass asks of the GPU. With GL 4.6 or ARB_pipeline_statistics_query every
+// pass is bracketed with primitive, clipping, vertex and fragment counters, read FRAMES frames
+// later like the reflections' timers; the plane passes run once per plane and their counts add
+// up. Without the extension only what the command lists submitted is known, which is counted
+// either way.
+// ---------------------------------------------------------------------------------------------
+class PipelineStatistics
+{
+public:
+    static const int FRAMES = 4;
+    static const int COUNTERS = 4;
+    static const char* const PASS_NAMES[SCENE_PASS_COUNT];
+
+    PipelineStatistics() = default;
+    ~PipelineStatistics();
+    PipelineStatistics(const PipelineStatistics&) = delete;
+    PipelineStatistics& operator=(const PipelineStatistics&) = delete;
+
+    // GL thread: look for the extension
+    void create();
+    bool hardware() const { return supported; }
+
+    // GL thread, once a frame before the first pass: take in the counters that have landed
+    void beginFrame();
+    // around each pass; commands is what it replays (call submitted() for any more lists), width x
+    // height its target
+    void begin(ScenePass pass, const CommandList& commands, int width, int height);
+    void submitted(ScenePass pass, const CommandList& commands);
+    void end();
+
+    // the last whole frame's submissions, with the newest counters that have landed
+    const PassStatistics& pass(ScenePass pass) const { return results[static_cast<int>(pass)]; }
+
+private:
+    struct QueryFrame
+    {
+        std::vector<unsigned int> queries;  // COUNTERS per pass run
+        std::vector<int> passes;            // which pass each run was
+        size_t used = 0;                    // runs this frame
+    };
+    void readQueries(QueryFrame& queries);
+
+    bool supported = false;
+    bool open = false;
+    unsigned int frame = 0;
+    QueryFrame frames[FRAMES];
+    PassStatistics counting[SCENE_PASS_COUNT];     // this frame's submissions
+    PassStatistics results[SCENE_PASS_COUNT];
+};
+
+#endif
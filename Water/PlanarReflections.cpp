@@ -0,0 +1,569 @@
+#include "PlanarReflections.h"
+
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+// heights closer than this share a plane
+static const double MERGE_DISTANCE = 1e-3;
+
+ReflectionSchedule ReflectionSchedule::single(double height)
+{
+    ReflectionSchedule schedule;
+    schedule.heights.push_back(height);
+    schedule.oceanPlane = 0;
+    schedule.renders.push_back(0);
+    schedule.jitter.push_back(glm::vec2(0.0f));
+    return schedule;
+}
+
+// i-th point of the base-b Halton sequence, in [0, 1)
+static float halton(unsigned int i, unsigned int base)
+{
+    float result = 0.0f;
+    float fraction = 1.0f;
+    for (i++; i > 0; i /= base)
+    {
+        fraction /= static_cast<float>(base);
+        result += fraction * static_cast<float>(i % base);
+    }
+    return result;
+}
+
+PlanarReflections::~PlanarReflections()
+{
+    destroy();
+}
+
+void PlanarReflections::destroy()
+{
+    for (Plane& plane : planes)
+    {
+        Target* targets[2] = { &plane.reflection, &plane.refraction };
+        for (Target* target : targets)
+        {
+            glDeleteFramebuffers(1, &target->framebuffer);
+            glDeleteTextures(1, &target->color);
+            glDeleteTextures(1, &target->depth);
+            glDeleteFramebuffers(2, target->historyFramebuffer);
+            glDeleteTextures(2, target->history);
+            glDeleteFramebuffers(2, target->reconstructedFramebuffer);
+            glDeleteTextures(2, target->reconstructed);
+        }
+    }
+    planes.clear();
+    for (TimerFrame& timer : timers)
+    {
+        glDeleteQueries(static_cast<int>(timer.queries.size()), timer.queries.data());
+        timer.queries.clear();
+        timer.used = 0;
+    }
+    if (emptyVertexArray)
+        glDeleteVertexArrays(1, &emptyVertexArray);
+    emptyVertexArray = 0;
+    if (sharedDepthRenderbuffer)
+        glDeleteRenderbuffers(1, &sharedDepthRenderbuffer);
+    sharedDepthRenderbuffer = 0;
+}
+
+// setup
+// -----
+void PlanarReflections::create(const SceneDescription& scene, int screenWidth, int screenHeight, unsigned int temporalProgram,
+    unsigned int reconstructProgram)
+{
+    destroy();
+    width = screenWidth;
+    height = screenHeight;
+    resolveProgram = temporalProgram;
+    checkerboardProgram = reconstructProgram;
+    formats = Formats;
+    frame = 0;
+    scheduledMode = Mode;
+    scheduledTemporal = accumulating();
+    scheduledCheckerboard = checkerboarding();
+    plan = ReflectionSchedule();
+
+    // every body, then the ocean, joins the first plane at its height
+    std::vector<double> heights;
+    for (const SceneWater& body : scene.water)
+        heights.push_back(body.center.y);
+    if (scene.ocean.enabled())
+        heights.push_back(scene.ocean.height);
+    for (size_t i = 0; i < heights.size(); i++)
+    {
+        unsigned int plane = 0;
+        while (plane < plan.heights.size() && std::abs(plan.heights[plane] - heights[i]) > MERGE_DISTANCE)
+            plane++;
+        if (plane == plan.heights.size())
+            plan.heights.push_back(heights[i]);
+        if (i < scene.water.size())
+            plan.bodyPlanes.push_back(plane);
+        else
+            plan.oceanPlane = plane;
+    }
+    frameStats = PlanarReflectionStats();
+    frameStats.bodies = heights.size();
+    frameStats.planes = plan.heights.size();
+
+    // full size, so it fits every plane whatever its scale; attachments of different sizes draw
+    // into their common corner
+    if (formats.sharedDepth)
+    {
+        glGenRenderbuffers(1, &sharedDepthRenderbuffer);
+        formats.allocateDepthRenderbuffer(sharedDepthRenderbuffer, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    }
+
+    depthShared = refractionDepthShared();
+    planes.resize(plan.heights.size());
+    for (unsigned int i = 0; i < planes.size(); i++)
+    {
+        createTarget(planes[i].reflection, false);
+        createTarget(planes[i].refraction, checkerboardProgram != 0);
+        planes[i].scale = 0;
+        allocate(i, 1);
+    }
+    if (resolveProgram || checkerboardProgram)
+        glGenVertexArrays(1, &emptyVertexArray);
+    countTargetBytes();
+}
+
+void PlanarReflections::createTarget(Target& target, bool reconstructs)
+{
+    glGenFramebuffers(1, &target.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+    glDrawBuffer(GL_COLOR_ATTACHMENT0);
+
+    glGenTextures(1, &target.color);
+    glBindTexture(GL_TEXTURE_2D, target.color);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenTextures(1, &target.depth);
+    glBindTexture(GL_TEXTURE_2D, target.depth);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // storage comes with allocate(), like the render's own
+    if (reconstructs)
+    {
+        glGenTextures(2, target.reconstructed);
+        glGenFramebuffers(2, target.reconstructedFramebuffer);
+        for (int i = 0; i < 2; i++)
+        {
+            glBindTexture(GL_TEXTURE_2D, target.reconstructed[i]);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!resolveProgram)
+        return;
+
+    // histories stay at the screen size whatever the render scale
+    glGenTextures(2, target.history);
+    glGenFramebuffers(2, target.historyFramebuffer);
+    for (int i = 0; i < 2; i++)
+    {
+        formats.allocateColor(target.history[i], width, height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindFramebuffer(GL_FRAMEBUFFER, target.historyFramebuffer[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.history[i], 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// (re)allocate both targets' storage at the screen size divided by scale; the texture names stay,
+// so framebuffers and recorded binds keep working
+void PlanarReflections::allocate(unsigned int index, int scale)
+{
+    Plane& plane = planes[index];
+    if (plane.scale == scale)
+        return;
+    plane.scale = scale;
+    glm::ivec2 extent = size(index);
+    Target* targets[2] = { &plane.reflection, &plane.refraction };
+    for (Target* target : targets)
+    {
+        formats.allocateColor(target->color, extent.x, extent.y);
+        glBindFramebuffer(GL_FRAMEBUFFER, target->framebuffer);
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, target->color, 0);
+        // the water samples reflection depth, resolves refraction depth; the stencil, if any,
+        // holds the checkerboard pattern. Unsampled depth goes to the shared renderbuffer and the
+        // texture gives up its storage.
+        if (target == &plane.refraction && depthShared)
+        {
+            formats.allocateDepth(target->depth, 1, 1);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, formats.depthAttachment(), GL_RENDERBUFFER, sharedDepthRenderbuffer);
+        }
+        else
+        {
+            formats.allocateDepth(target->depth, extent.x, extent.y);
+            glFramebufferTexture(GL_FRAMEBUFFER, formats.depthAttachment(), target->depth, 0);
+        }
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
+        // the pass clear colour until the plane's first render
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+        // what the last render reconstructed is gone with its size
+        target->reconstructedValid = false;
+        for (int i = 0; target->reconstructed[0] && i < 2; i++)
+        {
+            formats.allocateColor(target->reconstructed[i], extent.x, extent.y);
+            glBindFramebuffer(GL_FRAMEBUFFER, target->reconstructedFramebuffer[i]);
+            glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, target->reconstructed[i], 0);
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+glm::ivec2 PlanarReflections::size(unsigned int plane) const
+{
+    int scale = std::max(planes[plane].scale, 1);
+    return glm::max(glm::ivec2(width, height) / scale, glm::ivec2(1));
+}
+
+// scheduling
+// ----------
+void PlanarReflections::schedule(const std::vector<float>& coverage)
+{
+    frame++;
+    bool known = coverage.size() == planes.size();
+    frameStats.planesVisible = 0;
+    frameStats.maxStaleFrames = 0;
+    readTimers();
+
+    // images kept while another mode was active, or from before accumulation or the checkerboard
+    // was switched, are out of date, render them again first
+    if (Mode != scheduledMode || accumulating() != scheduledTemporal || checkerboarding() != scheduledCheckerboard)
+    {
+        for (Plane& plane : planes)
+        {
+            plane.lastRender = 0;
+            plane.reflection.historyValid = plane.refraction.historyValid = false;
+            plane.refraction.reconstructedValid = false;
+        }
+        scheduledMode = Mode;
+        scheduledTemporal = accumulating();
+        scheduledCheckerboard = checkerboarding();
+    }
+    // refraction depth that is sampled now and was shared before, or the other way round, needs its
+    // attachment changed: force the reallocation on the next render
+    if (refractionDepthShared() != depthShared)
+    {
+        for (Plane& plane : planes)
+            plane.scale = 0;
+        depthShared = refractionDepthShared();
+    }
+    plan.refraction = Mode == ReflectionMode::Planar;
+    plan.obliqueClip = ObliqueClip;
+    plan.jitter.clear();
+    if (Mode == ReflectionMode::ScreenSpace)
+    {
+        plan.renders.clear();
+        frameStats.planesVisible = frameStats.renders = frameStats.deferred = 0;
+        return;
+    }
+
+    // planes never rendered go first, then the ones past MaxStaleFrames, then coverage weighted by
+    // how stale the images are; coverage is at most 1, so the tiers cannot mix
+    priorities.assign(planes.size(), 0.0f);
+    for (size_t i = 0; i < planes.size(); i++)
+    {
+        float visible = known ? coverage[i] : 1.0f;
+        if (visible <= 0.0f)
+            continue;
+        frameStats.planesVisible++;
+        if (planes[i].lastRender == 0)
+        {
+            priorities[i] = std::numeric_limits<float>::max();
+            continue;
+        }
+        uint64_t stale = frame - planes[i].lastRender;
+        if (stale > static_cast<uint64_t>(MaxStaleFrames))
+            priorities[i] = static_cast<float>(MaxStaleFrames + stale);
+        else
+            priorities[i] = visible * static_cast<float>(stale) / static_cast<float>(MaxStaleFrames + 1);
+    }
+
+    plan.renders.clear();
+    for (size_t i = 0; i < planes.size(); i++)
+    {
+        if (priorities[i] > 0.0f)
+            plan.renders.push_back(static_cast<unsigned int>(i));
+    }
+    std::stable_sort(plan.renders.begin(), plan.renders.end(), [&](unsigned int a, unsigned int b) { return priorities[a] > priorities[b]; });
+    size_t budget = static_cast<size_t>(std::max(UpdateBudget, 1));
+    frameStats.deferred = plan.renders.size() > budget ? plan.renders.size() - budget : 0;
+    if (plan.renders.size() > budget)
+        plan.renders.resize(budget);
+    frameStats.renders = plan.renders.size();
+
+    // resolution follows coverage, changed only on a plane about to be re-rendered anyway; blended
+    // reflections only fill in what the rays miss and always render small
+    for (unsigned int i : plan.renders)
+    {
+        float visible = known && Mode == ReflectionMode::Planar ? coverage[i] : 0.0f;
+        int scale = 4;
+        if (visible >= FullResolutionCoverage)
+            scale = 1;
+        else if (visible >= FullResolutionCoverage * 0.25f)
+            scale = 2;
+        // accumulation renders a quarter of the pixels and lets the history make up the rest
+        if (accumulating())
+            scale = std::max(scale, 2);
+        allocate(i, scale);
+        Plane& plane = planes[i];
+        plane.lastRender = frame;
+
+        // the resolve about to run writes the other history, which the water then samples
+        plane.jitter = glm::vec2(0.0f);
+        if (accumulating())
+        {
+            glm::ivec2 extent = size(i);
+            glm::vec2 offset(halton(plane.renders % 8, 2) - 0.5f, halton(plane.renders % 8, 3) - 0.5f);
+            plane.jitter = offset * 2.0f / glm::vec2(extent);
+            plane.reflection.latest ^= 1;
+            if (plan.refraction)
+                plane.refraction.latest ^= 1;
+        }
+        // the other half of the checkerboard, reconstructed into the other image
+        if (checkerboarding() && plan.refraction)
+        {
+            plane.parity ^= 1;
+            plane.refraction.reconstructedLatest ^= 1;
+        }
+        plane.renders++;
+        plan.jitter.push_back(plane.jitter);
+    }
+
+    // age of what the visible planes show this frame
+    for (size_t i = 0; i < planes.size(); i++)
+    {
+        if (priorities[i] > 0.0f && planes[i].lastRender != 0)
+            frameStats.maxStaleFrames = std::max(frameStats.maxStaleFrames, static_cast<size_t>(frame - planes[i].lastRender));
+    }
+
+    countTargetBytes();
+}
+
+// colour and depth of both targets (RGB8 is padded to four bytes on most drivers, like R11G11B10F),
+// minus refraction depth while it is shared, plus two full-size histories each when accumulating
+// and two reconstructed refractions of the render size when checkerboarding
+void PlanarReflections::countTargetBytes()
+{
+    size_t colorBytes = formats.colorBytes(), depthBytes = formats.depthBytes();
+    frameStats.targetBytes = sharedDepthRenderbuffer ? static_cast<size_t>(width) * height * depthBytes : 0;
+    for (size_t i = 0; i < planes.size(); i++)
+    {
+        glm::ivec2 extent = size(static_cast<unsigned int>(i));
+        size_t pixels = static_cast<size_t>(extent.x) * extent.y;
+        frameStats.targetBytes += pixels * (colorBytes * 2 + depthBytes * (depthShared ? 1 : 2));
+        if (accumulating())
+            frameStats.targetBytes += static_cast<size_t>(width) * height * colorBytes * 2 * 2;
+        if (checkerboarding())
+            frameStats.targetBytes += pixels * colorBytes * 2;
+    }
+}
+
+// checkerboard
+// ------------
+void PlanarReflections::prepareRefraction(unsigned int index)
+{
+    if (!checkerboarding() || !plan.refraction)
+        return;
+    // stencil 1 on the pixels this render shades; only the stencil is written
+    glEnable(GL_STENCIL_TEST);
+    glStencilFunc(GL_ALWAYS, 1, 0xFF);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    glDisable(GL_DEPTH_TEST);
+    // the oblique-clip variants write no clip distance, so the caller's clip state comes back as it was
+    bool clipping = glIsEnabled(GL_CLIP_DISTANCE0) == GL_TRUE;
+    glDisable(GL_CLIP_DISTANCE0);
+    glUseProgram(checkerboardProgram);
+    glUniform1i(glGetUniformLocation(checkerboardProgram, "mask"), 1);
+    glUniform1i(glGetUniformLocation(checkerboardProgram, "parity"), planes[index].parity);
+    glBindVertexArray(emptyVertexArray);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    // the pass then shades only where the mask is set
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthMask(GL_TRUE);
+    glEnable(GL_DEPTH_TEST);
+    if (clipping)
+        glEnable(GL_CLIP_DISTANCE0);
+    glStencilFunc(GL_EQUAL, 1, 0xFF);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+}
+
+void PlanarReflections::reconstruct(Target& target, const glm::mat4& reprojection, const glm::vec2& jitter, int parity)
+{
+    TimerFrame& timer = timers[frame % TIMER_FRAMES];
+    if (timer.queries.size() < timer.used + 2)
+    {
+        timer.queries.resize(timer.used + 2);
+        glGenQueries(2, &timer.queries[timer.used]);
+    }
+    glQueryCounter(timer.queries[timer.used++], GL_TIMESTAMP);
+
+    glUseProgram(checkerboardProgram);
+    glUniform1i(glGetUniformLocation(checkerboardProgram, "mask"), 0);
+    glUniform1i(glGetUniformLocation(checkerboardProgram, "parity"), parity);
+    glUniform1i(glGetUniformLocation(checkerboardProgram, "current"), 0);
+    glUniform1i(glGetUniformLocation(checkerboardProgram, "currentDepth"), 1);
+    glUniform1i(glGetUniformLocation(checkerboardProgram, "previous"), 2);
+    glUniform1i(glGetUniformLocation(checkerboardProgram, "previousValid"), target.reconstructedValid ? 1 : 0);
+    glUniformMatrix4fv(glGetUniformLocation(checkerboardProgram, "reprojection"), 1, GL_FALSE, glm::value_ptr(reprojection));
+    glUniform2f(glGetUniformLocation(checkerboardProgram, "jitter"), jitter.x * 0.5f, jitter.y * 0.5f);
+    glUniform2f(glGetUniformLocation(checkerboardProgram, "previousJitter"), target.previousJitter.x * 0.5f, target.previousJitter.y * 0.5f);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, target.reconstructedFramebuffer[target.reconstructedLatest]);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, target.color);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, target.depth);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, target.reconstructed[target.reconstructedLatest ^ 1]);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    target.reconstructedValid = true;
+
+    glQueryCounter(timer.queries[timer.used++], GL_TIMESTAMP);
+}
+
+// the timestamps written TIMER_FRAMES frames ago, normally long finished; a result still pending
+// leaves the last figure standing rather than stall
+void PlanarReflections::readTimers()
+{
+    TimerFrame& timer = timers[frame % TIMER_FRAMES];
+    if (timer.used > 0)
+    {
+        int available = 0;
+        glGetQueryObjectiv(timer.queries[timer.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available)
+        {
+            uint64_t nanoseconds = 0;
+            for (size_t i = 0; i + 1 < timer.used; i += 2)
+            {
+                GLuint64 begin = 0, end = 0;
+                glGetQueryObjectui64v(timer.queries[i], GL_QUERY_RESULT, &begin);
+                glGetQueryObjectui64v(timer.queries[i + 1], GL_QUERY_RESULT, &end);
+                nanoseconds += end > begin ? end - begin : 0;
+            }
+            frameStats.reconstructMs = nanoseconds * 1e-6;
+        }
+    }
+    else if (!checkerboarding())
+        frameStats.reconstructMs = 0.0;
+    timer.used = 0;
+}
+
+// accumulation
+// ------------
+void PlanarReflections::resolve(unsigned int index, const glm::mat4& reflectionViewProjection, const glm::mat4& refractionViewProjection, const glm::dvec3& origin)
+{
+    Plane& plane = planes[index];
+    bool checkerboard = checkerboarding() && plan.refraction;
+    if (!accumulating() && !checkerboard)
+        return;
+    glDisable(GL_STENCIL_TEST);
+    glDisable(GL_DEPTH_TEST);
+    // left as found for the next plane's passes, as in prepareRefraction()
+    bool clipping = glIsEnabled(GL_CLIP_DISTANCE0) == GL_TRUE;
+    glDisable(GL_CLIP_DISTANCE0);
+    glBindVertexArray(emptyVertexArray);
+
+    // current clip space to where the same point sat in the previous render's clip space, whose
+    // render origin may have moved since
+    Target* targets[2] = { &plane.reflection, &plane.refraction };
+    const glm::mat4* viewProjections[2] = { &reflectionViewProjection, &refractionViewProjection };
+    glm::mat4 reprojections[2];
+    for (int i = 0; i < 2; i++)
+    {
+        glm::vec3 shift = glm::vec3(origin - targets[i]->previousOrigin);
+        reprojections[i] = targets[i]->previousViewProjection * glm::translate(glm::mat4(1.0f), shift) * glm::inverse(*viewProjections[i]);
+    }
+
+    // the checkerboard is filled in at the render size, before accumulation reads it
+    if (checkerboard)
+    {
+        glm::ivec2 extent = size(index);
+        glViewport(0, 0, extent.x, extent.y);
+        reconstruct(plane.refraction, reprojections[1], plane.jitter, plane.parity);
+    }
+
+    if (accumulating())
+    {
+        glUseProgram(resolveProgram);
+        glUniform1i(glGetUniformLocation(resolveProgram, "current"), 0);
+        glUniform1i(glGetUniformLocation(resolveProgram, "currentDepth"), 1);
+        glUniform1i(glGetUniformLocation(resolveProgram, "history"), 2);
+        glUniform1f(glGetUniformLocation(resolveProgram, "historyWeight"), HistoryWeight);
+        glViewport(0, 0, width, height);
+        resolveTarget(plane.reflection, plane.reflection.color, reprojections[0], plane.jitter);
+        if (plan.refraction)
+            resolveTarget(plane.refraction, plane.refraction.shaded(checkerboard), reprojections[1], plane.jitter);
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (i == 1 && !plan.refraction)
+            continue;
+        targets[i]->previousViewProjection = *viewProjections[i];
+        targets[i]->previousOrigin = origin;
+        targets[i]->previousJitter = plane.jitter;
+    }
+
+    glBindVertexArray(0);
+    for (int unit = 2; unit >= 0; unit--)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glEnable(GL_DEPTH_TEST);
+    if (clipping)
+        glEnable(GL_CLIP_DISTANCE0);
+}
+
+void PlanarReflections::resolveTarget(Target& target, unsigned int current, const glm::mat4& reprojection, const glm::vec2& jitter)
+{
+    glUniformMatrix4fv(glGetUniformLocation(resolveProgram, "reprojection"), 1, GL_FALSE, glm::value_ptr(reprojection));
+    glUniform2f(glGetUniformLocation(resolveProgram, "jitter"), jitter.x * 0.5f, jitter.y * 0.5f);
+    glUniform1i(glGetUniformLocation(resolveProgram, "historyValid"), target.historyValid ? 1 : 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, target.historyFramebuffer[target.latest]);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, current);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, target.depth);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, target.history[target.latest ^ 1]);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    target.historyValid = true;
+}
@@ -0,0 +1,203 @@
+#ifndef PLANAR_REFLECTIONS_H
+#define PLANAR_REFLECTIONS_H
+
+#include <glm/glm.hpp>
+
+#include "RenderFormats.h"
+#include "SceneFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Where the water's reflection comes from. The screen-space modes ray-march the main pass instead
+// of re-rendering the scene and read refraction from it as well; Blended keeps a quarter-resolution
+// planar reflection for the rays that leave the screen.
+enum class ReflectionMode { Planar, ScreenSpace, Blended };
+
+// The water planes of a scene and which of them get their reflection and refraction re-rendered
+// this frame; what buildFrameDrawLists reads
+struct ReflectionSchedule
+{
+    static const unsigned int NO_PLANE = ~0u;
+
+    std::vector<double> heights;            // world height per plane
+    std::vector<unsigned int> bodyPlanes;   // plane of each scene water body
+    unsigned int oceanPlane = NO_PLANE;
+    std::vector<unsigned int> renders;      // planes to render this frame, highest priority first
+    std::vector<glm::vec2> jitter;          // NDC offset of each render's projection, 0 without accumulation
+    bool refraction = true;                 // renders include the refraction pass
+    bool obliqueClip = false;               // the passes clip with their near plane, GL_CLIP_DISTANCE0 off
+
+    unsigned int planeOfBody(unsigned int body) const { return body < bodyPlanes.size() ? bodyPlanes[body] : 0; }
+
+    // one plane at height that every body and the ocean use, rendered every frame
+    static ReflectionSchedule single(double height);
+};
+
+struct PlanarReflectionStats
+{
+    size_t bodies = 0;          // water bodies and ocean before merging
+    size_t planes = 0;
+    size_t planesVisible = 0;   // planes with water on screen last frame
+    size_t renders = 0;         // planes re-rendered this frame
+    size_t deferred = 0;        // visible planes left for a later frame by the budget
+    size_t maxStaleFrames = 0;  // frames since the image shown on a visible plane was rendered, worst plane
+    size_t targetBytes = 0;     // colour and depth of every plane's two targets, and their histories
+    double reconstructMs = 0.0; // GPU time filling in checkerboarded refraction, from a few frames back
+};
+
+// Reflection and refraction targets for every distinct water plane. Water bodies (and the ocean)
+// at the same height share a plane and so one pair of renders. Each frame the planes visible in the
+// last main pass are ranked by screen coverage times frames since their last render, so small
+// planes update less often, and the top UpdateBudget are re-rendered; the rest keep showing their
+// previous images. Planes older than MaxStaleFrames go first so none starves. A plane's targets
+// shrink to half or quarter resolution as its coverage drops.
+//
+// With Temporal set (and a resolve program) the targets render at no more than half size with a
+// sub-pixel jitter, and resolve() folds each render into a full-size history: the history is
+// reprojected through the camera the plane was last rendered with, clamped to the new image's
+// neighbourhood so disoccluded and moved content does not smear, and blended with it. The water
+// then samples the histories.
+//
+// With Checkerboard set (and a checkerboard program) the refraction pass shades only every other
+// pixel, the pattern flipping each render: prepareRefraction() puts the pattern in the stencil
+// buffer, and resolve() fills in the other half from the previous render, reprojected through the
+// depth of the shaded neighbours and clamped to them, or from those neighbours alone where the
+// history has nothing. The refraction is seen through a 50/50 blend with the reflection, so half
+// its pixels go a long way.
+//
+// Targets are stored in Formats. With sharedDepth the refraction passes draw into one depth
+// renderbuffer while neither the water, accumulation nor the checkerboard samples their depth.
+// ----------------------------------------------------------------------------------------------
+class PlanarReflections
+{
+public:
+    // tuning, read by schedule()
+    int UpdateBudget = 2;                   // planes re-rendered per frame
+    float FullResolutionCoverage = 0.25f;   // screen fraction from which a plane renders at full size
+    int MaxStaleFrames = 8;                 // a visible plane this old jumps ahead of coverage
+    ReflectionMode Mode = ReflectionMode::Planar;   // ScreenSpace renders no planes, Blended only quarter-size reflections
+    bool Temporal = true;                   // accumulate jittered reduced renders, needs a resolve program
+    float HistoryWeight = 0.85f;            // share of the reprojected history in each resolve
+    bool Checkerboard = false;              // shade half the refraction per render, needs a checkerboard program and stencil
+    bool RefractionDepthSampled = true;     // the water reads refraction depth (soft edges, absorption)
+    bool ObliqueClip = false;               // clip at the water with the projection instead of a clip distance
+    RenderFormats Formats;                  // read by create()
+
+    PlanarReflections() = default;
+    ~PlanarReflections();
+    PlanarReflections(const PlanarReflections&) = delete;
+    PlanarReflections& operator=(const PlanarReflections&) = delete;
+
+    // GL thread: merge the scene's water into planes and create their targets at width x height;
+    // resolveProgram (hiz.vs / temporal.fs) enables temporal accumulation and checkerboardProgram
+    // (hiz.vs / checkerboard.fs) checkerboard refraction, 0 leaves them off
+    void create(const SceneDescription& scene, int width, int height, unsigned int resolveProgram = 0, unsigned int checkerboardProgram = 0);
+    // GL thread, before the frame's draw lists are built. coverage is the screen fraction of each
+    // plane in the last main pass (FrameDrawLists::planeCoverage); empty means unknown, everything
+    // counts as visible. Resizes the targets of the planes it picks.
+    void schedule(const std::vector<float>& coverage);
+    const ReflectionSchedule& current() const { return plan; }
+    // GL thread, with a scheduled plane's refraction target bound and cleared (stencil included),
+    // before its pass: mask out the pixels it skips this render. Leaves the stencil test on, and
+    // GL_CLIP_DISTANCE0 as it found it.
+    void prepareRefraction(unsigned int plane);
+    // GL thread, after a scheduled plane's passes: fill in the checkerboard and fold them into
+    // the histories. The matrices are the passes' view-projections without jitter, in the render
+    // space of origin. GL_CLIP_DISTANCE0 is left as it was found.
+    void resolve(unsigned int plane, const glm::mat4& reflectionViewProjection, const glm::mat4& refractionViewProjection, const glm::dvec3& origin);
+    bool accumulating() const { return Temporal && resolveProgram != 0; }
+    bool checkerboarding() const { return Checkerboard && checkerboardProgram != 0 && formats.stencil(); }
+
+    size_t planeCount() const { return planes.size(); }
+    unsigned int reflectionFramebuffer(unsigned int plane) const { return planes[plane].reflection.framebuffer; }
+    unsigned int refractionFramebuffer(unsigned int plane) const { return planes[plane].refraction.framebuffer; }
+    // what the water samples: the history this frame's resolve writes when accumulating, the render otherwise
+    unsigned int reflectionTexture(unsigned int plane) const { return planes[plane].reflection.image(accumulating(), false); }
+    unsigned int refractionTexture(unsigned int plane) const { return planes[plane].refraction.image(accumulating(), checkerboarding()); }
+    unsigned int reflectionDepthTexture(unsigned int plane) const { return planes[plane].reflection.depth; }
+    unsigned int refractionDepthTexture(unsigned int plane) const { return planes[plane].refraction.depth; }
+    glm::ivec2 size(unsigned int plane) const;
+    const PlanarReflectionStats& stats() const { return frameStats; }
+    // full-size depth the refraction passes share while nothing samples theirs, 0 without Formats.sharedDepth
+    unsigned int sharedDepth() const { return sharedDepthRenderbuffer; }
+
+private:
+    struct Target
+    {
+        unsigned int framebuffer = 0;
+        unsigned int color = 0;
+        unsigned int depth = 0;
+
+        // full-size accumulation, ping-ponged: history[latest] is written by this frame's resolve
+        unsigned int history[2] = {};
+        unsigned int historyFramebuffer[2] = {};
+        int latest = 0;
+        bool historyValid = false;
+
+        // refraction only: the checkerboarded render filled in, at the render size, ping-ponged the same way
+        unsigned int reconstructed[2] = {};
+        unsigned int reconstructedFramebuffer[2] = {};
+        int reconstructedLatest = 0;
+        bool reconstructedValid = false;
+
+        // the camera of the last resolved render
+        glm::mat4 previousViewProjection = glm::mat4(1.0f);
+        glm::dvec3 previousOrigin = glm::dvec3(0.0);
+        glm::vec2 previousJitter = glm::vec2(0.0f);
+
+        // the render, complete
+        unsigned int shaded(bool checkerboard) const { return checkerboard ? reconstructed[reconstructedLatest] : color; }
+        unsigned int image(bool accumulating, bool checkerboard) const { return accumulating ? history[latest] : shaded(checkerboard); }
+    };
+    struct Plane
+    {
+        Target reflection, refraction;
+        int scale = 1;              // 1, 2 or 4: divides the screen size
+        uint64_t lastRender = 0;    // frame of the last render, 0 never
+        unsigned int renders = 0;   // picks the jitter
+        glm::vec2 jitter = glm::vec2(0.0f);     // of the latest render, NDC
+        int parity = 0;             // which half of the checkerboard the latest refraction shaded
+    };
+
+    // GPU timestamps around the reconstructions of one frame, read back a few frames later
+    struct TimerFrame
+    {
+        std::vector<unsigned int> queries;
+        size_t used = 0;
+    };
+    static const int TIMER_FRAMES = 3;
+
+    void createTarget(Target& target, bool reconstructs);
+    bool refractionDepthShared() const
+    {
+        return sharedDepthRenderbuffer != 0 && !RefractionDepthSampled && !accumulating() && !checkerboarding();
+    }
+    void allocate(unsigned int plane, int scale);
+    void reconstruct(Target& target, const glm::mat4& reprojection, const glm::vec2& jitter, int parity);
+    void resolveTarget(Target& target, unsigned int current, const glm::mat4& reprojection, const glm::vec2& jitter);
+    void readTimers();
+    void countTargetBytes();
+    void destroy();
+
+    std::vector<Plane> planes;
+    ReflectionSchedule plan;
+    int width = 0, height = 0;
+    RenderFormats formats;                  // Formats as of create()
+    unsigned int sharedDepthRenderbuffer = 0;
+    bool depthShared = false;               // what the refraction targets are attached to
+    uint64_t frame = 0;
+    ReflectionMode scheduledMode = ReflectionMode::Planar;
+    bool scheduledTemporal = false;
+    bool scheduledCheckerboard = false;
+    std::vector<float> priorities;
+    PlanarReflectionStats frameStats;
+
+    unsigned int resolveProgram = 0;
+    unsigned int checkerboardProgram = 0;
+    TimerFrame timers[TIMER_FRAMES];
+    unsigned int emptyVertexArray = 0;      // the full-screen triangle comes from gl_VertexID
+};
+
+#endif
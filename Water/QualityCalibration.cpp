@@ -0,0 +1,206 @@
+#include "QualityCalibration.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// the GPU and driver a calibration holds for, one line
+static std::string deviceKey()
+{
+    std::string key;
+    const GLenum strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    for (int i = 0; i < 3; i++)
+    {
+        const GLubyte* value = glGetString(strings[i]);
+        key += i ? " | " : "";
+        key += value ? reinterpret_cast<const char*>(value) : "unknown";
+    }
+    for (char& c : key)
+    {
+        if (c == '\t' || c == '\n' || c == '\r')
+            c = ' ';
+    }
+    return key;
+}
+
+// water shading features, the oblique clip changes the plane passes rather than the pixel cost
+static int waterFeatureCount(unsigned int features)
+{
+    int count = 0;
+    for (int i = 0; i < FEATURE_COUNT; i++)
+    {
+        if ((features & (1u << i)) && (1u << i) != FEATURE_OBLIQUE_CLIP)
+            count++;
+    }
+    return count;
+}
+
+QualityCalibration::QualityCalibration(const std::string& path)
+    : file(path)
+{
+}
+
+// store
+// -----
+// a line per device: budget, preset name and the device key, tab separated
+bool QualityCalibration::load(QualityPreset& preset) const
+{
+    std::ifstream in(file);
+    if (!in)
+        return false;
+    std::string key = deviceKey(), line;
+    while (std::getline(in, line))
+    {
+        std::istringstream fields(line);
+        std::string budget, name, device;
+        if (!std::getline(fields, budget, '\t') || !std::getline(fields, name, '\t') || !std::getline(fields, device))
+            continue;
+        // a different budget asks a different question
+        if (device == key && std::abs(std::atof(budget.c_str()) - BudgetMs) < 0.01)
+        {
+            preset = QualityPreset::preset(name);
+            return true;
+        }
+    }
+    return false;
+}
+
+void QualityCalibration::save() const
+{
+    std::string key = deviceKey(), line, kept;
+    {
+        std::ifstream in(file);
+        while (std::getline(in, line))
+        {
+            size_t device = line.find('\t', line.find('\t') + 1);
+            if (device != std::string::npos && line.substr(device + 1) != key)
+                kept += line + '\n';
+        }
+    }
+    std::ofstream out(file);
+    out << kept << BudgetMs << '\t' << chosen.name << '\t' << key << '\n';
+    if (!out)
+        std::cout << "ERROR::QUALITY_CALIBRATION::NOT_WRITTEN: " << file << std::endl;
+}
+
+// measuring
+// ---------
+void QualityCalibration::begin(int screenPixels)
+{
+    pixels = screenPixels;
+    candidates.clear();
+    for (int i = 0; i < QualityPreset::COUNT; i++)
+        candidates.push_back(QualityPreset::preset(QualityPreset::NAMES[i]));
+    // the presets move every setting together; these two pull the plane size and the shading apart
+    QualityPreset checkerboarded = QualityPreset::preset("high");
+    checkerboarded.checkerboard = true;
+    candidates.push_back(checkerboarded);
+    QualityPreset plain = QualityPreset::preset("ultra");
+    plain.features = QualityPreset::preset("low").features;
+    candidates.push_back(plain);
+
+    measured.clear();
+    candidate = 0;
+    frame = 0;
+    frameSum = 0.0;
+}
+
+void QualityCalibration::frameDone(double frameMs)
+{
+    if (!running())
+        return;
+    if (frame++ >= WARMUP_FRAMES)
+        frameSum += frameMs;
+    if (frame < WARMUP_FRAMES + MEASURED_FRAMES)
+        return;
+
+    measured.push_back(frameSum / MEASURED_FRAMES);
+    candidate++;
+    frame = 0;
+    frameSum = 0.0;
+    if (!running())
+        fit();
+}
+
+// model
+// -----
+// the plane targets cover the screen at full size, a quarter of it when accumulating; the
+// refraction shades half its pixels when checkerboarded
+void QualityCalibration::terms(const QualityPreset& preset, double (&x)[TERMS]) const
+{
+    double megapixels = pixels / 1.0e6;
+    x[0] = 1.0;
+    x[1] = megapixels * (preset.temporal ? 0.25 : 1.0) * (1.0 + (preset.checkerboard ? 0.5 : 1.0));
+    x[2] = megapixels * waterFeatureCount(preset.features);
+    x[3] = preset.temporal ? 1.0 : 0.0;
+}
+
+void QualityCalibration::fit()
+{
+    // normal equations, solved by elimination with partial pivoting; a term no candidate moved
+    // keeps a zero coefficient
+    double a[TERMS][TERMS + 1] = {};
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        double x[TERMS];
+        terms(candidates[i], x);
+        for (int r = 0; r < TERMS; r++)
+        {
+            for (int c = 0; c < TERMS; c++)
+                a[r][c] += x[r] * x[c];
+            a[r][TERMS] += x[r] * measured[i];
+        }
+    }
+    for (int c = 0; c < TERMS; c++)
+    {
+        int pivot = c;
+        for (int r = c + 1; r < TERMS; r++)
+        {
+            if (std::abs(a[r][c]) > std::abs(a[pivot][c]))
+                pivot = r;
+        }
+        for (int k = 0; k <= TERMS; k++)
+            std::swap(a[c][k], a[pivot][k]);
+        if (std::abs(a[c][c]) < 1e-12)
+            continue;
+        for (int r = 0; r < TERMS; r++)
+        {
+            if (r == c)
+                continue;
+            double factor = a[r][c] / a[c][c];
+            for (int k = c; k <= TERMS; k++)
+                a[r][k] -= factor * a[c][k];
+        }
+    }
+    for (int c = 0; c < TERMS; c++)
+        model[c] = std::abs(a[c][c]) < 1e-12 ? 0.0 : a[c][TERMS] / a[c][c];
+
+    auto predict = [this](const QualityPreset& preset)
+    {
+        double x[TERMS];
+        terms(preset, x);
+        double ms = 0.0;
+        for (int i = 0; i < TERMS; i++)
+            ms += model[i] * x[i];
+        return ms;
+    };
+    worstResidual = 0.0;
+    for (size_t i = 0; i < candidates.size(); i++)
+        worstResidual = std::max(worstResidual, std::abs(predict(candidates[i]) - measured[i]));
+
+    // presets run from cheapest to best; the best that fits wins, low if none does
+    predictions.clear();
+    chosen = QualityPreset::preset(QualityPreset::NAMES[0]);
+    for (int i = 0; i < QualityPreset::COUNT; i++)
+    {
+        QualityPreset preset = QualityPreset::preset(QualityPreset::NAMES[i]);
+        predictions.push_back(predict(preset));
+        if (predictions.back() <= BudgetMs)
+            chosen = preset;
+    }
+}
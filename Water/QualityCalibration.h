@@ -0,0 +1,67 @@
+#ifndef QUALITY_CALIBRATION_H
+#define QUALITY_CALIBRATION_H
+
+#include "ShaderVariants.h"
+
+#include <string>
+#include <vector>
+
+// Picks a QualityPreset for this machine from its own frame times. Once the scene has streamed in
+// the app renders a few hundred frames it never presents, cycling through candidate settings: the
+// presets and two mixes of them, so reflection target size, checkerboarded refraction and the
+// water's shader features each vary on their own. A least-squares fit of
+//     frame ms = base + planar ms per megapixel * planar pixels
+//                     + shading ms per feature megapixel * water features * screen pixels
+//                     + resolve ms * accumulating
+// then predicts every preset, and the best one under BudgetMs wins. The choice is stored per GPU
+// and driver (GL_VENDOR, GL_RENDERER, GL_VERSION), so each machine calibrates once.
+// ------------------------------------------------------------------------------------------------
+class QualityCalibration
+{
+public:
+    static const int WARMUP_FRAMES = 10;    // per candidate, cover variant compiles and target reallocation
+    static const int MEASURED_FRAMES = 40;
+    static const int TERMS = 4;
+
+    float BudgetMs = 1000.0f / 60.0f * 0.8f;    // 60 Hz with headroom for the rest of the frame
+
+    explicit QualityCalibration(const std::string& path = "quality.cal");
+
+    // GL thread: the preset stored for this GPU and driver, false if it has not been calibrated
+    bool load(QualityPreset& preset) const;
+    // GL thread: store result() for this GPU and driver, replacing an older entry
+    void save() const;
+
+    // start over at screenPixels; frames then go to current() until running() turns false
+    void begin(int screenPixels);
+    bool running() const { return candidate < candidates.size(); }
+    const QualityPreset& current() const { return candidates[candidate]; }
+    // time of the frame just rendered with current()
+    void frameDone(double frameMs);
+
+    const QualityPreset& result() const { return chosen; }
+    // model prediction for each preset, in QualityPreset::NAMES order, and the fitted coefficients
+    const std::vector<double>& predictedMs() const { return predictions; }
+    const double* coefficients() const { return model; }
+    // largest difference between a candidate's measured time and the model's, how well it fits
+    double worstResidualMs() const { return worstResidual; }
+
+private:
+    void terms(const QualityPreset& preset, double (&x)[TERMS]) const;
+    void fit();
+
+    std::string file;
+    double pixels = 0.0;
+    std::vector<QualityPreset> candidates;
+    std::vector<double> measured;       // mean frame time per candidate
+    size_t candidate = 0;
+    int frame = 0;
+    double frameSum = 0.0;
+
+    double model[TERMS] = {};
+    std::vector<double> predictions;
+    double worstResidual = 0.0;
+    QualityPreset chosen;
+};
+
+#endif
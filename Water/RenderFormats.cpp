@@ -0,0 +1,51 @@
+#include "RenderFormats.h"
+
+#include <glad/glad.h>
+
+RenderFormats RenderFormats::preset(const std::string& name)
+{
+    RenderFormats formats;
+    if (name == "ldr")
+        return formats;
+    formats.color = ColorFormat::R11G11B10F;
+    formats.sharedDepth = true;
+    if (name == "compact")
+        formats.depth = DepthFormat::Depth16;
+    return formats;
+}
+
+const char* RenderFormats::name() const
+{
+    if (!hdr())
+        return "ldr";
+    return depth == DepthFormat::Depth16 ? "compact" : "hdr";
+}
+
+unsigned int RenderFormats::depthAttachment() const
+{
+    return stencil() ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+}
+
+void RenderFormats::allocateColor(unsigned int texture, int width, int height) const
+{
+    glBindTexture(GL_TEXTURE_2D, texture);
+    if (hdr())
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R11F_G11F_B10F, width, height, 0, GL_RGB, GL_FLOAT, NULL);
+    else
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+}
+
+void RenderFormats::allocateDepth(unsigned int texture, int width, int height) const
+{
+    glBindTexture(GL_TEXTURE_2D, texture);
+    if (stencil())
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+    else
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT16, width, height, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT, NULL);
+}
+
+void RenderFormats::allocateDepthRenderbuffer(unsigned int renderbuffer, int width, int height) const
+{
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, stencil() ? GL_DEPTH24_STENCIL8 : GL_DEPTH_COMPONENT16, width, height);
+}
@@ -0,0 +1,40 @@
+#ifndef RENDER_FORMATS_H
+#define RENDER_FORMATS_H
+
+#include <cstddef>
+#include <string>
+
+enum class ColorFormat { RGB8, R11G11B10F };
+enum class DepthFormat { Depth16, Depth24Stencil8 };
+
+// Storage of the offscreen targets, picked once at startup (Water --targets ldr|hdr|compact).
+// R11G11B10F colour costs the same four bytes a pixel RGB8 is padded to but keeps values above 1
+// for the tone-mapping pass. 16-bit depth halves depth traffic where its precision is enough, at
+// the price of the stencil the checkerboard refraction needs. With sharedDepth the refraction
+// passes of every plane and the HDR main pass draw into one depth renderbuffer whenever nothing
+// samples theirs afterwards.
+// ---------------------------------------------------------------------------------------------
+struct RenderFormats
+{
+    ColorFormat color = ColorFormat::RGB8;
+    DepthFormat depth = DepthFormat::Depth24Stencil8;
+    bool sharedDepth = false;
+
+    // ldr (the above), hdr (R11G11B10F, shared 24-bit depth), compact (hdr with 16-bit depth);
+    // anything else gives hdr
+    static RenderFormats preset(const std::string& name);
+    const char* name() const;
+
+    bool hdr() const { return color != ColorFormat::RGB8; }
+    bool stencil() const { return depth == DepthFormat::Depth24Stencil8; }
+    size_t colorBytes() const { return 4; }
+    size_t depthBytes() const { return depth == DepthFormat::Depth16 ? 2 : 4; }
+    unsigned int depthAttachment() const;   // GL_DEPTH_STENCIL_ATTACHMENT with stencil, else GL_DEPTH_ATTACHMENT
+
+    // GL thread: (re)specify storage; leaves GL_TEXTURE_2D / GL_RENDERBUFFER bound to the object
+    void allocateColor(unsigned int texture, int width, int height) const;
+    void allocateDepth(unsigned int texture, int width, int height) const;
+    void allocateDepthRenderbuffer(unsigned int renderbuffer, int width, int height) const;
+};
+
+#endif
@@ -0,0 +1,346 @@
+#include "SceneFile.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <sys/stat.h>
+
+// what either form may ask for: larger is a typo or a corrupt cache, not a scene
+static const uint32_t MAX_SCENE_ENTRIES = 1u << 20;     // models, instances or water bodies
+static const int MAX_WATER_TILES = 1024;                // along each side of a body
+static const int MAX_SIM_RESOLUTION = 4096;
+
+static bool validSimResolution(const std::string& path, long long resolution)
+{
+    if (resolution > 0 && resolution <= MAX_SIM_RESOLUTION)
+        return true;
+    std::cout << "ERROR::SCENE::SIM_RESOLUTION " << resolution << " in " << path << ", 1 to " << MAX_SIM_RESOLUTION << std::endl;
+    return false;
+}
+
+glm::dmat4 SceneInstance::transform() const
+{
+    glm::dmat4 model = glm::translate(glm::dmat4(1.0), position);
+    model = glm::rotate(model, glm::radians(static_cast<double>(rotation.y)), glm::dvec3(0, 1, 0));
+    model = glm::rotate(model, glm::radians(static_cast<double>(rotation.x)), glm::dvec3(1, 0, 0));
+    model = glm::rotate(model, glm::radians(static_cast<double>(rotation.z)), glm::dvec3(0, 0, 1));
+    return glm::scale(model, glm::dvec3(scale));
+}
+
+void SceneWater::tileTransforms(std::vector<glm::mat4>& transforms) const
+{
+    transforms.clear();
+    glm::vec2 tileSize = size / glm::vec2(tiles);
+    glm::vec2 corner = -size * 0.5f;
+    for (int i = 0; i < tiles.x; i++)
+    {
+        for (int j = 0; j < tiles.y; j++)
+        {
+            // the water quad lies in its xy plane, rotated flat after scaling
+            glm::vec2 tileCenter = corner + (glm::vec2(i, j) + 0.5f) * tileSize;
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(tileCenter.x, 0.0f, tileCenter.y));
+            model = glm::scale(model, glm::vec3(tileSize.x, 1.0f, tileSize.y));
+            model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1, 0, 0));
+            transforms.push_back(model);
+        }
+    }
+}
+
+// text
+// ----
+bool parseSceneText(const std::string& path, SceneDescription& scene)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::SCENE::FILE_NOT_SUCCESFULLY_READ: " << path << std::endl;
+        return false;
+    }
+
+    scene = SceneDescription();
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+        std::istringstream in(line);
+        std::string keyword;
+        if (!(in >> keyword))
+            continue;
+
+        bool ok = true;
+        if (keyword == "skybox")
+        {
+            for (std::string& face : scene.skybox)
+                ok = ok && static_cast<bool>(in >> face);
+        }
+        else if (keyword == "model")
+        {
+            SceneModel model;
+            ok = static_cast<bool>(in >> model.name >> model.path);
+            scene.models.push_back(model);
+        }
+        else if (keyword == "instance")
+        {
+            std::string name, flag;
+            SceneInstance instance;
+            ok = static_cast<bool>(in >> name
+                >> instance.position.x >> instance.position.y >> instance.position.z
+                >> instance.rotation.x >> instance.rotation.y >> instance.rotation.z
+                >> instance.scale.x >> instance.scale.y >> instance.scale.z);
+            while (ok && in >> flag)
+                instance.boundary = instance.boundary || flag == "boundary";
+            // models have to be declared before they are placed
+            unsigned int index = 0;
+            while (index < scene.models.size() && scene.models[index].name != name)
+                index++;
+            if (ok && index == scene.models.size())
+            {
+                std::cout << "ERROR::SCENE::UNKNOWN_MODEL " << name << " at " << path << ":" << lineNumber << std::endl;
+                return false;
+            }
+            instance.model = index;
+            scene.instances.push_back(instance);
+        }
+        else if (keyword == "water")
+        {
+            SceneWater body;
+            ok = static_cast<bool>(in >> body.center.x >> body.center.y >> body.center.z >> body.size.x >> body.size.y);
+            int tilesX, tilesZ;
+            if (ok && in >> tilesX >> tilesZ)
+            {
+                body.tiles = glm::max(glm::ivec2(tilesX, tilesZ), glm::ivec2(1));
+                ok = body.tiles.x <= MAX_WATER_TILES && body.tiles.y <= MAX_WATER_TILES;
+            }
+            scene.water.push_back(body);
+        }
+        else if (keyword == "terrain")
+        {
+            SceneTerrain& terrain = scene.terrain;
+            ok = static_cast<bool>(in >> terrain.path >> terrain.center.x >> terrain.center.y >> terrain.center.z >> terrain.size >> terrain.heightScale);
+        }
+        else if (keyword == "ocean")
+        {
+            SceneOcean& ocean = scene.ocean;
+            ok = static_cast<bool>(in >> ocean.height >> ocean.chunkSize >> ocean.range) && ocean.chunkSize > 0.0f;
+        }
+        else if (keyword == "simulation")
+            ok = static_cast<bool>(in >> scene.simOrigin.x >> scene.simOrigin.y >> scene.simExtent >> scene.simResolution)
+                && validSimResolution(path, scene.simResolution);
+        else
+            ok = false;
+
+        if (!ok)
+        {
+            std::cout << "ERROR::SCENE::PARSE " << path << ":" << lineNumber << ": " << line << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// binary: "WSCN", version, then every section as counts followed by little-endian fields;
+// world positions are doubles, everything else floats
+// -------------------------------------------------------------------------------------
+static const char SCENE_MAGIC[4] = { 'W', 'S', 'C', 'N' };
+static const uint32_t SCENE_VERSION = 4;
+
+static void writeU32(std::ostream& out, uint32_t value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void writeFloats(std::ostream& out, const float* values, size_t count)
+{
+    out.write(reinterpret_cast<const char*>(values), sizeof(float) * count);
+}
+
+static void writeDoubles(std::ostream& out, const double* values, size_t count)
+{
+    out.write(reinterpret_cast<const char*>(values), sizeof(double) * count);
+}
+
+static void writeString(std::ostream& out, const std::string& value)
+{
+    writeU32(out, static_cast<uint32_t>(value.size()));
+    out.write(value.data(), value.size());
+}
+
+static bool readU32(std::istream& in, uint32_t& value)
+{
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+static bool readFloats(std::istream& in, float* values, size_t count)
+{
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(values), sizeof(float) * count));
+}
+
+static bool readDoubles(std::istream& in, double* values, size_t count)
+{
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(values), sizeof(double) * count));
+}
+
+static bool readString(std::istream& in, std::string& value)
+{
+    uint32_t size;
+    if (!readU32(in, size) || size > (1u << 16))
+        return false;
+    value.resize(size);
+    return size == 0 || static_cast<bool>(in.read(&value[0], size));
+}
+
+// a count of entries of at least entryBytes each, no more than the rest of the file can hold
+static bool readCount(std::istream& in, std::streamoff fileSize, std::streamoff entryBytes, uint32_t& count)
+{
+    if (!readU32(in, count) || count > MAX_SCENE_ENTRIES)
+        return false;
+    std::streamoff position = in.tellg();
+    return position >= 0 && static_cast<std::streamoff>(count) * entryBytes <= fileSize - position;
+}
+
+bool writeSceneBinary(const std::string& path, const SceneDescription& scene)
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+        return false;
+    out.write(SCENE_MAGIC, sizeof(SCENE_MAGIC));
+    writeU32(out, SCENE_VERSION);
+
+    for (const std::string& face : scene.skybox)
+        writeString(out, face);
+    writeU32(out, static_cast<uint32_t>(scene.models.size()));
+    for (const SceneModel& model : scene.models)
+    {
+        writeString(out, model.name);
+        writeString(out, model.path);
+    }
+    writeU32(out, static_cast<uint32_t>(scene.instances.size()));
+    for (const SceneInstance& instance : scene.instances)
+    {
+        writeU32(out, instance.model);
+        writeDoubles(out, &instance.position[0], 3);
+        writeFloats(out, &instance.rotation[0], 3);
+        writeFloats(out, &instance.scale[0], 3);
+        writeU32(out, instance.boundary ? 1 : 0);
+    }
+    writeU32(out, static_cast<uint32_t>(scene.water.size()));
+    for (const SceneWater& body : scene.water)
+    {
+        writeDoubles(out, &body.center[0], 3);
+        writeFloats(out, &body.size[0], 2);
+        writeU32(out, static_cast<uint32_t>(body.tiles.x));
+        writeU32(out, static_cast<uint32_t>(body.tiles.y));
+    }
+    writeString(out, scene.terrain.path);
+    writeDoubles(out, &scene.terrain.center[0], 3);
+    writeFloats(out, &scene.terrain.size, 1);
+    writeFloats(out, &scene.terrain.heightScale, 1);
+    writeDoubles(out, &scene.ocean.height, 1);
+    writeFloats(out, &scene.ocean.chunkSize, 1);
+    writeFloats(out, &scene.ocean.range, 1);
+    writeFloats(out, &scene.simOrigin[0], 2);
+    writeFloats(out, &scene.simExtent, 1);
+    writeU32(out, static_cast<uint32_t>(scene.simResolution));
+    return static_cast<bool>(out);
+}
+
+bool readSceneBinary(const std::string& path, SceneDescription& scene)
+{
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    std::streamoff fileSize = in ? static_cast<std::streamoff>(in.tellg()) : 0;
+    in.seekg(0);
+    char magic[4];
+    uint32_t version;
+    if (!in || !in.read(magic, sizeof(magic)) || std::memcmp(magic, SCENE_MAGIC, sizeof(magic)) != 0
+        || !readU32(in, version) || version != SCENE_VERSION)
+        return false;
+
+    SceneDescription result;
+    for (std::string& face : result.skybox)
+    {
+        if (!readString(in, face))
+            return false;
+    }
+    // the smallest entry of each section: a model is two strings, an instance and a water body
+    // their fixed fields
+    const std::streamoff MODEL_BYTES = 2 * sizeof(uint32_t);
+    const std::streamoff INSTANCE_BYTES = 2 * sizeof(uint32_t) + 3 * sizeof(double) + 6 * sizeof(float);
+    const std::streamoff WATER_BYTES = 3 * sizeof(double) + 2 * sizeof(float) + 2 * sizeof(uint32_t);
+    uint32_t count;
+    if (!readCount(in, fileSize, MODEL_BYTES, count))
+        return false;
+    result.models.resize(count);
+    for (SceneModel& model : result.models)
+    {
+        if (!readString(in, model.name) || !readString(in, model.path))
+            return false;
+    }
+    if (!readCount(in, fileSize, INSTANCE_BYTES, count))
+        return false;
+    result.instances.resize(count);
+    for (SceneInstance& instance : result.instances)
+    {
+        uint32_t boundary;
+        if (!readU32(in, instance.model) || !readDoubles(in, &instance.position[0], 3) || !readFloats(in, &instance.rotation[0], 3)
+            || !readFloats(in, &instance.scale[0], 3) || !readU32(in, boundary) || instance.model >= result.models.size())
+            return false;
+        instance.boundary = boundary != 0;
+    }
+    if (!readCount(in, fileSize, WATER_BYTES, count))
+        return false;
+    result.water.resize(count);
+    for (SceneWater& body : result.water)
+    {
+        uint32_t tilesX, tilesZ;
+        if (!readDoubles(in, &body.center[0], 3) || !readFloats(in, &body.size[0], 2) || !readU32(in, tilesX) || !readU32(in, tilesZ)
+            || tilesX > static_cast<uint32_t>(MAX_WATER_TILES) || tilesZ > static_cast<uint32_t>(MAX_WATER_TILES))
+            return false;
+        body.tiles = glm::max(glm::ivec2(tilesX, tilesZ), glm::ivec2(1));
+    }
+    SceneTerrain& terrain = result.terrain;
+    if (!readString(in, terrain.path) || !readDoubles(in, &terrain.center[0], 3) || !readFloats(in, &terrain.size, 1) || !readFloats(in, &terrain.heightScale, 1))
+        return false;
+    SceneOcean& ocean = result.ocean;
+    if (!readDoubles(in, &ocean.height, 1) || !readFloats(in, &ocean.chunkSize, 1) || !readFloats(in, &ocean.range, 1))
+        return false;
+    uint32_t resolution;
+    if (!readFloats(in, &result.simOrigin[0], 2) || !readFloats(in, &result.simExtent, 1) || !readU32(in, resolution))
+        return false;
+    if (!validSimResolution(path, resolution))
+        return false;
+    result.simResolution = static_cast<int>(resolution);
+
+    scene = result;
+    return true;
+}
+
+// modification time, 0 if the file does not exist
+static long long modifiedTime(const std::string& path)
+{
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? static_cast<long long>(info.st_mtime) : 0;
+}
+
+bool loadScene(const std::string& path, SceneDescription& scene)
+{
+    std::string binaryPath = path + "b";
+    long long binaryTime = modifiedTime(binaryPath);
+    bool cacheFresh = binaryTime != 0 && binaryTime >= modifiedTime(path);
+    if (cacheFresh && readSceneBinary(binaryPath, scene))
+        return true;
+
+    if (!parseSceneText(path, scene))
+        return false;
+    if (!writeSceneBinary(binaryPath, scene))
+        std::cout << "ERROR::SCENE::CACHE_NOT_WRITTEN: " << binaryPath << std::endl;
+    return true;
+}
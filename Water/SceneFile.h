@@ -0,0 +1,92 @@
+#ifndef SCENE_FILE_H
+#define SCENE_FILE_H
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+// A model asset, referenced by index from instances
+struct SceneModel
+{
+    std::string name;
+    std::string path;
+};
+
+// One placement of a model: translate * rotateY * rotateX * rotateZ * scale
+struct SceneInstance
+{
+    unsigned int model = 0;
+    glm::dvec3 position = glm::dvec3(0.0);     // world space, see WorldSpace.h
+    glm::vec3 rotation = glm::vec3(0.0f);    // degrees
+    glm::vec3 scale = glm::vec3(1.0f);
+    bool boundary = false;                    // walls for the wave simulation
+
+    glm::dmat4 transform() const;
+};
+
+// A rectangle of water at center.y, split into tiles x tiles quads
+struct SceneWater
+{
+    glm::dvec3 center = glm::dvec3(0.0);
+    glm::vec2 size = glm::vec2(1.0f);
+    glm::ivec2 tiles = glm::ivec2(1);
+
+    // one quad transform per tile, relative to center
+    void tileTransforms(std::vector<glm::mat4>& transforms) const;
+};
+
+// Heightmapped ground, size x size centred on center; heights run from center.y up by heightScale
+struct SceneTerrain
+{
+    std::string path;    // empty: no terrain
+    glm::dvec3 center = glm::dvec3(0.0);
+    float size = 512.0f;
+    float heightScale = 16.0f;
+};
+
+// Open water at height, paged in chunks around the camera out to range
+struct SceneOcean
+{
+    double height = 0.0;
+    float chunkSize = 0.0f;    // finest chunk edge, 0: no ocean
+    float range = 2048.0f;
+
+    bool enabled() const { return chunkSize > 0.0f; }
+};
+
+// Everything a scene is made of. Authored as text (.scene), loaded from a compact binary
+// (.sceneb) that is regenerated whenever the text is newer.
+// --------------------------------------------------------------------------------------
+struct SceneDescription
+{
+    std::vector<SceneModel> models;
+    std::vector<SceneInstance> instances;
+    std::vector<SceneWater> water;
+    std::string skybox[6];    // right, left, top, bottom, front, back
+    SceneTerrain terrain;
+    SceneOcean ocean;
+
+    // heightfield simulation domain on the xz plane
+    glm::vec2 simOrigin = glm::vec2(-3.5f);
+    float simExtent = 7.0f;
+    int simResolution = 256;
+
+    // height of the reflection / refraction plane: the first water body, else the ocean
+    float waterHeight() const
+    {
+        if (!water.empty())
+            return static_cast<float>(water[0].center.y);
+        return static_cast<float>(ocean.height);
+    }
+};
+
+// text form, errors are printed as ERROR::SCENE:: with the line number
+bool parseSceneText(const std::string& path, SceneDescription& scene);
+bool readSceneBinary(const std::string& path, SceneDescription& scene);
+bool writeSceneBinary(const std::string& path, const SceneDescription& scene);
+
+// load path (text), going through path + "b" as a binary cache
+bool loadScene(const std::string& path, SceneDescription& scene);
+
+#endif
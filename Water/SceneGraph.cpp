@@ -0,0 +1,83 @@
+#include "SceneGraph.h"
+
+#include <algorithm>
+
+DrawBounds transformBounds(const glm::dmat4& transform, const DrawBounds& bounds)
+{
+    DrawBounds result;
+    result.center = glm::dvec3(transform * glm::dvec4(bounds.center, 1.0));
+    double scale = std::max({ glm::length(glm::dvec3(transform[0])), glm::length(glm::dvec3(transform[1])), glm::length(glm::dvec3(transform[2])) });
+    result.radius = static_cast<float>(bounds.radius * scale);
+    return result;
+}
+
+unsigned int SceneGraph::addNode(unsigned int parent, const glm::dmat4& local, const DrawBounds& localBounds)
+{
+    unsigned int node = static_cast<unsigned int>(parents.size());
+    if (parent >= node)
+        parent = NO_PARENT;
+    parents.push_back(parent);
+    locals.push_back(local);
+    worlds.push_back(local);
+    localBoundsCache.push_back(localBounds);
+    worldBoundsCache.push_back(DrawBounds());
+    dirty.push_back(1);
+    updatedIn.push_back(0);
+    firstDirty = std::min(firstDirty, static_cast<size_t>(node));
+    return node;
+}
+
+void SceneGraph::setLocal(unsigned int node, const glm::dmat4& local)
+{
+    locals[node] = local;
+    dirty[node] = 1;
+    firstDirty = std::min(firstDirty, static_cast<size_t>(node));
+}
+
+void SceneGraph::setLocalBounds(unsigned int node, const DrawBounds& localBounds)
+{
+    localBoundsCache[node] = localBounds;
+    dirty[node] = 1;
+    firstDirty = std::min(firstDirty, static_cast<size_t>(node));
+}
+
+void SceneGraph::clear()
+{
+    parents.clear();
+    locals.clear();
+    worlds.clear();
+    localBoundsCache.clear();
+    worldBoundsCache.clear();
+    dirty.clear();
+    updatedIn.clear();
+    firstDirty = 0;
+    revision++;
+}
+
+size_t SceneGraph::update()
+{
+    size_t count = parents.size();
+    if (firstDirty >= count)
+        return 0;
+
+    // parents come first, so by the time a node is reached its parent's world is final;
+    // a node is stale if it was touched or its parent was recomputed in this sweep
+    sweep++;
+    size_t recomputed = 0;
+    for (size_t i = firstDirty; i < count; i++)
+    {
+        unsigned int parent = parents[i];
+        bool parentChanged = parent != NO_PARENT && updatedIn[parent] == sweep;
+        if (!dirty[i] && !parentChanged)
+            continue;
+
+        worlds[i] = parent == NO_PARENT ? locals[i] : worlds[parent] * locals[i];
+        worldBoundsCache[i] = localBoundsCache[i].radius > 0.0f ? transformBounds(worlds[i], localBoundsCache[i]) : DrawBounds();
+        dirty[i] = 0;
+        updatedIn[i] = sweep;
+        recomputed++;
+    }
+    firstDirty = count;
+    revision++;
+    return recomputed;
+}
@@ -0,0 +1,61 @@
+#ifndef SCENE_GRAPH_H
+#define SCENE_GRAPH_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Bounding sphere, world space when it comes out of the graph
+struct DrawBounds
+{
+    glm::dvec3 center = glm::dvec3(0.0);
+    float radius = 0.0f;
+};
+
+// bounds of a sphere after transform, the radius grows with the largest axis scale
+DrawBounds transformBounds(const glm::dmat4& transform, const DrawBounds& bounds);
+
+// Transform hierarchy stored flat, one array per field, with every parent before its children.
+// Matrices are double precision world space (see WorldSpace.h). World matrices and bounds are
+// cached; setLocal() only marks a node dirty and update() recomputes the dirty nodes and their
+// descendants in a single front-to-back sweep.
+// ------------------------------------------------------------------------------------------
+class SceneGraph
+{
+public:
+    static const unsigned int NO_PARENT = ~0u;
+
+    // parent has to be NO_PARENT or an existing node, so the array stays parent-before-child
+    unsigned int addNode(unsigned int parent, const glm::dmat4& local, const DrawBounds& localBounds = DrawBounds());
+    void setLocal(unsigned int node, const glm::dmat4& local);
+    void setLocalBounds(unsigned int node, const DrawBounds& localBounds);
+    void clear();
+
+    // returns how many world transforms were recomputed
+    size_t update();
+
+    size_t size() const { return parents.size(); }
+    unsigned int parent(unsigned int node) const { return parents[node]; }
+    const glm::dmat4& local(unsigned int node) const { return locals[node]; }
+    const glm::dmat4& world(unsigned int node) const { return worlds[node]; }
+    // world-space bounds, radius 0 while the node has no geometry
+    const DrawBounds& worldBounds(unsigned int node) const { return worldBoundsCache[node]; }
+    // bumped by every update() that changed something
+    uint64_t version() const { return revision; }
+
+private:
+    std::vector<unsigned int> parents;
+    std::vector<glm::dmat4> locals;
+    std::vector<glm::dmat4> worlds;
+    std::vector<DrawBounds> localBoundsCache;
+    std::vector<DrawBounds> worldBoundsCache;
+    std::vector<unsigned char> dirty;
+    std::vector<uint32_t> updatedIn;    // sweep that last recomputed the node, children compare against it
+
+    size_t firstDirty = 0;    // nothing before this index needs work
+    uint32_t sweep = 0;
+    uint64_t revision = 0;
+};
+
+#endif
@@ -0,0 +1,172 @@
+#include "SceneLoader.h"
+
+#include <cstddef>
+#include <iostream>
+
+SceneLoader::SceneLoader(GLFWwindow* shareWith, unsigned int threadCount)
+{
+    // invisible 1x1 windows, created with the same context hints as the main window
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    for (unsigned int i = 0; i < threadCount; i++)
+    {
+        GLFWwindow* context = glfwCreateWindow(1, 1, "loader", NULL, shareWith);
+        if (context == NULL)
+        {
+            std::cout << "ERROR::LOADER::SHARED_CONTEXT_NOT_CREATED" << std::endl;
+            break;
+        }
+        contexts.push_back(context);
+    }
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+
+    for (GLFWwindow* context : contexts)
+        threads.emplace_back(&SceneLoader::workerLoop, this, context);
+}
+
+SceneLoader::~SceneLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads)
+        thread.join();
+    for (Task& task : uploaded)
+    {
+        if (task.fence)
+            glDeleteSync(task.fence);
+    }
+    for (GLFWwindow* context : contexts)
+        glfwDestroyWindow(context);
+}
+
+void SceneLoader::enqueue(std::function<void()> work, std::function<void()> finish)
+{
+    Task task;
+    task.work = std::move(work);
+    task.finish = std::move(finish);
+    // without a shared context there is nobody to hand the work to, load in place
+    if (threads.empty())
+    {
+        task.work();
+        task.finish();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+unsigned int SceneLoader::update()
+{
+    unsigned int finished = 0;
+    while (true)
+    {
+        Task task;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (uploaded.empty())
+                break;
+            // timeout 0: only ask, the frame never waits for a loader
+            GLenum status = glClientWaitSync(uploaded.front().fence, 0, 0);
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                break;
+            task = std::move(uploaded.front());
+            uploaded.pop_front();
+        }
+        glDeleteSync(task.fence);
+        task.finish();
+        finished++;
+    }
+    return finished;
+}
+
+bool SceneLoader::idle() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return queued.empty() && uploaded.empty() && loading == 0;
+}
+
+void SceneLoader::workerLoop(GLFWwindow* context)
+{
+    glfwMakeContextCurrent(context);
+    while (true)
+    {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return quit || !queued.empty(); });
+            if (quit)
+                break;
+            task = std::move(queued.front());
+            queued.pop_front();
+            loading++;
+        }
+
+        task.work();
+        // the fence tells the GL thread when the uploads are visible to its context
+        task.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        uploaded.push_back(std::move(task));
+        loading--;
+    }
+    glfwMakeContextCurrent(NULL);
+}
+
+// mesh vertex arrays
+// ------------------
+void detachMeshVertexArrays(std::vector<Mesh>& meshes, std::vector<MeshBuffers>& buffers)
+{
+    buffers.resize(meshes.size());
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        GLint vertexBuffer = 0, elementBuffer = 0;
+        glBindVertexArray(meshes[i].VAO);
+        glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &vertexBuffer);
+        glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &elementBuffer);
+        glBindVertexArray(0);
+        glDeleteVertexArrays(1, &meshes[i].VAO);
+        meshes[i].VAO = 0;
+        buffers[i] = { static_cast<unsigned int>(vertexBuffer), static_cast<unsigned int>(elementBuffer) };
+    }
+}
+
+void attachMeshVertexArrays(std::vector<Mesh>& meshes, const std::vector<MeshBuffers>& buffers)
+{
+    for (size_t i = 0; i < meshes.size() && i < buffers.size(); i++)
+    {
+        Mesh& mesh = meshes[i];
+        glGenVertexArrays(1, &mesh.VAO);
+        glBindVertexArray(mesh.VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, buffers[i].vertexBuffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[i].elementBuffer);
+
+        // vertex positions
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        // vertex normals
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+        // vertex texture coords
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+        // vertex tangent
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
+        // vertex bitangent
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+        // ids
+        glEnableVertexAttribArray(5);
+        glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
+        // weights
+        glEnableVertexAttribArray(6);
+        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
+    }
+    glBindVertexArray(0);
+}
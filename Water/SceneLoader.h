@@ -0,0 +1,71 @@
+#ifndef SCENE_LOADER_H
+#define SCENE_LOADER_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader_m.h>
+#include <learnopengl/mesh.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Streams scene assets in on background threads. Every loader thread owns a hidden window whose
+// context shares objects with the main one, so work() can run ordinary loading code (Model,
+// loadCubemap) including its GL uploads. Once the GPU has consumed the uploads, finish() runs on
+// the GL thread from update() to hand the asset to the renderer.
+// ---------------------------------------------------------------------------------------------
+class SceneLoader
+{
+public:
+    // must be called on the main thread, like every GLFW window function
+    SceneLoader(GLFWwindow* shareWith, unsigned int threadCount = 2);
+    ~SceneLoader();
+
+    void enqueue(std::function<void()> work, std::function<void()> finish);
+
+    // GL thread: run finish() for every asset whose uploads completed, returns how many
+    unsigned int update();
+    // nothing queued, loading or waiting for update()
+    bool idle() const;
+    unsigned int threadCount() const { return static_cast<unsigned int>(threads.size()); }
+
+private:
+    struct Task
+    {
+        std::function<void()> work;
+        std::function<void()> finish;
+        GLsync fence = 0;
+    };
+
+    void workerLoop(GLFWwindow* context);
+
+    std::vector<GLFWwindow*> contexts;
+    std::vector<std::thread> threads;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Task> queued;
+    std::deque<Task> uploaded;
+    unsigned int loading = 0;
+    bool quit = false;
+};
+
+// Vertex array objects are the one thing contexts do not share. A mesh built on a loader thread
+// gives up its VAO there and gets an equivalent one (Mesh::setupMesh layout) on the GL thread.
+struct MeshBuffers
+{
+    unsigned int vertexBuffer;
+    unsigned int elementBuffer;
+};
+// loader thread, in the context that created the meshes
+void detachMeshVertexArrays(std::vector<Mesh>& meshes, std::vector<MeshBuffers>& buffers);
+// GL thread
+void attachMeshVertexArrays(std::vector<Mesh>& meshes, const std::vector<MeshBuffers>& buffers);
+
+#endif
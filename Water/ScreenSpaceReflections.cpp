@@ -0,0 +1,168 @@
+#include "ScreenSpaceReflections.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <iostream>
+
+ScreenSpaceReflections::~ScreenSpaceReflections()
+{
+    destroy();
+}
+
+void ScreenSpaceReflections::destroy()
+{
+    if (!framebuffer)
+        return;
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteFramebuffers(1, &copyFramebuffer);
+    glDeleteFramebuffers(static_cast<int>(hiZFramebuffers.size()), hiZFramebuffers.data());
+    unsigned int textures[] = { color, depth, colorCopy, hiZ };
+    glDeleteTextures(4, textures);
+    glDeleteVertexArrays(1, &emptyVertexArray);
+    hiZFramebuffers.clear();
+    framebuffer = 0;
+}
+
+// storage is up to the caller
+static unsigned int createTexture(int filter)
+{
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+static void checkFramebuffer()
+{
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
+}
+
+// setup
+// -----
+void ScreenSpaceReflections::create(int width, int height, unsigned int hiZProgram, const RenderFormats& targetFormats)
+{
+    destroy();
+    formats = targetFormats;
+    sceneWidth = width;
+    sceneHeight = height;
+    program = hiZProgram;
+    sourceLocation = glGetUniformLocation(program, "source");
+    reduceLocation = glGetUniformLocation(program, "reduce");
+
+    // the main pass draws here; the depth is sampled for the pyramid, so it is never shared
+    color = createTexture(GL_LINEAR);
+    formats.allocateColor(color, width, height);
+    depth = createTexture(GL_NEAREST);
+    formats.allocateDepth(depth, width, height);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, formats.depthAttachment(), GL_TEXTURE_2D, depth, 0);
+    checkFramebuffer();
+
+    // the opaque scene as the water sees it
+    colorCopy = createTexture(GL_LINEAR);
+    formats.allocateColor(colorCopy, width, height);
+    glGenFramebuffers(1, &copyFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, copyFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorCopy, 0);
+    checkFramebuffer();
+
+    // depth pyramid down to 1 x 1, each level its own render target
+    levels = 1;
+    while ((std::max(width, height) >> levels) > 0)
+        levels++;
+    hiZ = createTexture(GL_NEAREST);
+    for (int level = 0; level < levels; level++)
+        glTexImage2D(GL_TEXTURE_2D, level, GL_R32F, std::max(width >> level, 1), std::max(height >> level, 1), 0, GL_RED, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    hiZFramebuffers.resize(levels);
+    glGenFramebuffers(levels, hiZFramebuffers.data());
+    for (int level = 0; level < levels; level++)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, hiZFramebuffers[level]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, hiZ, level);
+        checkFramebuffer();
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glGenVertexArrays(1, &emptyVertexArray);
+}
+
+size_t ScreenSpaceReflections::targetBytes() const
+{
+    // two colours, depth, and a pyramid of a third more R32F
+    size_t pixels = static_cast<size_t>(sceneWidth) * sceneHeight;
+    return pixels * (formats.colorBytes() * 2 + formats.depthBytes()) + pixels * 4 * 4 / 3;
+}
+
+// frame
+// -----
+void ScreenSpaceReflections::beginScene()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, sceneWidth, sceneHeight);
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void ScreenSpaceReflections::buildHiZ()
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, copyFramebuffer);
+    glBlitFramebuffer(0, 0, sceneWidth, sceneHeight, 0, 0, sceneWidth, sceneHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    // full-screen triangles, no depth or clipping; the clip state is put back as it was found
+    bool clipping = glIsEnabled(GL_CLIP_DISTANCE0) == GL_TRUE;
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CLIP_DISTANCE0);
+    glUseProgram(program);
+    glUniform1i(sourceLocation, 0);
+    glBindVertexArray(emptyVertexArray);
+    glActiveTexture(GL_TEXTURE0);
+
+    // level 0 is the depth buffer itself
+    glBindFramebuffer(GL_FRAMEBUFFER, hiZFramebuffers[0]);
+    glViewport(0, 0, sceneWidth, sceneHeight);
+    glUniform1i(reduceLocation, 0);
+    glBindTexture(GL_TEXTURE_2D, depth);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    // every further level reads only the one above it, so the level being written is never sampled
+    glUniform1i(reduceLocation, 1);
+    glBindTexture(GL_TEXTURE_2D, hiZ);
+    for (int level = 1; level < levels; level++)
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1);
+        glBindFramebuffer(GL_FRAMEBUFFER, hiZFramebuffers[level]);
+        glViewport(0, 0, std::max(sceneWidth >> level, 1), std::max(sceneHeight >> level, 1));
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindVertexArray(0);
+
+    glEnable(GL_DEPTH_TEST);
+    if (clipping)
+        glEnable(GL_CLIP_DISTANCE0);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, sceneWidth, sceneHeight);
+}
+
+void ScreenSpaceReflections::present(unsigned int target, int targetWidth, int targetHeight) const
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+    glBlitFramebuffer(0, 0, sceneWidth, sceneHeight, 0, 0, targetWidth, targetHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+}
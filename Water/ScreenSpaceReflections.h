@@ -0,0 +1,60 @@
+#ifndef SCREEN_SPACE_REFLECTIONS_H
+#define SCREEN_SPACE_REFLECTIONS_H
+
+#include "RenderFormats.h"
+
+#include <cstddef>
+#include <vector>
+
+// The main pass rendered offscreen for the screen-space reflection modes. The opaque scene goes
+// into a colour and depth target first; buildHiZ() then copies the colour for the water to sample
+// and reduces the depth into a pyramid where each texel holds the nearest depth of the four below
+// it, so water.fs can step over empty space a whole cell at a time. The water is drawn on top
+// into the same target and present() scales it onto the screen.
+// ----------------------------------------------------------------------------------------------
+class ScreenSpaceReflections
+{
+public:
+    ScreenSpaceReflections() = default;
+    ~ScreenSpaceReflections();
+    ScreenSpaceReflections(const ScreenSpaceReflections&) = delete;
+    ScreenSpaceReflections& operator=(const ScreenSpaceReflections&) = delete;
+
+    // GL thread: targets at width x height in formats; hiZProgram is hiz.vs / hiz.fs
+    void create(int width, int height, unsigned int hiZProgram, const RenderFormats& formats = RenderFormats());
+
+    // bind and clear the scene target, for the opaque part of the main pass
+    void beginScene();
+    // snapshot the colour and build the depth pyramid, then rebind the scene target for the water
+    void buildHiZ();
+    // scale the finished image onto framebuffer (0 is the window); HDR formats go through a ToneMapper instead
+    void present(unsigned int framebuffer, int targetWidth, int targetHeight) const;
+
+    unsigned int sceneFramebuffer() const { return framebuffer; }
+    unsigned int sceneTexture() const { return color; }         // the finished image
+    unsigned int colorTexture() const { return colorCopy; }
+    unsigned int hiZTexture() const { return hiZ; }
+    int hiZLevels() const { return levels; }
+    int width() const { return sceneWidth; }
+    int height() const { return sceneHeight; }
+    size_t targetBytes() const;
+
+private:
+    void destroy();
+
+    RenderFormats formats;
+    int sceneWidth = 0, sceneHeight = 0;
+    int levels = 0;
+    unsigned int framebuffer = 0;
+    unsigned int color = 0;         // what the main pass draws into
+    unsigned int depth = 0;
+    unsigned int copyFramebuffer = 0;
+    unsigned int colorCopy = 0;     // the opaque scene, sampled by the water
+    unsigned int hiZ = 0;           // R32F, nearest depth per cell, a full mip chain
+    std::vector<unsigned int> hiZFramebuffers;  // one per level
+    unsigned int program = 0;
+    int sourceLocation = -1, reduceLocation = -1;
+    unsigned int emptyVertexArray = 0;          // the full-screen triangle comes from gl_VertexID
+};
+
+#endif
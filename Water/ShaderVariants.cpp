@@ -0,0 +1,248 @@
+#include "ShaderVariants.h"
+#include "UniformRing.h"
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+static const char PROGRAM_MAGIC[4] = { 'W', 'P', 'R', 'G' };
+static const uint32_t PROGRAM_VERSION = 1;
+
+static const char* const FEATURE_NAMES[FEATURE_COUNT] = { "DISTORTION", "FRESNEL", "SOFT_EDGES", "OBLIQUE_CLIP", "NORMAL_MAP", "OVERDRAW" };
+
+// presets
+// -------
+const char* const QualityPreset::NAMES[] = { "low", "medium", "high", "ultra" };
+
+QualityPreset QualityPreset::preset(const std::string& name)
+{
+    QualityPreset quality;
+    if (name == "low")
+    {
+        quality.features = FEATURE_DISTORTION | FEATURE_OBLIQUE_CLIP;
+        quality.checkerboard = true;
+    }
+    else if (name == "medium")
+        quality.features = FEATURE_DISTORTION | FEATURE_FRESNEL | FEATURE_OBLIQUE_CLIP;
+    else if (name == "ultra")
+        quality.temporal = false;
+    else
+        return quality;
+    quality.name = name;
+    quality.features = compatibleFeatures(quality.features);
+    return quality;
+}
+
+std::string featureDefines(unsigned int features)
+{
+    std::string defines;
+    for (int i = 0; i < FEATURE_COUNT; i++)
+        defines += std::string("#define ") + FEATURE_NAMES[i] + ((features & (1u << i)) ? " 1\n" : " 0\n");
+    return defines;
+}
+
+unsigned int compatibleFeatures(unsigned int features)
+{
+    return (features & FEATURE_OBLIQUE_CLIP) ? features & ~FEATURE_SOFT_EDGES : features;
+}
+
+// sources
+// -------
+static bool readSource(const std::string& path, std::string& source)
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << path << std::endl;
+        return false;
+    }
+    std::stringstream stream;
+    stream << in.rdbuf();
+    source = stream.str();
+    return true;
+}
+
+// the defines go right after #version, which has to stay the first line
+static std::string specialize(const std::string& source, const std::string& defines)
+{
+    size_t line = source.find('\n');
+    if (line == std::string::npos)
+        return source;
+    return source.substr(0, line + 1) + defines + source.substr(line + 1);
+}
+
+static unsigned int compileStage(GLenum stage, const std::string& source, const std::string& path)
+{
+    unsigned int shader = glCreateShader(stage);
+    const char* text = source.c_str();
+    glShaderSource(shader, 1, &text, NULL);
+    glCompileShader(shader);
+    int success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << (stage == GL_VERTEX_SHADER ? "VERTEX" : "FRAGMENT")
+            << " in " << path << "\n" << log << std::endl;
+    }
+    return shader;
+}
+
+// variants
+// --------
+ShaderVariants::ShaderVariants(const std::string& cacheDirectory)
+    : directory(cacheDirectory)
+{
+}
+
+ShaderVariants::~ShaderVariants()
+{
+    for (auto& entry : programs)
+    {
+        if (entry.second.program())
+            glDeleteProgram(entry.second.program());
+    }
+}
+
+const ProgramUniforms& ShaderVariants::get(const std::string& vertexPath, const std::string& fragmentPath, unsigned int features)
+{
+    std::string name = vertexPath + "+" + fragmentPath + "#" + std::to_string(features);
+    auto it = programs.find(name);
+    if (it != programs.end())
+        return it->second;
+
+    double start = glfwGetTime();
+    unsigned int program = build(vertexPath, fragmentPath, features);
+    buildSeconds += glfwGetTime() - start;
+    if (program)
+        bindUniformBlocks(program);
+    return programs.emplace(name, ProgramUniforms(program)).first->second;
+}
+
+unsigned int ShaderVariants::build(const std::string& vertexPath, const std::string& fragmentPath, unsigned int features)
+{
+    std::string vertexSource, fragmentSource;
+    if (!readSource(vertexPath, vertexSource) || !readSource(fragmentPath, fragmentSource))
+        return 0;
+    std::string defines = featureDefines(features);
+    vertexSource = specialize(vertexSource, defines);
+    fragmentSource = specialize(fragmentSource, defines);
+
+    // a binary is only good for the driver that made it and the exact sources it was linked from
+    GLint formats = 0;
+    if (GLAD_GL_VERSION_4_1)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    bool useCache = !directory.empty() && formats > 0;
+    std::string key, path;
+    unsigned int program = glCreateProgram();
+    if (useCache)
+    {
+        const GLenum strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+        for (GLenum string : strings)
+        {
+            const GLubyte* value = glGetString(string);
+            key += value ? reinterpret_cast<const char*>(value) : "";
+            key += '\n';
+        }
+        key += vertexSource + '\0' + fragmentSource;
+
+        std::string file = vertexPath + "_" + fragmentPath + "_" + std::to_string(features) + ".bin";
+        for (char& c : file)
+        {
+            if (c == '/' || c == '\\' || c == ':')
+                c = '_';
+        }
+        path = directory + "/" + file;
+        if (readBinary(path, key, program))
+        {
+            cached++;
+            return program;
+        }
+    }
+
+    unsigned int vertex = compileStage(GL_VERTEX_SHADER, vertexSource, vertexPath);
+    unsigned int fragment = compileStage(GL_FRAGMENT_SHADER, fragmentSource, fragmentPath);
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    if (useCache)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(program);
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        char log[1024];
+        glGetProgramInfoLog(program, sizeof(log), NULL, log);
+        std::cout << "ERROR::PROGRAM_LINKING_ERROR of " << vertexPath << " + " << fragmentPath << " with features " << features << "\n" << log << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+    compiled++;
+    if (useCache)
+        writeBinary(path, key, program);
+    return program;
+}
+
+// binary cache
+// ------------
+bool ShaderVariants::readBinary(const std::string& path, const std::string& key, unsigned int program) const
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+    char magic[sizeof(PROGRAM_MAGIC)];
+    uint32_t header[4];     // version, key length, binary format, binary length
+    if (!in.read(magic, sizeof(magic)) || std::string(magic, sizeof(magic)) != std::string(PROGRAM_MAGIC, sizeof(PROGRAM_MAGIC))
+        || !in.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != PROGRAM_VERSION || header[1] != key.size())
+        return false;
+    std::string stored(key.size(), '\0');
+    if (!in.read(&stored[0], stored.size()) || stored != key)
+        return false;
+    std::vector<char> binary(header[3]);
+    if (!in.read(binary.data(), binary.size()))
+        return false;
+
+    // a driver may still refuse a binary it wrote, then the variant is compiled as if there were none
+    glProgramBinary(program, header[2], binary.data(), static_cast<GLsizei>(binary.size()));
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    return success != 0;
+}
+
+void ShaderVariants::writeBinary(const std::string& path, const std::string& key, unsigned int program) const
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+#ifdef _WIN32
+    _mkdir(directory.c_str());
+#else
+    mkdir(directory.c_str(), 0755);
+#endif
+    std::ofstream out(path, std::ios::binary);
+    uint32_t header[4] = { PROGRAM_VERSION, static_cast<uint32_t>(key.size()), format, static_cast<uint32_t>(length) };
+    out.write(PROGRAM_MAGIC, sizeof(PROGRAM_MAGIC));
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    out.write(key.data(), key.size());
+    out.write(binary.data(), length);
+    if (!out)
+        std::cout << "ERROR::SHADER_VARIANTS::CACHE_NOT_WRITTEN: " << path << std::endl;
+}
@@ -0,0 +1,78 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include "CommandList.h"
+
+#include <map>
+#include <string>
+
+// Features a variant is compiled with. Each is a #define of 0 or 1 inserted after the #version
+// line of both stages, so a shader tests it with #if; shaders default every feature they know to
+// their best quality when compiled without the defines.
+enum ShaderFeature : unsigned int
+{
+    FEATURE_DISTORTION = 1 << 0,    // ripples and DuDv bend the water's lookups
+    FEATURE_FRESNEL = 1 << 1,       // Schlick's term instead of an even reflection / refraction mix
+    FEATURE_SOFT_EDGES = 1 << 2,    // absorption and the shore fade from the refraction depth
+    FEATURE_OBLIQUE_CLIP = 1 << 3,  // plane passes clip with the projection, not gl_ClipDistance
+    FEATURE_NORMAL_MAP = 1 << 4,    // the scrolling detail layers, see WaterNormals
+    FEATURE_OVERDRAW = 1 << 5       // debug: fragments write 1 instead of shading, see OverdrawView
+};
+const int FEATURE_COUNT = 6;
+
+// A quality tier (Water --quality low|medium|high|ultra): the features the shaders are compiled
+// with and the reflection settings that go with them. low and medium clip the plane passes
+// obliquely and keep half-size jittered targets, low also checkerboards the refraction; high adds
+// soft edges and the detail normals; ultra renders the planes at full size. Anything else is high.
+struct QualityPreset
+{
+    std::string name = "high";
+    unsigned int features = FEATURE_DISTORTION | FEATURE_FRESNEL | FEATURE_SOFT_EDGES | FEATURE_NORMAL_MAP;
+    bool temporal = true;           // PlanarReflections::Temporal
+    bool checkerboard = false;      // PlanarReflections::Checkerboard
+
+    static QualityPreset preset(const std::string& name);
+    static const char* const NAMES[];
+    static const int COUNT = 4;
+};
+
+// Programs for every (vertex, fragment, features) combination asked for, compiled the first time
+// one is asked for and kept until destruction. With GL 4.1 each linked program's binary is written
+// to the cache directory and read back on later runs, keyed by the driver and the preprocessed
+// sources, so only a driver update or an edited shader compiles again.
+// ---------------------------------------------------------------------------------------------
+class ShaderVariants
+{
+public:
+    // cacheDirectory "" compiles every run
+    explicit ShaderVariants(const std::string& cacheDirectory = "shadercache");
+    ~ShaderVariants();
+    ShaderVariants(const ShaderVariants&) = delete;
+    ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+    // GL thread: the variant's uniforms, its uniform blocks bound; program() is 0 if it failed to build
+    const ProgramUniforms& get(const std::string& vertexPath, const std::string& fragmentPath, unsigned int features);
+
+    // variants compiled from source and read from the cache, and the time both took
+    int compiledCount() const { return compiled; }
+    int cachedCount() const { return cached; }
+    double buildMs() const { return buildSeconds * 1000.0; }
+
+private:
+    unsigned int build(const std::string& vertexPath, const std::string& fragmentPath, unsigned int features);
+    bool readBinary(const std::string& path, const std::string& key, unsigned int program) const;
+    void writeBinary(const std::string& path, const std::string& key, unsigned int program) const;
+
+    std::string directory;
+    std::map<std::string, ProgramUniforms> programs;
+    int compiled = 0, cached = 0;
+    double buildSeconds = 0.0;
+};
+
+// the features as the defines inserted into a source
+std::string featureDefines(unsigned int features);
+// features without FEATURE_SOFT_EDGES when they clip obliquely: water.fs linearizes the refraction
+// depth with the main pass's projection, which the oblique clip replaces for the refraction pass
+unsigned int compatibleFeatures(unsigned int features);
+
+#endif
@@ -0,0 +1,317 @@
+#include "SimulationThread.h"
+
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+
+// camera state
+// ------------
+glm::vec3 CameraState::front() const
+{
+    glm::vec3 front;
+    front.x = cos(glm::radians(Yaw)) * cos(glm::radians(Pitch));
+    front.y = sin(glm::radians(Pitch));
+    front.z = sin(glm::radians(Yaw)) * cos(glm::radians(Pitch));
+    return glm::normalize(front);
+}
+
+glm::vec3 CameraState::up() const
+{
+    glm::vec3 right = glm::normalize(glm::cross(front(), glm::vec3(0.0f, 1.0f, 0.0f)));
+    return glm::normalize(glm::cross(right, front()));
+}
+
+glm::mat4 CameraState::viewMatrix(const glm::dvec3& origin) const
+{
+    glm::vec3 eye = toRenderSpace(Position, origin);
+    return glm::lookAt(eye, eye + front(), up());
+}
+
+CameraState CameraState::from(const Camera& camera, const glm::dvec3& position)
+{
+    CameraState state;
+    state.Position = position;
+    state.Yaw = camera.Yaw;
+    state.Pitch = camera.Pitch;
+    state.Zoom = camera.Zoom;
+    return state;
+}
+
+CameraState CameraState::interpolate(const CameraState& a, const CameraState& b, float t)
+{
+    CameraState state;
+    state.Position = glm::mix(a.Position, b.Position, static_cast<double>(t));
+    state.Yaw = glm::mix(a.Yaw, b.Yaw, t);      // yaw is never wrapped by Camera, so this stays continuous
+    state.Pitch = glm::mix(a.Pitch, b.Pitch, t);
+    state.Zoom = glm::mix(a.Zoom, b.Zoom, t);
+    return state;
+}
+
+float SimSnapshot::interpolation(double now) const
+{
+    if (tickInterval <= 0.0)
+        return 1.0f;
+    return static_cast<float>(glm::clamp((now - time) / tickInterval, 0.0, 1.0));
+}
+
+// simulation thread
+// -----------------
+SimulationThread::SimulationThread(const Camera& camera, const SceneDescription& scene, WaterSim* cpuSim, double tickInterval)
+    : camera(camera), cameraPosition(camera.Position), scene(scene), waterSim(cpuSim), waterHeight(scene.waterHeight()), interval(tickInterval),
+    lastCameraPosition(camera.Position)
+{
+    buildGraph();
+}
+
+SimulationThread::~SimulationThread()
+{
+    stop();
+}
+
+void SimulationThread::start()
+{
+    if (running)
+        return;
+
+    // publish tick 0 so the renderer has something to draw before the first tick
+    graph.update();
+    lastCamera = CameraState::from(camera, cameraPosition);
+    SimSnapshot& snapshot = snapshots.writeBuffer();
+    snapshot.tick = 0;
+    snapshot.time = glfwGetTime();
+    snapshot.tickInterval = interval;
+    snapshot.previousCamera = lastCamera;
+    buildScene(snapshot.current);
+    if (waterSim)
+        snapshot.heights = waterSim->heights();
+    snapshots.publish();
+
+    running = true;
+    thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop()
+{
+    running = false;
+    if (thread.joinable())
+        thread.join();
+}
+
+void SimulationThread::submitInput(const SimInput& input)
+{
+    std::lock_guard<std::mutex> lock(inputMutex);
+    pendingInput.forward = input.forward;
+    pendingInput.backward = input.backward;
+    pendingInput.left = input.left;
+    pendingInput.right = input.right;
+    pendingInput.mouseX += input.mouseX;
+    pendingInput.mouseY += input.mouseY;
+    pendingInput.scroll += input.scroll;
+    pendingInput.splash = pendingInput.splash || input.splash;
+}
+
+void SimulationThread::addBoundary(const std::vector<Mesh>* meshes, const glm::mat4& model)
+{
+    std::lock_guard<std::mutex> lock(inputMutex);
+    pendingBoundaries.push_back(std::make_pair(meshes, model));
+}
+
+void SimulationThread::setModelBounds(unsigned int model, const DrawBounds& bounds)
+{
+    std::lock_guard<std::mutex> lock(inputMutex);
+    pendingBounds.push_back(std::make_pair(model, bounds));
+}
+
+void SimulationThread::run()
+{
+    double next = glfwGetTime();
+    while (running)
+    {
+        double now = glfwGetTime();
+        if (now < next)
+        {
+            std::this_thread::sleep_for(std::chrono::duration<double>(next - now));
+            continue;
+        }
+        // fell far behind (debugger, window drag): skip ahead instead of spiralling
+        if (now - next > 8.0 * interval)
+            next = now;
+        tick(next);
+        next += interval;
+    }
+}
+
+void SimulationThread::buildGraph()
+{
+    // instances are roots; every water body is a root with its tiles as children
+    graph.clear();
+    instanceNodes.clear();
+    waterNodes.clear();
+    waterBodies.clear();
+    for (const SceneInstance& instance : scene.instances)
+        instanceNodes.push_back(graph.addNode(SceneGraph::NO_PARENT, instance.transform()));
+
+    // unit quad in its local xy plane
+    const DrawBounds quad = { glm::dvec3(0.0), 0.7072f };
+    std::vector<glm::mat4> tiles;
+    for (unsigned int i = 0; i < scene.water.size(); i++)
+    {
+        const SceneWater& body = scene.water[i];
+        unsigned int bodyNode = graph.addNode(SceneGraph::NO_PARENT, glm::translate(glm::dmat4(1.0), body.center));
+        body.tileTransforms(tiles);
+        for (const glm::mat4& tile : tiles)
+        {
+            waterNodes.push_back(graph.addNode(bodyNode, glm::dmat4(tile), quad));
+            waterBodies.push_back(i);
+        }
+    }
+}
+
+void SimulationThread::buildScene(SceneState& state) const
+{
+    state.camera = CameraState::from(camera, cameraPosition);
+
+    // the snapshot buffers rotate, each one catches up with the graph on its own
+    if (state.version == graph.version())
+        return;
+    state.version = graph.version();
+    state.instances.resize(instanceNodes.size());
+    for (size_t i = 0; i < instanceNodes.size(); i++)
+        state.instances[i] = { scene.instances[i].model, graph.world(instanceNodes[i]), graph.worldBounds(instanceNodes[i]) };
+    state.waterTransforms.resize(waterNodes.size());
+    state.waterBounds.resize(waterNodes.size());
+    state.waterBodies = waterBodies;
+    for (size_t i = 0; i < waterNodes.size(); i++)
+    {
+        state.waterTransforms[i] = graph.world(waterNodes[i]);
+        state.waterBounds[i] = graph.worldBounds(waterNodes[i]);
+    }
+}
+
+void SimulationThread::disturb(glm::vec2 position, float radius, float strength)
+{
+    TickDisturbance& entry = disturbanceRing[disturbanceCount % SimSnapshot::DISTURBANCE_HISTORY];
+    entry.tick = tickCount.load(std::memory_order_relaxed) + 1;
+    entry.disturbance = { position, radius, strength };
+    disturbanceCount++;
+    if (waterSim)
+        waterSim->addDisturbance(position, radius, strength);
+}
+
+void SimulationThread::tick(double now)
+{
+    SimInput input;
+    std::vector<std::pair<const std::vector<Mesh>*, glm::mat4>> boundaries;
+    std::vector<std::pair<unsigned int, DrawBounds>> bounds;
+    {
+        std::lock_guard<std::mutex> lock(inputMutex);
+        input = pendingInput;
+        pendingInput.mouseX = pendingInput.mouseY = pendingInput.scroll = 0.0f;
+        pendingInput.splash = false;
+        boundaries.swap(pendingBoundaries);
+        bounds.swap(pendingBounds);
+    }
+    if (waterSim)
+    {
+        for (const auto& boundary : boundaries)
+            waterSim->buildBoundaryFromMeshes(*boundary.first, boundary.second, waterHeight);
+    }
+
+    // camera: Camera::ProcessKeyboard's movement, accumulated in double
+    float dt = static_cast<float>(interval);
+    double velocity = static_cast<double>(camera.MovementSpeed * dt);
+    if (input.forward)
+        cameraPosition += glm::dvec3(camera.Front) * velocity;
+    if (input.backward)
+        cameraPosition -= glm::dvec3(camera.Front) * velocity;
+    if (input.left)
+        cameraPosition -= glm::dvec3(camera.Right) * velocity;
+    if (input.right)
+        cameraPosition += glm::dvec3(camera.Right) * velocity;
+    camera.Position = glm::vec3(cameraPosition);
+    if (input.mouseX != 0.0f || input.mouseY != 0.0f)
+        camera.ProcessMouseMovement(input.mouseX, input.mouseY);
+    if (input.scroll != 0.0f)
+        camera.ProcessMouseScroll(input.scroll);
+
+    // ripples where the camera skims the surface, splash where it looks on click;
+    // the wave solver works in float world coordinates around its own origin
+    glm::dvec3 moved = cameraPosition - lastCameraPosition;
+    lastCameraPosition = cameraPosition;
+    glm::vec2 cameraXZ(cameraPosition.x, cameraPosition.z);
+    float speed = static_cast<float>(glm::length(glm::dvec2(moved.x, moved.z))) / dt;
+    float surface = waterSim ? waterSim->heightAt(cameraXZ) : surfaceHeight.load(std::memory_order_relaxed);
+    if (std::abs(cameraPosition.y - (waterHeight + surface)) < 0.3 && speed > 0.01f)
+        disturb(cameraXZ, 0.15f, -0.01f * std::min(speed, 5.0f));
+    if (input.splash && camera.Front.y < 0.0f)
+    {
+        double t = (waterHeight - cameraPosition.y) / camera.Front.y;
+        glm::dvec3 hit = cameraPosition + glm::dvec3(camera.Front) * t;
+        disturb(glm::vec2(hit.x, hit.z), 0.2f, 0.1f);
+    }
+
+    // waves
+    if (waterSim)
+        waterSim->step();
+
+    // scene: only nodes touched since the last tick and their children are recomputed
+    for (const auto& modelBounds : bounds)
+    {
+        for (size_t i = 0; i < instanceNodes.size(); i++)
+        {
+            if (scene.instances[i].model == modelBounds.first)
+                graph.setLocalBounds(instanceNodes[i], modelBounds.second);
+        }
+    }
+    graph.update();
+
+    // hand the tick to the renderer
+    SimSnapshot& snapshot = snapshots.writeBuffer();
+    snapshot.tick = tickCount.load(std::memory_order_relaxed) + 1;
+    snapshot.time = now;
+    snapshot.tickInterval = interval;
+    snapshot.previousCamera = lastCamera;
+    buildScene(snapshot.current);
+    lastCamera = snapshot.current.camera;
+    std::copy(std::begin(disturbanceRing), std::end(disturbanceRing), std::begin(snapshot.disturbances));
+    snapshot.disturbanceCount = disturbanceCount;
+    if (waterSim)
+        snapshot.heights = waterSim->heights();
+    snapshots.publish();
+    tickCount.store(snapshot.tick, std::memory_order_relaxed);
+}
+
+// render thread: bring the water textures up to the snapshot's tick
+// -----------------------------------------------------------------
+void syncWaterSim(WaterSim& sim, const SimSnapshot& snapshot, uint64_t& appliedTick)
+{
+    if (snapshot.tick == appliedTick)
+        return;
+
+    if (sim.backend() == WaterSimBackend::CPU)
+    {
+        if (snapshot.heights.size() == static_cast<size_t>(sim.resolution()) * sim.resolution())
+            sim.uploadHeights(snapshot.heights);
+        appliedTick = snapshot.tick;
+        return;
+    }
+
+    // replay the ticks we have not seen yet on the GPU solver, at most MaxStepsPerUpdate of them
+    uint64_t first = appliedTick + 1;
+    if (snapshot.tick - appliedTick > static_cast<uint64_t>(sim.MaxStepsPerUpdate))
+        first = snapshot.tick - sim.MaxStepsPerUpdate + 1;
+    uint64_t oldest = snapshot.disturbanceCount > SimSnapshot::DISTURBANCE_HISTORY ? snapshot.disturbanceCount - SimSnapshot::DISTURBANCE_HISTORY : 0;
+    for (uint64_t tick = first; tick <= snapshot.tick; tick++)
+    {
+        for (uint64_t i = oldest; i < snapshot.disturbanceCount; i++)
+        {
+            const TickDisturbance& entry = snapshot.disturbances[i % SimSnapshot::DISTURBANCE_HISTORY];
+            if (entry.tick == tick)
+                sim.addDisturbance(entry.disturbance.position, entry.disturbance.radius, entry.disturbance.strength);
+        }
+        sim.step();
+    }
+    appliedTick = snapshot.tick;
+}
@@ -0,0 +1,168 @@
+#ifndef SIMULATION_THREAD_H
+#define SIMULATION_THREAD_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/camera.h>
+
+#include "SceneFile.h"
+#include "SceneGraph.h"
+#include "TripleBuffer.h"
+#include "WaterSim.h"
+#include "WorldSpace.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Input gathered on the GLFW thread and consumed by the simulation at its next tick
+struct SimInput
+{
+    bool forward = false;
+    bool backward = false;
+    bool left = false;
+    bool right = false;
+    float mouseX = 0.0f;    // accumulated look offsets since the last submit
+    float mouseY = 0.0f;
+    float scroll = 0.0f;
+    bool splash = false;    // left click went down since the last submit
+};
+
+// The parts of Camera the renderer needs, small enough to copy and blend
+struct CameraState
+{
+    glm::dvec3 Position = glm::dvec3(0.0);    // world space
+    float Yaw = YAW;
+    float Pitch = PITCH;
+    float Zoom = ZOOM;
+
+    glm::vec3 front() const;
+    glm::vec3 up() const;
+    // view matrix in render space around origin
+    glm::mat4 viewMatrix(const glm::dvec3& origin) const;
+
+    static CameraState from(const Camera& camera, const glm::dvec3& position);
+    static CameraState interpolate(const CameraState& a, const CameraState& b, float t);
+};
+
+// A placed model as the renderer sees it
+struct InstanceState
+{
+    unsigned int model;
+    glm::dmat4 transform;
+    DrawBounds bounds;      // world space, radius 0 until the model streamed in
+};
+
+// Everything that changes per simulation tick. Instances and water tiles come out of the
+// scene graph's cache and are only copied again when the graph changed (version).
+struct SceneState
+{
+    CameraState camera;
+    uint64_t version = ~0ull;
+    std::vector<InstanceState> instances;
+    std::vector<glm::dmat4> waterTransforms;
+    std::vector<DrawBounds> waterBounds;
+    std::vector<unsigned int> waterBodies;    // scene water body of each tile
+};
+
+// A disturbance together with the tick it has to be applied before
+struct TickDisturbance
+{
+    uint64_t tick;
+    WaterDisturbance disturbance;
+};
+
+// Immutable view of the simulation handed to the renderer
+struct SimSnapshot
+{
+    static const int DISTURBANCE_HISTORY = 64;
+
+    uint64_t tick = 0;
+    double time = 0.0;          // glfwGetTime() of the tick that produced `current`
+    double tickInterval = 0.0;
+    CameraState previousCamera;    // camera of the tick before `current`
+    SceneState current;
+
+    // recent disturbances, so a renderer that skipped snapshots can still replay them on the GPU solver
+    TickDisturbance disturbances[DISTURBANCE_HISTORY];
+    uint64_t disturbanceCount = 0;  // total ever emitted, the ring holds the newest DISTURBANCE_HISTORY
+    // heights after `tick` when the CPU solver runs on the simulation thread
+    std::vector<float> heights;
+
+    // blend factor from previous to current for a frame rendered at `now`
+    float interpolation(double now) const;
+};
+
+// Runs camera movement, scene transforms and the wave solver at a fixed tick on its own
+// thread. The renderer picks up the newest snapshot through a lock-free triple buffer and
+// draws in between the last two ticks, so simulation cost overlaps with GPU submission.
+// -------------------------------------------------------------------------------------
+class SimulationThread
+{
+public:
+    // cpuSim is stepped on the simulation thread; pass nullptr when the solver runs on the GPU
+    SimulationThread(const Camera& camera, const SceneDescription& scene, WaterSim* cpuSim, double tickInterval);
+    ~SimulationThread();
+
+    void start();
+    void stop();
+
+    // GLFW thread
+    void submitInput(const SimInput& input);
+    // add walls to the CPU solver at the next tick, e.g. once a model has streamed in;
+    // meshes has to stay alive until then
+    void addBoundary(const std::vector<Mesh>* meshes, const glm::mat4& model);
+    // local bounds of a scene model once it streamed in, applied to its instances at the next tick
+    void setModelBounds(unsigned int model, const DrawBounds& bounds);
+    // height of the GPU-simulated surface under the camera, as seen by the renderer
+    void setSurfaceHeight(float height) { surfaceHeight.store(height, std::memory_order_relaxed); }
+    // render thread: newest snapshot, returns true if it changed since the last call
+    bool acquire() { return snapshots.acquire(); }
+    const SimSnapshot& snapshot() const { return snapshots.readBuffer(); }
+
+    uint64_t ticks() const { return tickCount.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+    void tick(double now);
+    void buildGraph();
+    void buildScene(SceneState& scene) const;
+    void disturb(glm::vec2 position, float radius, float strength);
+
+    Camera camera;
+    glm::dvec3 cameraPosition;    // Camera::Position is float and would lose small steps far from the origin
+    const SceneDescription& scene;
+    WaterSim* waterSim;
+    float waterHeight;
+    double interval;
+
+    std::mutex inputMutex;
+    SimInput pendingInput;
+    std::vector<std::pair<const std::vector<Mesh>*, glm::mat4>> pendingBoundaries;
+    std::vector<std::pair<unsigned int, DrawBounds>> pendingBounds;
+
+    std::atomic<float> surfaceHeight{ 0.0f };
+    std::atomic<bool> running{ false };
+    std::atomic<uint64_t> tickCount{ 0 };
+    std::thread thread;
+
+    // simulation-thread state
+    SceneGraph graph;
+    std::vector<unsigned int> instanceNodes;    // per scene instance
+    std::vector<unsigned int> waterNodes;       // every water tile, bodies in scene order
+    std::vector<unsigned int> waterBodies;      // body of each tile
+    CameraState lastCamera;
+    TickDisturbance disturbanceRing[SimSnapshot::DISTURBANCE_HISTORY];
+    uint64_t disturbanceCount = 0;
+    glm::dvec3 lastCameraPosition;
+
+    TripleBuffer<SimSnapshot> snapshots;
+};
+
+// render thread: step (GPU) or upload (CPU) the water so heightTexture() matches the snapshot
+void syncWaterSim(WaterSim& sim, const SimSnapshot& snapshot, uint64_t& appliedTick);
+
+#endif
@@ -0,0 +1,387 @@
+#include "Terrain.h"
+#include "DrawList.h"
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <iostream>
+
+Terrain::~Terrain()
+{
+    if (textureArray)
+        glDeleteTextures(1, &textureArray);
+    if (gridVertexArray)
+    {
+        glDeleteVertexArrays(1, &gridVertexArray);
+        glDeleteBuffers(1, &gridVertexBuffer);
+        glDeleteBuffers(1, &gridElementBuffer);
+    }
+}
+
+// loading
+// -------
+bool Terrain::load(const SceneTerrain& terrainSettings)
+{
+    settings = terrainSettings;
+    int width, height, channels;
+    unsigned char* data = stbi_load(settings.path.c_str(), &width, &height, &channels, 4);
+    if (!data)
+    {
+        std::cout << "ERROR::TERRAIN::IMAGE_NOT_LOADED: " << settings.path << std::endl;
+        return false;
+    }
+
+    // the largest power of two number of 64 texel tiles that fits the image
+    const int tileSpan = TILE_TEXELS - 1;
+    int side = tileSpan;
+    while (side * 2 <= std::min(width, height))
+        side *= 2;
+    leafTiles = side / tileSpan;
+    levelCount = 1;
+    while ((leafTiles >> (levelCount - 1)) > 1)
+        levelCount++;
+
+    // level 0: colour in rgb, luminance as height in alpha. The image carries no elevation, so
+    // brightness stands in for it
+    pyramid.assign(levelCount, std::vector<unsigned char>());
+    pyramid[0].resize(static_cast<size_t>(side) * side * 4);
+    for (int z = 0; z < side; z++)
+    {
+        for (int x = 0; x < side; x++)
+        {
+            const unsigned char* src = data + (static_cast<size_t>(z * height / side) * width + x * width / side) * 4;
+            unsigned char* dst = &pyramid[0][(static_cast<size_t>(z) * side + x) * 4];
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+            dst[3] = static_cast<unsigned char>(0.2126f * src[0] + 0.7152f * src[1] + 0.0722f * src[2] + 0.5f);
+        }
+    }
+    stbi_image_free(data);
+
+    // every coarser level averages 2x2 texels of the one below
+    for (int level = 1; level < levelCount; level++)
+    {
+        int size = side >> level;
+        const std::vector<unsigned char>& fine = pyramid[level - 1];
+        std::vector<unsigned char>& coarse = pyramid[level];
+        coarse.resize(static_cast<size_t>(size) * size * 4);
+        for (int z = 0; z < size; z++)
+        {
+            for (int x = 0; x < size; x++)
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    int sum = fine[((static_cast<size_t>(2 * z) * 2 * size) + 2 * x) * 4 + c] + fine[((static_cast<size_t>(2 * z) * 2 * size) + 2 * x + 1) * 4 + c]
+                        + fine[((static_cast<size_t>(2 * z + 1) * 2 * size) + 2 * x) * 4 + c] + fine[((static_cast<size_t>(2 * z + 1) * 2 * size) + 2 * x + 1) * 4 + c];
+                    coarse[(static_cast<size_t>(z) * size + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+                }
+            }
+        }
+    }
+
+    // height bounds: leaves from the full-resolution texels, parents as the union of their children;
+    // averaged coarse tiles always stay inside them
+    heightBounds.assign(levelCount, std::vector<glm::vec2>());
+    heightBounds[0].resize(static_cast<size_t>(leafTiles) * leafTiles);
+    for (int tz = 0; tz < leafTiles; tz++)
+    {
+        for (int tx = 0; tx < leafTiles; tx++)
+        {
+            int lo = 255, hi = 0;
+            for (int z = tz * tileSpan; z <= std::min(tz * tileSpan + tileSpan, side - 1); z++)
+            {
+                for (int x = tx * tileSpan; x <= std::min(tx * tileSpan + tileSpan, side - 1); x++)
+                {
+                    int value = pyramid[0][(static_cast<size_t>(z) * side + x) * 4 + 3];
+                    lo = std::min(lo, value);
+                    hi = std::max(hi, value);
+                }
+            }
+            heightBounds[0][static_cast<size_t>(tz) * leafTiles + tx] = glm::vec2(lo, hi) / 255.0f * settings.heightScale;
+        }
+    }
+    for (int level = 1; level < levelCount; level++)
+    {
+        int tiles = leafTiles >> level;
+        const std::vector<glm::vec2>& children = heightBounds[level - 1];
+        heightBounds[level].resize(static_cast<size_t>(tiles) * tiles);
+        for (int z = 0; z < tiles; z++)
+        {
+            for (int x = 0; x < tiles; x++)
+            {
+                glm::vec2 bounds(1e30f, -1e30f);
+                for (int i = 0; i < 4; i++)
+                {
+                    const glm::vec2& child = children[static_cast<size_t>(2 * z + i / 2) * 2 * tiles + 2 * x + i % 2];
+                    bounds = glm::vec2(std::min(bounds.x, child.x), std::max(bounds.y, child.y));
+                }
+                heightBounds[level][static_cast<size_t>(z) * tiles + x] = bounds;
+            }
+        }
+    }
+    return true;
+}
+
+void Terrain::createGpuResources(unsigned int cacheTiles)
+{
+    if (levelCount == 0 || textureArray)
+        return;
+    cacheTiles = std::max(cacheTiles, 1u);
+
+    // tile cache
+    glGenTextures(1, &textureArray);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, TILE_TEXELS, TILE_TEXELS, cacheTiles, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    slotKeys.assign(cacheTiles, 0);
+    lruPrev.assign(cacheTiles, -1);
+    lruNext.assign(cacheTiles, -1);
+    slotFrame.assign(cacheTiles, 0);
+    scratch.resize(TILE_BYTES);
+
+    // the root is uploaded into layer 0 and never evicted, so every chunk has something to sample
+    upload(key(levelCount - 1, 0, 0), 0);
+    freeSlots = 1;
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    // chunk mesh: a unit grid, scaled and displaced per chunk in terrain.vs
+    std::vector<glm::vec2> vertices;
+    for (int z = 0; z <= GRID; z++)
+    {
+        for (int x = 0; x <= GRID; x++)
+            vertices.push_back(glm::vec2(x, z) / static_cast<float>(GRID));
+    }
+    std::vector<unsigned int> indices;
+    for (int z = 0; z < GRID; z++)
+    {
+        for (int x = 0; x < GRID; x++)
+        {
+            unsigned int corner = z * (GRID + 1) + x;
+            unsigned int quad[6] = { corner, corner + GRID + 1, corner + 1, corner + 1, corner + GRID + 1, corner + GRID + 2 };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+    glGenVertexArrays(1, &gridVertexArray);
+    glGenBuffers(1, &gridVertexBuffer);
+    glGenBuffers(1, &gridElementBuffer);
+    glBindVertexArray(gridVertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, gridVertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec2), vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gridElementBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+    glBindVertexArray(0);
+}
+
+// selection
+// ---------
+float Terrain::range(int level) const
+{
+    return LeafRange * settings.size / leafTiles * static_cast<float>(1 << level);
+}
+
+void Terrain::nodeBounds(const Node& node, const glm::dvec3& origin, glm::vec3& lo, glm::vec3& hi) const
+{
+    // corners in world space are doubles, only the offset from the render origin is rounded
+    int tiles = leafTiles >> node.level;
+    double size = static_cast<double>(settings.size) / tiles;
+    const glm::vec2& heights = heightBounds[node.level][static_cast<size_t>(node.z) * tiles + node.x];
+    glm::dvec3 corner = settings.center + glm::dvec3(node.x * size - 0.5 * settings.size, 0.0, node.z * size - 0.5 * settings.size);
+    lo = toRenderSpace(corner + glm::dvec3(0.0, heights.x, 0.0), origin);
+    hi = toRenderSpace(corner + glm::dvec3(size, heights.y, size), origin);
+}
+
+void Terrain::select(const Frustum& frustum, const glm::dvec3& origin, const glm::vec3& eye, float waterHeight, float side, TerrainSelection& selection) const
+{
+    selection.chunks.clear();
+    selection.requests.clear();
+    selection.origin = origin;
+    if (!ready())
+        return;
+    // beyond the root's range the whole terrain is one chunk
+    Node root = { levelCount - 1, 0, 0 };
+    if (!selectNode(root, frustum, eye, waterHeight, side, selection))
+        addChunk(root, selection);
+}
+
+bool Terrain::selectNode(const Node& node, const Frustum& frustum, const glm::vec3& eye, float waterHeight, float side, TerrainSelection& selection) const
+{
+    glm::vec3 lo, hi;
+    nodeBounds(node, selection.origin, lo, hi);
+    // culled nodes are handled: nothing to draw
+    if (side > 0.0f && hi.y < waterHeight)
+        return true;
+    if (side < 0.0f && lo.y > waterHeight)
+        return true;
+    if (!frustum.intersects((lo + hi) * 0.5f, glm::length(hi - lo) * 0.5f))
+        return true;
+
+    float distance = glm::length(glm::max(glm::max(lo - eye, eye - hi), glm::vec3(0.0f)));
+    if (distance > range(node.level))
+        return false;
+    // within this level's range but not the next finer one: draw the node itself
+    if (node.level == 0 || distance > range(node.level - 1))
+    {
+        addChunk(node, selection);
+        return true;
+    }
+    // children out of their own range are drawn at their level, fully morphed to this one's grid
+    for (int i = 0; i < 4; i++)
+    {
+        Node child = { node.level - 1, node.x * 2 + i % 2, node.z * 2 + i / 2 };
+        if (!selectNode(child, frustum, eye, waterHeight, side, selection))
+            addChunk(child, selection);
+    }
+    return true;
+}
+
+void Terrain::addChunk(const Node& node, TerrainSelection& selection) const
+{
+    glm::vec3 lo, hi;
+    nodeBounds(node, selection.origin, lo, hi);
+
+    // the chunk's own tile, or the closest ancestor that is resident while it streams in
+    int level = node.level, x = node.x, z = node.z;
+    auto found = resident.find(key(level, x, z));
+    if (found == resident.end())
+        selection.requests.push_back(key(level, x, z));
+    while (found == resident.end() && level + 1 < levelCount)
+    {
+        level++;
+        x >>= 1;
+        z >>= 1;
+        found = resident.find(key(level, x, z));
+    }
+    if (found == resident.end())
+        return;
+
+    int steps = level - node.level;
+    float scale = 1.0f / static_cast<float>(1 << steps);
+    TerrainChunk chunk;
+    chunk.area = glm::vec4(lo.x, lo.z, hi.x - lo.x, static_cast<float>(node.level));
+    chunk.tile = glm::vec4(static_cast<float>(found->second), (node.x - (x << steps)) * scale, (node.z - (z << steps)) * scale, scale);
+    chunk.morph = glm::vec4(MorphStart * range(node.level), range(node.level), 0.0f, 0.0f);
+    selection.chunks.push_back(chunk);
+}
+
+// residency
+// ---------
+void Terrain::stream(const std::vector<const TerrainSelection*>& selections)
+{
+    frame++;
+    frameStats = TerrainStats();
+    if (!ready())
+        return;
+
+    // everything sampled this frame moves to the front and may not be evicted before the frame is drawn
+    std::vector<uint32_t> wanted;
+    for (const TerrainSelection* selection : selections)
+    {
+        for (const TerrainChunk& chunk : selection->chunks)
+        {
+            int slot = static_cast<int>(chunk.tile.x);
+            slotFrame[slot] = frame;
+            touch(slot);
+        }
+        frameStats.chunks += selection->chunks.size();
+        wanted.insert(wanted.end(), selection->requests.begin(), selection->requests.end());
+    }
+    frameStats.triangles = frameStats.chunks * GRID * GRID * 2;
+
+    // coarse tiles first: they cover the most chunks while the finer ones catch up
+    std::sort(wanted.begin(), wanted.end(), [](uint32_t a, uint32_t b) { return a > b; });
+    wanted.erase(std::unique(wanted.begin(), wanted.end()), wanted.end());
+    frameStats.requests = wanted.size();
+    for (uint32_t tileKey : wanted)
+    {
+        if (frameStats.uploads >= static_cast<size_t>(UploadBudget))
+            break;
+        if (resident.count(tileKey))
+            continue;
+        int slot = acquireSlot();
+        if (slot < 0)
+            break;
+        upload(tileKey, slot);
+    }
+    frameStats.residentTiles = resident.size();
+}
+
+int Terrain::acquireSlot()
+{
+    if (freeSlots < static_cast<int>(slotKeys.size()))
+        return freeSlots++;
+    // the least recently used layer, unless this frame's draws still sample it
+    int slot = lruTail;
+    if (slot < 0 || slotFrame[slot] == frame)
+        return -1;
+    unlink(slot);
+    resident.erase(slotKeys[slot]);
+    return slot;
+}
+
+void Terrain::upload(uint32_t tileKey, int slot)
+{
+    int level = static_cast<int>(tileKey >> 26);
+    int x = static_cast<int>((tileKey >> 13) & 0x1fff);
+    int z = static_cast<int>(tileKey & 0x1fff);
+    const std::vector<unsigned char>& source = pyramid[level];
+    int size = (leafTiles * (TILE_TEXELS - 1)) >> level;
+
+    // the far row and column are the neighbour's first ones, repeated at the terrain's edge
+    for (int row = 0; row < TILE_TEXELS; row++)
+    {
+        int sz = std::min(z * (TILE_TEXELS - 1) + row, size - 1);
+        for (int column = 0; column < TILE_TEXELS; column++)
+        {
+            int sx = std::min(x * (TILE_TEXELS - 1) + column, size - 1);
+            std::copy_n(&source[(static_cast<size_t>(sz) * size + sx) * 4], 4, &scratch[(static_cast<size_t>(row) * TILE_TEXELS + column) * 4]);
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, slot, TILE_TEXELS, TILE_TEXELS, 1, GL_RGBA, GL_UNSIGNED_BYTE, scratch.data());
+
+    resident[tileKey] = slot;
+    slotKeys[slot] = tileKey;
+    if (slot != 0)
+    {
+        lruPrev[slot] = lruNext[slot] = -1;
+        touch(slot);
+    }
+    frameStats.uploads++;
+    frameStats.uploadBytes += TILE_BYTES;
+}
+
+void Terrain::touch(int slot)
+{
+    // layer 0 holds the pinned root and is not part of the list
+    if (slot == 0 || slot == lruHead)
+        return;
+    unlink(slot);
+    lruNext[slot] = lruHead;
+    lruPrev[slot] = -1;
+    if (lruHead >= 0)
+        lruPrev[lruHead] = slot;
+    lruHead = slot;
+    if (lruTail < 0)
+        lruTail = slot;
+}
+
+void Terrain::unlink(int slot)
+{
+    int prev = lruPrev[slot], next = lruNext[slot];
+    if (prev >= 0)
+        lruNext[prev] = next;
+    else if (lruHead == slot)
+        lruHead = next;
+    if (next >= 0)
+        lruPrev[next] = prev;
+    else if (lruTail == slot)
+        lruTail = prev;
+    lruPrev[slot] = lruNext[slot] = -1;
+}
@@ -0,0 +1,133 @@
+#ifndef TERRAIN_H
+#define TERRAIN_H
+
+#include <glm/glm.hpp>
+
+#include "SceneFile.h"
+#include "WorldSpace.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct Frustum;
+
+// One chunk picked by Terrain::select, in the layout of the shaders' TerrainBlock
+struct TerrainChunk
+{
+    glm::vec4 area;     // min corner x, z in render space, size, LOD level
+    glm::vec4 tile;     // texture array layer, uv offset, uv scale into that layer
+    glm::vec4 morph;    // morph start and end distance
+};
+
+// What one pass selected: chunks to draw and tiles it wanted but found missing
+struct TerrainSelection
+{
+    std::vector<TerrainChunk> chunks;
+    std::vector<uint32_t> requests;
+    glm::dvec3 origin = glm::dvec3(0.0);    // render origin the chunk corners are relative to
+};
+
+struct TerrainStats
+{
+    size_t chunks = 0;          // summed over every pass of the frame
+    size_t triangles = 0;
+    size_t residentTiles = 0;
+    size_t uploads = 0;         // tiles streamed in this frame
+    size_t uploadBytes = 0;
+    size_t requests = 0;        // distinct missing tiles asked for this frame
+};
+
+// Heightmapped ground in a quadtree of chunks, drawn CDLOD style: every chunk is the same
+// GRID x GRID mesh scaled to its node, and vertices morph towards the next coarser grid as they
+// approach the end of their level's range, so neighbours of different levels meet without seams.
+// Every node has a colour + height tile cut from a mip pyramid of the source image. Tiles live in
+// a fixed texture array managed as an LRU cache; chunks whose tile is not resident yet sample the
+// nearest resident ancestor until stream() has uploaded it.
+// -----------------------------------------------------------------------------------------------
+class Terrain
+{
+public:
+    static const int GRID = 32;                     // quads per chunk side
+    static const int TILE_TEXELS = 65;              // texels per tile side, the last row repeats the neighbour's first
+    static const int TILE_BYTES = TILE_TEXELS * TILE_TEXELS * 4;
+
+    // tuning, read by select() and stream()
+    float LeafRange = 2.0f;         // draw distance of the finest level, in leaf chunk sizes; doubles per level
+    float MorphStart = 0.75f;       // fraction of a level's range where morphing begins
+    int UploadBudget = 8;           // tiles per frame
+
+    Terrain() = default;
+    ~Terrain();
+    Terrain(const Terrain&) = delete;
+    Terrain& operator=(const Terrain&) = delete;
+
+    // any thread, no GL: decode the image and build the tile pyramid and height bounds
+    bool load(const SceneTerrain& settings);
+    // GL thread: allocate cacheTiles texture array layers and the chunk mesh, the root tile stays resident
+    void createGpuResources(unsigned int cacheTiles = 128);
+    bool ready() const { return textureArray != 0; }
+
+    // pick the chunks for one pass camera; frustum, eye and waterHeight are in the render space of
+    // origin. side > 0 keeps what reaches above waterHeight, side < 0 what reaches below it, 0
+    // everything. Safe to call from several threads at once as long as stream() does not run at the
+    // same time.
+    void select(const Frustum& frustum, const glm::dvec3& origin, const glm::vec3& eye, float waterHeight, float side, TerrainSelection& selection) const;
+    // GL thread, after the frame's selections: refresh the LRU and upload missing tiles within budget
+    void stream(const std::vector<const TerrainSelection*>& selections);
+
+    const SceneTerrain& placement() const { return settings; }
+    unsigned int texture() const { return textureArray; }
+    unsigned int vertexArray() const { return gridVertexArray; }
+    int indexCount() const { return GRID * GRID * 6; }
+    int levels() const { return levelCount; }
+    size_t cacheCapacity() const { return slotKeys.size(); }
+    const TerrainStats& stats() const { return frameStats; }
+
+    static uint32_t key(int level, int x, int z) { return static_cast<uint32_t>(level) << 26 | static_cast<uint32_t>(x) << 13 | static_cast<uint32_t>(z); }
+
+private:
+    struct Node
+    {
+        int level, x, z;
+    };
+
+    // culls one node, returns false when it is out of its level's range and the parent has to draw it
+    bool selectNode(const Node& node, const Frustum& frustum, const glm::vec3& eye, float waterHeight, float side, TerrainSelection& selection) const;
+    void addChunk(const Node& node, TerrainSelection& selection) const;
+    void nodeBounds(const Node& node, const glm::dvec3& origin, glm::vec3& lo, glm::vec3& hi) const;
+    float range(int level) const;
+
+    int acquireSlot();
+    void upload(uint32_t tileKey, int slot);
+    void touch(int slot);
+    void unlink(int slot);
+
+    SceneTerrain settings;
+    int levelCount = 0;
+    int leafTiles = 0;     // chunks per side at level 0
+    // RGBA, alpha is height; pyramid[level] is (leafTiles * 64 >> level)^2 texels
+    std::vector<std::vector<unsigned char>> pyramid;
+    // lowest and highest height per node above the placement centre, [level][z * tiles + x]
+    std::vector<std::vector<glm::vec2>> heightBounds;
+
+    unsigned int textureArray = 0;
+    unsigned int gridVertexArray = 0;
+    unsigned int gridVertexBuffer = 0;
+    unsigned int gridElementBuffer = 0;
+
+    // residency: tile key -> array layer, LRU list over layers (head = most recent)
+    std::unordered_map<uint32_t, int> resident;
+    std::vector<uint32_t> slotKeys;
+    std::vector<int> lruPrev, lruNext;
+    std::vector<uint64_t> slotFrame;    // last frame a chunk sampled the layer
+    int lruHead = -1, lruTail = -1;
+    int freeSlots = 0;
+    uint64_t frame = 0;
+    std::vector<unsigned char> scratch;
+
+    TerrainStats frameStats;
+};
+
+#endif
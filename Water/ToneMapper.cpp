@@ -0,0 +1,99 @@
+#include "ToneMapper.h"
+
+#include <glad/glad.h>
+
+#include <iostream>
+
+ToneMapper::~ToneMapper()
+{
+    destroy();
+}
+
+void ToneMapper::destroy()
+{
+    if (!framebuffer)
+        return;
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(1, &color);
+    if (ownsDepth)
+        glDeleteRenderbuffers(1, &depth);
+    glDeleteVertexArrays(1, &emptyVertexArray);
+    framebuffer = 0;
+}
+
+// setup
+// -----
+void ToneMapper::create(int width, int height, const RenderFormats& targetFormats, unsigned int toneMapProgram, unsigned int depthRenderbuffer)
+{
+    destroy();
+    formats = targetFormats;
+    sceneWidth = width;
+    sceneHeight = height;
+    program = toneMapProgram;
+
+    glGenTextures(1, &color);
+    formats.allocateColor(color, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // nothing samples the main pass depth, so it can be anyone's
+    depth = depthRenderbuffer;
+    ownsDepth = depth == 0;
+    if (ownsDepth)
+    {
+        glGenRenderbuffers(1, &depth);
+        formats.allocateDepthRenderbuffer(depth, width, height);
+    }
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, formats.depthAttachment(), GL_RENDERBUFFER, depth);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glGenVertexArrays(1, &emptyVertexArray);
+}
+
+size_t ToneMapper::targetBytes() const
+{
+    size_t pixels = static_cast<size_t>(sceneWidth) * sceneHeight;
+    return pixels * (formats.colorBytes() + (ownsDepth ? formats.depthBytes() : 0));
+}
+
+// frame
+// -----
+void ToneMapper::beginScene()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, sceneWidth, sceneHeight);
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+}
+
+void ToneMapper::present(unsigned int scene, unsigned int target, int targetWidth, int targetHeight) const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+    glViewport(0, 0, targetWidth, targetHeight);
+    bool clipping = glIsEnabled(GL_CLIP_DISTANCE0) == GL_TRUE;
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CLIP_DISTANCE0);
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "scene"), 0);
+    glUniform2f(glGetUniformLocation(program, "targetSize"), static_cast<float>(targetWidth), static_cast<float>(targetHeight));
+    glUniform1f(glGetUniformLocation(program, "exposure"), Exposure);
+    glUniform1f(glGetUniformLocation(program, "shoulder"), Shoulder);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, scene);
+    glBindVertexArray(emptyVertexArray);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glEnable(GL_DEPTH_TEST);
+    if (clipping)
+        glEnable(GL_CLIP_DISTANCE0);
+}
@@ -0,0 +1,49 @@
+#ifndef TONE_MAPPER_H
+#define TONE_MAPPER_H
+
+#include "RenderFormats.h"
+
+#include <cstddef>
+
+// The HDR end of the frame: an offscreen scene target in the HDR colour format for the planar main
+// pass, and the full-screen pass that maps any HDR scene texture (this one, or the screen-space
+// reflections' scene) onto the window. The curve leaves everything below Shoulder alone, so
+// LDR content looks as before, and rolls what lies above it smoothly into the last step to 1.
+// ---------------------------------------------------------------------------------------------
+class ToneMapper
+{
+public:
+    float Exposure = 1.0f;
+    float Shoulder = 0.8f;      // where compression starts
+
+    ToneMapper() = default;
+    ~ToneMapper();
+    ToneMapper(const ToneMapper&) = delete;
+    ToneMapper& operator=(const ToneMapper&) = delete;
+
+    // GL thread: scene target at width x height; program is hiz.vs / tonemap.fs. depthRenderbuffer
+    // is used as the depth attachment when given (the reflections' shared one), else one is made.
+    void create(int width, int height, const RenderFormats& formats, unsigned int program, unsigned int depthRenderbuffer = 0);
+
+    // bind and clear the scene target for the main pass
+    void beginScene();
+    // map scene (an HDR texture covering the window) onto framebuffer (0 is the window)
+    void present(unsigned int scene, unsigned int framebuffer, int targetWidth, int targetHeight) const;
+
+    unsigned int colorTexture() const { return color; }
+    size_t targetBytes() const;     // the colour, and the depth unless it is shared
+
+private:
+    void destroy();
+
+    RenderFormats formats;
+    int sceneWidth = 0, sceneHeight = 0;
+    unsigned int framebuffer = 0;
+    unsigned int color = 0;
+    unsigned int depth = 0;
+    bool ownsDepth = false;
+    unsigned int program = 0;
+    unsigned int emptyVertexArray = 0;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+// Lock-free single producer / single consumer handoff of the newest value.
+// The writer fills writeBuffer() and publish()es it, the reader acquire()s the most
+// recently published value; neither side ever waits and stale values are simply skipped.
+// Three slots: one owned by the writer, one by the reader and one parked in between.
+// ---------------------------------------------------------------------------------------
+template <typename T>
+class TripleBuffer
+{
+public:
+    // writer side
+    T& writeBuffer() { return slots[back]; }
+    void publish()
+    {
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // reader side, returns true if a newer value than the last acquired one was published
+    bool acquire()
+    {
+        if (!(middle.load(std::memory_order_acquire) & FRESH))
+            return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+    const T& readBuffer() const { return slots[front]; }
+
+private:
+    static const int INDEX = 3;
+    static const int FRESH = 4;
+
+    T slots[3];
+    std::atomic<int> middle{ 1 };
+    int back = 0;
+    int front = 2;
+};
+
+#endif
@@ -0,0 +1,128 @@
+#include "UniformRing.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+
+void bindUniformBlocks(unsigned int program)
+{
+    unsigned int pass = glGetUniformBlockIndex(program, "PassBlock");
+    if (pass != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, pass, PASS_BLOCK_BINDING);
+    unsigned int draw = glGetUniformBlockIndex(program, "DrawBlock");
+    if (draw != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, draw, DRAW_BLOCK_BINDING);
+    unsigned int terrain = glGetUniformBlockIndex(program, "TerrainBlock");
+    if (terrain != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, terrain, TERRAIN_BLOCK_BINDING);
+    unsigned int ocean = glGetUniformBlockIndex(program, "OceanBlock");
+    if (ocean != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, ocean, OCEAN_BLOCK_BINDING);
+}
+
+UniformRing::UniformRing(size_t bytesPerFrame)
+{
+    GLint offsetAlignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+    align = offsetAlignment > 0 ? static_cast<size_t>(offsetAlignment) : 256;
+    frameSize = (bytesPerFrame + align - 1) / align * align;
+
+    glGenBuffers(1, &id);
+    glBindBuffer(GL_UNIFORM_BUFFER, id);
+    GLsizeiptr size = static_cast<GLsizeiptr>(frameSize * FRAMES);
+    if (GLAD_GL_VERSION_4_4)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_UNIFORM_BUFFER, size, NULL, flags);
+        mapped = static_cast<unsigned char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, size, flags));
+        isPersistent = mapped != nullptr;
+    }
+    else
+        glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+UniformRing::~UniformRing()
+{
+    for (GLsync& fence : fences)
+    {
+        if (fence)
+            glDeleteSync(fence);
+    }
+    if (isPersistent)
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, id);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &id);
+}
+
+void UniformRing::beginFrame()
+{
+    GLsync& fence = fences[frame];
+    if (fence)
+    {
+        // timeout 0 first, so waits are only counted when the GPU really is behind
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        {
+            waits++;
+            double start = glfwGetTime();
+            do
+                status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            while (status == GL_TIMEOUT_EXPIRED);
+            waitSeconds += glfwGetTime() - start;
+        }
+        glDeleteSync(fence);
+        fence = 0;
+    }
+
+    head.store(0, std::memory_order_relaxed);
+    if (!isPersistent)
+    {
+        // the fence already guarantees the GPU is done with this region
+        glBindBuffer(GL_UNIFORM_BUFFER, id);
+        mapped = static_cast<unsigned char*>(glMapBufferRange(GL_UNIFORM_BUFFER, frame * frameSize, frameSize,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+}
+
+void UniformRing::unmap()
+{
+    if (!isPersistent && mapped)
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, id);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        mapped = nullptr;
+    }
+}
+
+void UniformRing::fence()
+{
+    unmap();
+    fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    lastFrameBytes = std::min(head.load(std::memory_order_relaxed), frameSize);
+    frame = (frame + 1) % FRAMES;
+}
+
+size_t UniformRing::allocate(size_t size, void*& data)
+{
+    size_t rounded = (size + align - 1) / align * align;
+    size_t offset = head.fetch_add(rounded, std::memory_order_relaxed);
+    if (offset + rounded > frameSize || !mapped)
+    {
+        overflowCount.fetch_add(1, std::memory_order_relaxed);
+        data = nullptr;
+        return NO_SPACE;
+    }
+    if (isPersistent)
+    {
+        data = mapped + frame * frameSize + offset;
+        return frame * frameSize + offset;
+    }
+    data = mapped + offset;
+    return frame * frameSize + offset;
+}
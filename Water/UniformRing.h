@@ -0,0 +1,115 @@
+#ifndef UNIFORM_RING_H
+#define UNIFORM_RING_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// uniform block binding points shared by every program
+const unsigned int PASS_BLOCK_BINDING = 0;
+const unsigned int DRAW_BLOCK_BINDING = 1;
+const unsigned int TERRAIN_BLOCK_BINDING = 2;
+const unsigned int OCEAN_BLOCK_BINDING = 3;
+
+// instances in one OceanBlock, 4 KB: inside the 16 KB every implementation allows
+const int OCEAN_BLOCK_CHUNKS = 256;
+
+// std140 layouts of the blocks declared in the shaders
+struct PassBlock
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec4 plane;
+    glm::vec4 camera;   // render-space eye, w seconds wrapped to WATER_TIME_PERIOD
+};
+struct DrawBlock
+{
+    glm::mat4 model;
+};
+struct TerrainBlock
+{
+    glm::vec4 area;     // min corner x, z, size, LOD level
+    glm::vec4 tile;     // texture array layer, uv offset, uv scale
+    glm::vec4 morph;    // morph start and end distance
+};
+struct OceanBlock
+{
+    glm::vec4 chunks[OCEAN_BLOCK_CHUNKS];    // per instance: min corner x, z, size, LOD level
+};
+
+// point a program's PassBlock / DrawBlock / TerrainBlock / OceanBlock at the shared binding points
+void bindUniformBlocks(unsigned int program);
+
+// Triple-buffered ring of uniform data. The buffer is mapped once with GL_MAP_PERSISTENT_BIT |
+// GL_MAP_COHERENT_BIT when GL 4.4 is available, otherwise each frame's region is mapped
+// unsynchronized between beginFrame() and unmap(), which has to come before the frame's first draw.
+// Either way fence() after the last draw keeps the CPU from overwriting data the GPU may still read,
+// so the only waits are when the CPU runs FRAMES frames ahead. allocate() may be called from any
+// thread between beginFrame() and unmap().
+// ---------------------------------------------------------------------------------------------
+class UniformRing
+{
+public:
+    static const unsigned int FRAMES = 3;
+    static const size_t NO_SPACE = ~static_cast<size_t>(0);
+
+    explicit UniformRing(size_t bytesPerFrame);
+    ~UniformRing();
+
+    // GL thread: wait for the region about to be reused and open it for writing
+    void beginFrame();
+    // GL thread, once the frame's blocks are written and before any draw reads them: a buffer that
+    // is still mapped must not be drawn from, so without persistent mapping the region is unmapped
+    void unmap();
+    // GL thread, after the frame's draws were issued: fence the region
+    void fence();
+
+    // reserve size bytes aligned for glBindBufferRange, returns the buffer offset or NO_SPACE when
+    // this frame's region is full; data points at the mapped memory to fill
+    size_t allocate(size_t size, void*& data);
+    template <typename T>
+    size_t push(const T& value);
+
+    unsigned int buffer() const { return id; }
+    bool persistent() const { return isPersistent; }
+    size_t alignment() const { return align; }
+    size_t bytesPerFrame() const { return frameSize; }
+
+    // bytes handed out during the last finished frame
+    size_t bytesStreamedLastFrame() const { return lastFrameBytes; }
+    // times beginFrame() found its region still in use by the GPU, and how long it waited in total
+    uint64_t fenceWaits() const { return waits; }
+    double fenceWaitSeconds() const { return waitSeconds; }
+    // allocations that did not fit into their frame's region
+    uint64_t overflows() const { return overflowCount.load(std::memory_order_relaxed); }
+
+private:
+    unsigned int id = 0;
+    unsigned char* mapped = nullptr;    // base of the whole buffer (persistent) or of this frame's region
+    bool isPersistent = false;
+    size_t frameSize;
+    size_t align = 256;
+    unsigned int frame = 0;
+    GLsync fences[FRAMES] = {};
+
+    std::atomic<size_t> head{ 0 };    // bytes used in the current region
+    size_t lastFrameBytes = 0;
+    uint64_t waits = 0;
+    double waitSeconds = 0.0;
+    std::atomic<uint64_t> overflowCount{ 0 };
+};
+
+template <typename T>
+size_t UniformRing::push(const T& value)
+{
+    void* data;
+    size_t offset = allocate(sizeof(T), data);
+    if (offset != NO_SPACE)
+        *static_cast<T*>(data) = value;
+    return offset;
+}
+
+#endif
@@ -10,21 +10,53 @@
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
 
-
+#include "Benchmark.h"
+#include "BenchmarkCompare.h"
+#include "DrawList.h"
+#include "EnvironmentMap.h"
+#include "FrameStats.h"
+#include "FrameStatsHud.h"
+#include "GoldenImages.h"
+#include "WaterNormals.h"
+#include "ShaderVariants.h"
+#include "HeightReadback.h"
+#include "JobSystem.h"
+#include "Ocean.h"
+#include "OverdrawView.h"
+#include "PipelineStatistics.h"
+#include "PlanarReflections.h"
+#include "QualityCalibration.h"
+#include "SceneFile.h"
+#include "SceneLoader.h"
+#include "RenderFormats.h"
+#include "ScreenSpaceReflections.h"
+#include "SimulationThread.h"
+#include "Terrain.h"
+#include "ToneMapper.h"
+#include "UniformRing.h"
+#include "WaterSim.h"
+
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
+float waterSurfaceAt(const WaterSim& sim, const HeightReadback& readback, glm::vec3 position);
+int runScene(GLFWwindow* window);
 unsigned int loadCubemap(vector<std::string> faces);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
-const int waterHeight = 0;
+std::string scenePath = "fountain.scene";
 
-// camera
+// camera: the starting pose, the simulation thread owns the live camera
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
 float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
@@ -34,8 +66,121 @@ bool firstMouse = true;
 float deltaTime = 0.0f;	// time between current frame and last frame
 float lastFrame = 0.0f;
 
-int main()
+// input collected on this thread and handed to the simulation once per frame
+SimInput pendingInput;
+bool splashHeld = false;
+
+// water reflections, R cycles planar, screen space and screen space over quarter-size planar
+ReflectionMode reflectionMode = ReflectionMode::Planar;
+bool reflectionKeyHeld = false;
+// T switches planar targets between full resolution and jittered half resolution with accumulation
+bool temporalReflections = true;
+bool temporalKeyHeld = false;
+// C switches the refraction to shading half its pixels per frame, the rest reconstructed
+bool checkerboardRefraction = false;
+bool checkerboardKeyHeld = false;
+const PlanarReflections* reflectionTargets = nullptr;  // for the cost the toggle reports
+// shader features the water and models are compiled with, see ShaderVariants; B switches the
+// absorption and soft shores, N the scrolling normal and DuDv detail with the Fresnel term
+unsigned int shaderFeatures = 0;
+bool waterDepthKeyHeld = false;
+bool waterDetailKeyHeld = false;
+// frame times since start; H shows them over the scene, P writes them to frame_stats.csv / .json
+FrameStats frameStats;
+bool showFrameStats = false;
+bool frameStatsKeyHeld = false;
+bool exportKeyHeld = false;
+// O swaps the frame for the overdraw heatmap, I prints what each scene pass asked of the GPU
+bool showOverdraw = false;
+bool overdrawKeyHeld = false;
+bool printStatistics = false;
+bool statisticsKeyHeld = false;
+
+// offscreen target formats, --targets ldr|hdr|compact
+RenderFormats targetFormats = RenderFormats::preset("hdr");
+// shader variants and reflection settings, --quality low|medium|high|ultra
+QualityPreset quality = QualityPreset::preset("high");
+// without --quality the preset calibrated for this GPU, measured once the scene has loaded if
+// there is none yet or --calibrate asks again
+bool qualityGiven = false;
+bool recalibrate = false;
+// golden-image test of one render path once the scene has loaded, --golden <configuration>
+const GoldenConfiguration* goldenConfiguration = nullptr;
+bool updateGoldens = false;
+
+int main(int argc, char** argv)
 {
+    // run the headless benchmark instead of the interactive scene: Water --benchmark [report.json]
+    bool benchmark = argc > 1 && std::string(argv[1]) == "--benchmark";
+    std::string benchmarkReport = argc > 2 ? argv[2] : "bench_report.json";
+    // compare two benchmark reports and exit, no window needed: Water --compare baseline.json
+    // candidate.json [--threshold percent] [--history bench_history.tsv] [--keep runs]
+    if (argc > 3 && std::string(argv[1]) == "--compare")
+    {
+        BenchmarkComparison comparison;
+        for (int i = 4; i + 1 < argc; i++)
+        {
+            if (std::string(argv[i]) == "--threshold")
+                comparison.ThresholdPercent = std::atof(argv[i + 1]);
+            if (std::string(argv[i]) == "--history")
+                comparison.HistoryPath = argv[i + 1];
+            if (std::string(argv[i]) == "--keep")
+                comparison.KeepRuns = std::atoi(argv[i + 1]);
+        }
+        return comparison.run(argv[2], argv[3], std::cout);
+    }
+    // golden images: Water --golden-suite [--update-golden] tests every render path, one process
+    // each; Water --golden <configuration> [--update-golden] is one of those processes
+    std::vector<std::string> args(argv, argv + argc);
+    for (const std::string& arg : args)
+    {
+        if (arg == "--update-golden")
+            updateGoldens = true;
+    }
+    if (argc > 1 && args[1] == "--golden-suite")
+    {
+        GoldenImages suite;
+        return suite.runSuite(args[0], updateGoldens, std::cout);
+    }
+    if (argc > 2 && args[1] == "--golden")
+    {
+        goldenConfiguration = GoldenImages::find(args[2]);
+        if (!goldenConfiguration)
+        {
+            std::cout << "ERROR::GOLDEN:: no configuration " << args[2] << std::endl;
+            return 2;
+        }
+        // the render path's options, as if they had been given
+        std::istringstream options(goldenConfiguration->options);
+        std::string option;
+        while (options >> option)
+            args.push_back(option);
+    }
+    // scene to show: Water --scene path.scene; reflections: --reflections planar|ssr|blended;
+    // target formats: --targets ldr|hdr|compact; quality preset: --quality low|medium|high|ultra
+    // or --calibrate
+    for (size_t i = 1; i < args.size(); i++)
+    {
+        if (args[i] == "--calibrate")
+            recalibrate = true;
+        if (i + 1 == args.size())
+            break;
+        if (args[i] == "--scene")
+            scenePath = args[i + 1];
+        if (args[i] == "--targets")
+            targetFormats = RenderFormats::preset(args[i + 1]);
+        if (args[i] == "--quality")
+        {
+            quality = QualityPreset::preset(args[i + 1]);
+            qualityGiven = true;
+        }
+        if (args[i] == "--reflections")
+        {
+            std::string mode = args[i + 1];
+            reflectionMode = mode == "ssr" ? ReflectionMode::ScreenSpace : mode == "blended" ? ReflectionMode::Blended : ReflectionMode::Planar;
+        }
+    }
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -46,6 +191,8 @@ int main()
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+    if (benchmark || goldenConfiguration)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
     // glfw window creation
     // --------------------
@@ -72,20 +219,89 @@ int main()
         return -1;
     }
 
+    if (benchmark)
+    {
+        BenchmarkReport report;
+        benchmarkWaterSim(report);
+        benchmarkHeightReadback(report);
+        benchmarkJobSystem(report);
+        benchmarkCommandList(report);
+        benchmarkUniformRing(report);
+        benchmarkSceneGraph(report);
+        benchmarkTerrain(report);
+        benchmarkOriginRebasing(report);
+        benchmarkOcean(report);
+        benchmarkPlanarReflections(report);
+        benchmarkScreenSpaceReflections(report);
+        benchmarkTemporalReflections(report);
+        benchmarkCheckerboardRefraction(report);
+        benchmarkRenderTargets(report);
+        benchmarkWaterDepth(report);
+        benchmarkWaterDetail(report);
+        benchmarkQualityPresets(report);
+        benchmarkEnvironmentMap(report);
+        benchmarkFrameStats(report);
+        benchmarkPipelineStatistics(report);
+        report.print(std::cout);
+        report.writeJson(benchmarkReport);
+        glfwTerminate();
+        return 0;
+    }
+
+    // scene objects go out of scope inside runScene, while the context is still alive
+    int result = runScene(window);
+
+    // glfw: terminate, clearing all previously allocated GLFW resources.
+    // ------------------------------------------------------------------
+    glfwTerminate();
+    return result;
+}
+
+int runScene(GLFWwindow* window)
+{
     // configure global opengl state
     // -----------------------------
     glEnable(GL_DEPTH_TEST);
+    // the prefiltered sky is sampled at small mips, where face edges would show
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 
     // build and compile our shader program
     // ------------------------------------
-    Shader waterShader("water.vs", "water.fs");
-    Shader poolShader("basic_shader.vs", "basic_shader.fs");
     Shader screenShader("test.vs", "test.fs");
     Shader skyShader("sky.vs", "sky.fs");
-
-    // load models
-    //------------
-    Model poolModel("resources/fountain/horniman-fountain-edit.obj");
+    Shader terrainShader("terrain.vs", "terrain.fs");
+    Shader hiZShader("hiz.vs", "hiz.fs");
+    Shader prefilterShader("prefilter.vs", "prefilter.fs");
+    Shader temporalShader("hiz.vs", "temporal.fs");
+    Shader checkerboardShader("hiz.vs", "checkerboard.fs");
+    Shader toneMapShader("hiz.vs", "tonemap.fs");
+    Shader hudShader("hud.vs", "hud.fs");
+    Shader overdrawShader("hiz.vs", "overdraw.fs");
+
+    // scene description: what to load and where it goes, the assets themselves stream in later
+    // ----------------------------------------------------------------------------------------
+    SceneDescription sceneDescription;
+    if (!loadScene(scenePath, sceneDescription))
+        return -1;
+    float waterHeight = sceneDescription.waterHeight();
+
+    // job system: the draw lists on this thread, the CPU wave step on the simulation thread
+    // -------------------------------------------------------------------------------------
+    JobSystem jobs(std::max(2u, std::thread::hardware_concurrency()) - 1);
+
+    // water simulation
+    // ----------------
+    // heightfield over the water bodies, walls are added as the boundary models arrive
+    WaterSim waterSim(sceneDescription.simResolution, sceneDescription.simOrigin, sceneDescription.simExtent,
+        GLAD_GL_VERSION_4_3 ? WaterSimBackend::GPU : WaterSimBackend::CPU, &jobs);
+    // gameplay reads the GPU heights back a frame or two late instead of stalling on them
+    HeightReadback heightReadback(waterSim.resolution(), waterSim.resolution());
+    uint64_t frameCount = 0;
+
+    // simulation thread: camera, scene transforms and (on the CPU backend) the waves at a fixed tick
+    // ------------------------------------------------------------------------------------------
+    SimulationThread simulation(camera, sceneDescription, waterSim.backend() == WaterSimBackend::CPU ? &waterSim : nullptr, waterSim.FixedTimestep);
+    uint64_t appliedTick = 0;
 
     // set up vertex data (and buffer(s)) and configure vertex attributes
     // ------------------------------------------------------------------
@@ -179,6 +395,9 @@ int main()
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+    // the frame-time overlay draws its bars and digits as instances of this quad
+    FrameStatsHud frameStatsHud;
+    frameStatsHud.create(hudShader.ID, quadVAO);
 
 
     //skybox
@@ -199,87 +418,149 @@ int main()
     // -------------------------------------------------------------------------------------------
 
 
-    // framebuffer configuration
-    // -------------------------
-    //reflection
-    //create frameebuffer
-    unsigned int reflectionFramebuffer;
-    glGenFramebuffers(1, &reflectionFramebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, reflectionFramebuffer);
-    glDrawBuffer(GL_COLOR_ATTACHMENT0);
-
-    //// create a color attachment texture
-    unsigned int reflectionTextureColorbuffer;
-    glGenTextures(1, &reflectionTextureColorbuffer);
-    glBindTexture(GL_TEXTURE_2D, reflectionTextureColorbuffer);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, reflectionTextureColorbuffer, 0);
-    //// create a depth attachment texture
-    unsigned int reflectionTextureDepthbuffer;
-    glGenTextures(1, &reflectionTextureDepthbuffer);
-    glBindTexture(GL_TEXTURE_2D, reflectionTextureDepthbuffer);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, reflectionTextureDepthbuffer, 0);
-    //// create a renderbuffer object for depth and stencil attachment (we won't be sampling these)
-    unsigned int reflectionRBO;
-    glGenRenderbuffers(1, &reflectionRBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, reflectionRBO);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT); // use a single renderbuffer object for both a depth AND stencil buffer.
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, reflectionRBO); // now actually attach it
-    //// now that we actually created the framebuffer and added all attachments we want to check if it is actually complete now
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    ////refraction
-    //create framebuffer
-    unsigned int refractionFramebuffer;
-    glGenFramebuffers(1, &refractionFramebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, refractionFramebuffer);
-    glDrawBuffer(GL_COLOR_ATTACHMENT0);
-
-    //// create a color attachment texture
-    unsigned int refractionTextureColorbuffer;
-    glGenTextures(1, &refractionTextureColorbuffer);
-    glBindTexture(GL_TEXTURE_2D, refractionTextureColorbuffer);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, refractionTextureColorbuffer, 0);
-    //// create a depth attachment texture
-    unsigned int refractionTextureDepthbuffer;
-    glGenTextures(1, &refractionTextureDepthbuffer);
-    glBindTexture(GL_TEXTURE_2D, refractionTextureDepthbuffer);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, refractionTextureDepthbuffer, 0);
-    //// create a renderbuffer object for depth and stencil attachment (we won't be sampling these)
-    unsigned int refractionRBO;
-    glGenRenderbuffers(1, &refractionRBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, reflectionRBO);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT); // use a single renderbuffer object for both a depth AND stencil buffer.
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, reflectionRBO); // now actually attach it
-    //// now that we actually created the framebuffer and added all attachments we want to check if it is actually complete now
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    vector<std::string> faces
+    // reflection and refraction targets, one pair per distinct water plane
+    // -------------------------------------------------------------------
+    PlanarReflections reflections;
+    reflections.Formats = targetFormats;
+    reflections.create(sceneDescription, SCR_WIDTH, SCR_HEIGHT, temporalShader.ID, checkerboardShader.ID);
+    reflectionTargets = &reflections;
+    // the main pass offscreen with its depth pyramid, for the screen-space modes
+    ScreenSpaceReflections screenSpace;
+    screenSpace.create(SCR_WIDTH, SCR_HEIGHT, hiZShader.ID, targetFormats);
+    // HDR formats draw the planar main pass offscreen too, into the refractions' depth, and tone map both
+    ToneMapper toneMapper;
+    if (targetFormats.hdr())
+        toneMapper.create(SCR_WIDTH, SCR_HEIGHT, targetFormats, toneMapShader.ID, reflections.sharedDepth());
+    // fragment counts per pass for the heatmap, and each pass's pipeline counters
+    OverdrawView overdrawView;
+    overdrawView.create(SCR_WIDTH, SCR_HEIGHT, overdrawShader.ID);
+    PipelineStatistics pipelineStatistics;
+    pipelineStatistics.create();
+    std::cout << "Targets: " << targetFormats.name() << ", " << (reflections.stats().targetBytes + screenSpace.targetBytes()
+        + (targetFormats.hdr() ? toneMapper.targetBytes() : 0)) / (1024 * 1024) << " MB" << std::endl;
+
+    // draw lists: culled and recorded on the job system each frame, replayed here in pass order
+    // ---------------------------------------------------------------------------
+    FrameDrawLists drawLists;
+    std::vector<const TerrainSelection*> terrainSelections;
+
+    // per-pass and per-draw uniform blocks, streamed through a persistently mapped ring
+    UniformRing uniformRing(1 << 20);
+    bindUniformBlocks(skyShader.ID);
+    bindUniformBlocks(terrainShader.ID);
+
+    // the water, ocean and model programs come from the variants the features ask for, compiled
+    // the first time they are asked for or read from the program-binary cache
+    ShaderVariants shaderVariants;
+    QualityCalibration calibration;
+    bool calibrateWhenLoaded = false;
+    if (!qualityGiven && (recalibrate || !calibration.load(quality)))
+        calibrateWhenLoaded = true;
+    shaderFeatures = quality.features;
+    temporalReflections = quality.temporal;
+    checkerboardRefraction = quality.checkerboard;
+    unsigned int appliedFeatures = ~0u;
+    GoldenImages golden;
+    std::cout << "Quality: " << quality.name << (calibrateWhenLoaded ? ", calibrating once loaded" : "") << std::endl;
+
+    // everything the recorded commands refer to; only the height texture changes per frame
+    SceneResources resources;
+    resources.skyProgram = ProgramUniforms(skyShader.ID);
+    resources.terrainProgram = ProgramUniforms(terrainShader.ID);
+    resources.models.assign(sceneDescription.models.size(), nullptr);
+    resources.uniforms = &uniformRing;
+    resources.waterVertexArray = waterVAO;
+    resources.skyboxVertexArray = skyboxVAO;
+    resources.sceneColorTexture = screenSpace.colorTexture();
+    resources.hiZTexture = screenSpace.hiZTexture();
+    resources.hiZLevels = screenSpace.hiZLevels();
+    resources.simOrigin = waterSim.origin();
+    resources.simExtent = waterSim.extent();
+    resources.rippleStrength = 4.0f;
+
+    // surface detail the water scrolls across itself, generated once on the job system
+    WaterNormals waterNormals;
+    waterNormals.create(jobs);
+    resources.waterNormalTexture = waterNormals.texture();
+    resources.waterNormalTile = waterNormals.tile();
+    std::cout << "Water: detail generated in " << waterNormals.generationMs() << " ms" << std::endl;
+
+    // open water, nothing to stream: the chunks are paged around the camera every frame
+    Ocean ocean;
+    ocean.configure(sceneDescription.ocean);
+    ocean.createGpuResources();
+    if (ocean.ready())
+        resources.ocean = &ocean;
+
+    // stream the assets in: the first frame goes out right away, models and sky appear as they land
+    // -------------------------------------------------------------------------------------------
+    // both times are measured from glfwInit(), i.e. program start
+    bool firstFrameReported = false, loadedReported = false;
+    std::vector<std::unique_ptr<Model>> models(sceneDescription.models.size());
+    std::vector<std::vector<MeshBuffers>> modelBuffers(sceneDescription.models.size());
+    unsigned int cubemapTexture = 0;
+    EnvironmentMap environment;
+    Terrain terrain;
+    bool terrainLoaded = false;
+    SceneLoader loader(window);
+    for (unsigned int i = 0; i < sceneDescription.models.size(); i++)
     {
-        "resources/skybox/right.jpg",
-        "resources/skybox/left.jpg",
-        "resources/skybox/top.jpg",
-        "resources/skybox/bottom.jpg",
-        "resources/skybox/front.jpg",
-        "resources/skybox/back.jpg"
-    };
-    unsigned int cubemapTexture = loadCubemap(faces);
+        loader.enqueue([&, i]()
+        {
+            models[i].reset(new Model(sceneDescription.models[i].path));
+            detachMeshVertexArrays(models[i]->meshes, modelBuffers[i]);
+        },
+        [&, i]()
+        {
+            attachMeshVertexArrays(models[i]->meshes, modelBuffers[i]);
+            resources.models[i] = &models[i]->meshes;
+            // instances become visible once the simulation thread has placed the bounds in its graph
+            simulation.setModelBounds(i, computeBounds(models[i]->meshes));
+            // the walls of the water simulation
+            for (const SceneInstance& instance : sceneDescription.instances)
+            {
+                if (instance.model != i || !instance.boundary)
+                    continue;
+                if (waterSim.backend() == WaterSimBackend::CPU)
+                    simulation.addBoundary(&models[i]->meshes, glm::mat4(instance.transform()));
+                else
+                    waterSim.buildBoundaryFromMeshes(models[i]->meshes, glm::mat4(instance.transform()), waterHeight);
+            }
+        });
+    }
+    loader.enqueue([&]()
+    {
+        vector<std::string> faces(std::begin(sceneDescription.skybox), std::end(sceneDescription.skybox));
+        cubemapTexture = loadCubemap(faces);
+        // the water's sky, convolved once and cached next to the first face
+        double start = glfwGetTime();
+        environment.create(cubemapTexture, sceneDescription.skybox, prefilterShader.ID, sceneDescription.skybox[0] + ".ggx");
+        std::cout << "Sky: environment " << (environment.fromCache() ? "read from cache" : "prefiltered") << " in "
+            << 1000.0 * (glfwGetTime() - start) << " ms" << std::endl;
+    },
+    [&]()
+    {
+        resources.cubemapTexture = cubemapTexture;
+        resources.environmentTexture = environment.texture();
+        resources.environmentLevels = environment.levels();
+    });
+    if (!sceneDescription.terrain.path.empty())
+    {
+        // decoding and the tile pyramid on the loader, tiles themselves stream in per frame
+        loader.enqueue([&]()
+        {
+            terrainLoaded = terrain.load(sceneDescription.terrain);
+        },
+        [&]()
+        {
+            if (!terrainLoaded)
+                return;
+            terrain.createGpuResources();
+            resources.terrain = &terrain;
+        });
+    }
 
+    simulation.start();
 
     // render loop
     // -----------
@@ -293,175 +574,212 @@ int main()
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
+        // calibrating: this frame renders with the candidate's settings and is never shown
+        bool calibrating = calibration.running();
+        double frameStart = glfwGetTime();
+        if (calibrating)
+        {
+            shaderFeatures = calibration.current().features;
+            temporalReflections = calibration.current().temporal;
+            checkerboardRefraction = calibration.current().checkerboard;
+        }
+        // the frame just shown, from the start of its loop to the start of this one
+        else if (firstFrameReported)
+            frameStats.record(deltaTime);
+
         // input
         // -----
         processInput(window);
+        simulation.submitInput(pendingInput);
+        pendingInput.mouseX = pendingInput.mouseY = pendingInput.scroll = 0.0f;
+        pendingInput.splash = false;
+
+        // newest simulation tick, drawn in between it and the one before
+        // ---------------------------------------------------------------
+        simulation.acquire();
+        const SimSnapshot& snapshot = simulation.snapshot();
+        const SceneState& scene = snapshot.current;
+        // the golden test renders its fixed poses instead
+        CameraState frameCamera = golden.running() ? golden.camera()
+            : CameraState::interpolate(snapshot.previousCamera, snapshot.current.camera, snapshot.interpolation(glfwGetTime()));
+
+        syncWaterSim(waterSim, snapshot, appliedTick);
+        if (waterSim.backend() == WaterSimBackend::GPU)
+        {
+            heightReadback.poll(frameCount);
+            heightReadback.request(waterSim.heightTexture(), frameCount, currentFrame);
+            simulation.setSurfaceHeight(waterSurfaceAt(waterSim, heightReadback, glm::vec3(frameCamera.Position)));
+        }
+        frameCount++;
+
+        // adopt whatever finished streaming
+        loader.update();
+
+        // pick the water planes to re-render, then cull and record every pass on the job system
+        // -------------------------------------------------------------------------------------
+        resources.heightTexture = waterSim.heightTexture();
+        resources.time = golden.running() ? golden.time() : glfwGetTime();
+        // the heatmap records the frame with the variants that count fragments instead
+        bool overdraw = showOverdraw && !calibrating;
+        unsigned int frameFeatures = overdraw ? shaderFeatures | FEATURE_OVERDRAW : shaderFeatures;
+        if (frameFeatures != appliedFeatures)
+        {
+            resources.waterProgram = shaderVariants.get("water.vs", "water.fs", frameFeatures);
+            resources.oceanProgram = shaderVariants.get("ocean.vs", "water.fs", frameFeatures);
+            resources.modelProgram = shaderVariants.get("basic_shader.vs", "basic_shader.fs", frameFeatures & (FEATURE_OBLIQUE_CLIP | FEATURE_OVERDRAW));
+            resources.skyProgram = overdraw ? shaderVariants.get("sky.vs", "sky.fs", FEATURE_OVERDRAW) : ProgramUniforms(skyShader.ID);
+            resources.terrainProgram = overdraw ? shaderVariants.get("terrain.vs", "terrain.fs", FEATURE_OVERDRAW) : ProgramUniforms(terrainShader.ID);
+            appliedFeatures = frameFeatures;
+        }
+        resources.reflectionMode = reflectionMode;
+        reflections.Mode = reflectionMode;
+        reflections.Temporal = temporalReflections;
+        reflections.Checkerboard = checkerboardRefraction;
+        // the water reads the refraction depth for its thickness, so the pass keeps its own
+        reflections.RefractionDepthSampled = (shaderFeatures & FEATURE_SOFT_EDGES) != 0;
+        reflections.ObliqueClip = (shaderFeatures & FEATURE_OBLIQUE_CLIP) != 0;
+        reflections.schedule(drawLists.planeCoverage);
+        // oblique projections clip the plane passes themselves, and that variant writes no clip distance
+        if (reflections.current().obliqueClip)
+            glDisable(GL_CLIP_DISTANCE0);
+        // with accumulation the water samples whichever history this frame's resolve writes
+        resources.planeTextures.clear();
+        for (unsigned int i = 0; i < reflections.planeCount(); i++)
+            resources.planeTextures.push_back({ reflections.reflectionTexture(i), reflections.refractionTexture(i),
+                                                reflections.reflectionDepthTexture(i), reflections.refractionDepthTexture(i) });
+        uniformRing.beginFrame();
+        buildFrameDrawLists(jobs, scene, frameCamera, reflections.current(), (float)SCR_WIDTH / (float)SCR_HEIGHT, drawLists, &resources, resources.terrain, resources.ocean);
+        // every block is written once the recorders are done; close the ring before the first replay
+        uniformRing.unmap();
+        // terrain tiles the passes asked for, uploaded into layers this frame does not sample
+        if (resources.terrain)
+        {
+            frameTerrainSelections(drawLists, terrainSelections);
+            terrain.stream(terrainSelections);
+        }
 
+        pipelineStatistics.beginFrame();
+        overdrawView.beginFrame();
+        for (size_t i = 0; i < drawLists.planeCount; i++)
+        {
+            const PlanePassLists& planeLists = drawLists.planes[i];
+            glm::ivec2 size = reflections.size(planeLists.plane);
+            glViewport(0, 0, size.x, size.y);
+
+            //render reflection texture
+            // ------------------------
+            // bind to framebuffer and draw scene as we normally would to color texture 
+            if (overdraw)
+                overdrawView.begin(ScenePass::Reflection, size.x, size.y);
+            else
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, reflections.reflectionFramebuffer(planeLists.plane));
+                glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            }
+            pipelineStatistics.begin(ScenePass::Reflection, planeLists.reflection.commands, size.x, size.y);
+            planeLists.reflection.commands.replay();
+            pipelineStatistics.end();
+
+            //render refraction texture
+            // ------------------------
+            if (drawLists.refraction)
+            {
+                if (overdraw)
+                    overdrawView.begin(ScenePass::Refraction, size.x, size.y);
+                else
+                {
+                    glBindFramebuffer(GL_FRAMEBUFFER, reflections.refractionFramebuffer(planeLists.plane));
+                    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+                    reflections.prepareRefraction(planeLists.plane);
+                }
+                pipelineStatistics.begin(ScenePass::Refraction, planeLists.refraction.commands, size.x, size.y);
+                planeLists.refraction.commands.replay();
+                pipelineStatistics.end();
+            }
 
-        //render reflection texture
-        // ------------------------
-            //modify camera
-            float distance = 2 * (camera.Position.y - waterHeight);
-            glm::vec3 newPosition = camera.Position;
-            newPosition.y -= distance;
-            float newPitch = -1.0 * camera.Pitch;
-            glm::vec3 newFront;
-            newFront.x = cos(glm::radians(camera.Yaw)) * cos(glm::radians(newPitch));
-            newFront.y = sin(glm::radians(newPitch));
-            newFront.z = sin(glm::radians(camera.Yaw)) * cos(glm::radians(newPitch));
-            newFront = glm::normalize(newFront);
-            glm::vec3 newRight = glm::normalize(glm::cross(newFront, glm::vec3(0,1,0)));
-            glm::vec3 newUp = glm::normalize(glm::cross(newRight, newFront));
-
-        // bind to framebuffer and draw scene as we normally would to color texture 
-        glBindFramebuffer(GL_FRAMEBUFFER, reflectionFramebuffer);
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        poolShader.use();
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::mat4(1.0f);
-        model = glm::scale(model, glm::vec3(2, 2, 2));
-        model = glm::rotate(model, glm::radians(00.0f), glm::vec3(1, 0, 0));
-        model = glm::translate(model, glm::vec3(0, -3.65, 0));
-        glm::mat4 view = glm::lookAt(newPosition, newPosition + newFront, newUp);
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        poolShader.setMat4("view", view);
-        poolShader.setMat4("projection", projection);
-        poolShader.setMat4("model", model);
-        poolShader.setVec4("plane", glm::vec4(0, 1, 0, waterHeight)); //set clip plane
-        poolModel.Draw(poolShader);
-
-        // draw skybox as last
-        glDepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
-        skyShader.use();
-        view = glm::mat4(glm::mat3(glm::lookAt(newPosition, newPosition + newFront, newUp))); // remove translation from the view matrix
-        skyShader.setMat4("view", view);
-        skyShader.setMat4("projection", projection);
-        // skybox cube
-        glBindVertexArray(skyboxVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
-        glDepthFunc(GL_LESS); // set depth function back to default
-
-
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        //render refraction texture
-        // ------------------------
-        glBindFramebuffer(GL_FRAMEBUFFER, refractionFramebuffer);
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        poolShader.use();
-        model = glm::mat4(1.0f);
-        model = glm::scale(model, glm::vec3(2, 2, 2));
-        model = glm::rotate(model, glm::radians(0.0f), glm::vec3(1, 0, 0));
-        model = glm::translate(model, glm::vec3(0, -3.65, 0));
-        view = camera.GetViewMatrix();
-        projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        poolShader.setMat4("view", view);
-        poolShader.setMat4("projection", projection);
-        poolShader.setMat4("model", model);
-        poolShader.setVec4("plane", glm::vec4(0, -1, 0, waterHeight)); //set clip plane
-        poolModel.Draw(poolShader);
-
+            // fill in the checkerboard and fold the jittered renders into the plane's histories
+            if (!overdraw)
+                reflections.resolve(planeLists.plane, planeLists.reflection.pass.stableViewProjection(),
+                    planeLists.refraction.pass.stableViewProjection(), planeLists.reflection.pass.origin);
+        }
 
         // now bind back to default framebuffer
         //-------------------------------------
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        int windowWidth, windowHeight;
+        glfwGetFramebufferSize(window, &windowWidth, &windowHeight);
+        glViewport(0, 0, windowWidth, windowHeight);
 
         // render main scene
         // -----------------
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        //render pool
-        poolShader.use();
-        model = glm::mat4(1.0f);
-        model = glm::scale(model, glm::vec3(2, 2, 2));
-        model = glm::rotate(model, glm::radians(0.0f), glm::vec3(1, 0, 0));
-        model = glm::translate(model, glm::vec3(0, -3.65, 0));
-        view = camera.GetViewMatrix();
-        projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        poolShader.setMat4("view", view);
-        poolShader.setMat4("projection", projection);
-        poolShader.setMat4("model", model);
-        poolShader.setVec4("plane", glm::vec4(0, 0, 0, 0)); //set clip plane
-        poolModel.Draw(poolShader);
-        //render water
-        waterShader.use();
-        view = camera.GetViewMatrix();
-        projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        waterShader.setMat4("view", view);
-        waterShader.setMat4("projection", projection);
-        glBindVertexArray(waterVAO);
-
-        // bind textures on corresponding texture units
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, reflectionTextureColorbuffer);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, refractionTextureColorbuffer);
-
-        glUniform1i(glGetUniformLocation(waterShader.ID, "reflectionTexture"), 0); // Texture unit 0
-        glUniform1i(glGetUniformLocation(waterShader.ID, "refractionTexture"), 1); // Texture unit 1
-
-        for (int i = 0; i < 5; i++) {
-            for (int j = 0; j < 5; j++) {
-                model = glm::mat4(1.0f);
-                model = glm::translate(model, glm::vec3(i - 2, waterHeight, j - 2));
-                model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1, 0, 0));
-                waterShader.setMat4("model", model);
-                glDrawArrays(GL_TRIANGLES, 0, 6);
+        if (overdraw)
+        {
+            // the screen-space water counted over the scene like everything else
+            overdrawView.begin(ScenePass::Main, SCR_WIDTH, SCR_HEIGHT);
+            pipelineStatistics.begin(ScenePass::Main, drawLists.main.commands, SCR_WIDTH, SCR_HEIGHT);
+            drawLists.main.commands.replay();
+            if (reflectionMode != ReflectionMode::Planar)
+            {
+                pipelineStatistics.submitted(ScenePass::Main, drawLists.main.waterCommands);
+                drawLists.main.waterCommands.replay();
+            }
+            pipelineStatistics.end();
+            overdrawView.present(0, windowWidth, windowHeight);
+        }
+        else if (reflectionMode == ReflectionMode::Planar && targetFormats.hdr())
+        {
+            toneMapper.beginScene();
+            pipelineStatistics.begin(ScenePass::Main, drawLists.main.commands, SCR_WIDTH, SCR_HEIGHT);
+            drawLists.main.commands.replay();
+            pipelineStatistics.end();
+            toneMapper.present(toneMapper.colorTexture(), 0, windowWidth, windowHeight);
+        }
+        else if (reflectionMode == ReflectionMode::Planar)
+        {
+            glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            pipelineStatistics.begin(ScenePass::Main, drawLists.main.commands, windowWidth, windowHeight);
+            drawLists.main.commands.replay();
+            pipelineStatistics.end();
+        }
+        else
+        {
+            // opaque scene offscreen, then the water tracing its rays through it; the depth
+            // pyramid between them is left out of the main pass's counters
+            screenSpace.beginScene();
+            pipelineStatistics.begin(ScenePass::Main, drawLists.main.commands, SCR_WIDTH, SCR_HEIGHT);
+            drawLists.main.commands.replay();
+            pipelineStatistics.end();
+            screenSpace.buildHiZ();
+            pipelineStatistics.begin(ScenePass::Main, drawLists.main.waterCommands, 0, 0);
+            drawLists.main.waterCommands.replay();
+            pipelineStatistics.end();
+            if (targetFormats.hdr())
+                toneMapper.present(screenSpace.sceneTexture(), 0, windowWidth, windowHeight);
+            else
+                screenSpace.present(0, windowWidth, windowHeight);
+        }
+        if (showFrameStats && !calibrating)
+            frameStatsHud.draw(frameStats, windowWidth, windowHeight);
+        if (printStatistics)
+        {
+            std::cout << "Pipeline statistics" << (pipelineStatistics.hardware() ? "" : " (submitted only, no ARB_pipeline_statistics_query)") << ":" << std::endl;
+            for (int i = 0; i < SCENE_PASS_COUNT; i++)
+            {
+                const PassStatistics& pass = pipelineStatistics.pass(static_cast<ScenePass>(i));
+                std::cout << "  " << PipelineStatistics::PASS_NAMES[i] << ": " << pass.draws << " draws, " << pass.triangles
+                    << " triangles, " << pass.indices << " indices";
+                if (pipelineStatistics.hardware())
+                    std::cout << "; " << pass.primitives << " primitives, " << pass.clippedPrimitives << " after clipping, "
+                        << pass.vertexInvocations << " vertex and " << pass.fragmentInvocations << " fragment invocations, "
+                        << pass.overdraw() << " fragments per pixel";
+                std::cout << std::endl;
             }
+            printStatistics = false;
         }
-        //fill
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, glm::vec3(0, waterHeight, 2.75));
-            model = glm::scale(model, glm::vec3(3, 1.0, 0.5));
-            model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1, 0, 0));
-            waterShader.setMat4("model", model);
-            glDrawArrays(GL_TRIANGLES, 0, 6);
-
-
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, glm::vec3(0, waterHeight, -3 + .1));
-            model = glm::scale(model, glm::vec3(4.2, 1.0, .8));
-            model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1, 0, 0));
-            waterShader.setMat4("model", model);
-            glDrawArrays(GL_TRIANGLES, 0, 6);
-
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, glm::vec3(3 - .15, waterHeight, -0.15f));
-            model = glm::scale(model, glm::vec3(0.7, 1.0, 4.0));
-            model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1, 0, 0));
-            waterShader.setMat4("model", model);
-            glDrawArrays(GL_TRIANGLES, 0, 6);
-
-
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, glm::vec3(-3 + .1f, waterHeight, -0.2f));
-            model = glm::scale(model, glm::vec3(0.8f, 1.0, 3.7));
-            model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1, 0, 0));
-            waterShader.setMat4("model", model);
-            glDrawArrays(GL_TRIANGLES, 0, 6);
-
-
-        glBindVertexArray(0);
-
-
-        // draw skybox as last
-        glDepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
-        skyShader.use();
-        view = glm::mat4(glm::mat3(camera.GetViewMatrix())); // remove translation from the view matrix
-        skyShader.setMat4("view", view);
-        skyShader.setMat4("projection", projection);
-        // skybox cube
-        glBindVertexArray(skyboxVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
-        glDepthFunc(GL_LESS); // set depth function back to default
+        uniformRing.fence();
 
 
         //screenShader.use();
@@ -472,36 +790,168 @@ int main()
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
-        glfwSwapBuffers(window);
+        if (golden.running())
+        {
+            golden.frameDone(windowWidth, windowHeight);
+            if (!golden.running())
+                glfwSetWindowShouldClose(window, true);
+        }
+        else if (calibrating)
+        {
+            // the whole frame, CPU and GPU, is what has to fit the budget
+            glFinish();
+            calibration.frameDone(1000.0 * (glfwGetTime() - frameStart));
+            if (!calibration.running())
+            {
+                quality = calibration.result();
+                shaderFeatures = quality.features;
+                temporalReflections = quality.temporal;
+                checkerboardRefraction = quality.checkerboard;
+                calibration.save();
+                std::cout << "Quality: calibrated to " << quality.name << ", predicted";
+                for (int i = 0; i < QualityPreset::COUNT; i++)
+                    std::cout << " " << QualityPreset::NAMES[i] << " " << calibration.predictedMs()[i] << " ms";
+                std::cout << " (budget " << calibration.BudgetMs << " ms, worst residual " << calibration.worstResidualMs() << " ms)" << std::endl;
+            }
+        }
+        else
+            glfwSwapBuffers(window);
         glfwPollEvents();
+
+        if (!firstFrameReported)
+        {
+            std::cout << "Scene: first frame after " << 1000.0 * glfwGetTime() << " ms" << std::endl;
+            firstFrameReported = true;
+        }
+        if (!loadedReported && loader.idle())
+        {
+            std::cout << "Scene: fully loaded after " << 1000.0 * glfwGetTime() << " ms" << std::endl;
+            loadedReported = true;
+            // the scene as it will be drawn, every model and the sky in
+            if (calibrateWhenLoaded)
+            {
+                int windowWidth, windowHeight;
+                glfwGetFramebufferSize(window, &windowWidth, &windowHeight);
+                calibration.begin(windowWidth * windowHeight);
+            }
+            if (goldenConfiguration)
+                golden.begin(*goldenConfiguration, updateGoldens);
+        }
     }
 
+    simulation.stop();
+
     // optional: de-allocate all resources once they've outlived their purpose:
     // ------------------------------------------------------------------------
     glDeleteVertexArrays(1, &waterVAO);
     glDeleteBuffers(1, &squareVBO);
-
-    // glfw: terminate, clearing all previously allocated GLFW resources.
-    // ------------------------------------------------------------------
-    glfwTerminate();
-    return 0;
+    // the golden test's verdict, 0 for the interactive scene
+    return golden.result();
 }
 
-// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
-// ---------------------------------------------------------------------------------------------------------
+// process all input: query GLFW whether relevant keys are pressed/released this frame and hand them to the simulation
+// ---------------------------------------------------------------------------------------------------------------
 void processInput(GLFWwindow* window)
 {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-        camera.ProcessKeyboard(FORWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-        camera.ProcessKeyboard(BACKWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-        camera.ProcessKeyboard(LEFT, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-        camera.ProcessKeyboard(RIGHT, deltaTime);
+    pendingInput.forward = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
+    pendingInput.backward = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
+    pendingInput.left = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
+    pendingInput.right = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
+
+    // splash on the frame the left button goes down
+    bool pressed = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+    if (pressed && !splashHeld)
+        pendingInput.splash = true;
+    splashHeld = pressed;
+
+    // reflection mode, handled on this thread since it only changes how the frame is drawn
+    bool cycle = glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS;
+    if (cycle && !reflectionKeyHeld)
+    {
+        const char* names[] = { "planar", "screen space", "screen space over planar" };
+        reflectionMode = static_cast<ReflectionMode>((static_cast<int>(reflectionMode) + 1) % 3);
+        std::cout << "Reflections: " << names[static_cast<int>(reflectionMode)] << std::endl;
+    }
+    reflectionKeyHeld = cycle;
+
+    bool toggle = glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS;
+    if (toggle && !temporalKeyHeld)
+    {
+        temporalReflections = !temporalReflections;
+        std::cout << "Temporal reflections: " << (temporalReflections ? "on" : "off") << std::endl;
+    }
+    temporalKeyHeld = toggle;
+
+    bool checker = glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS;
+    if (checker && !checkerboardKeyHeld)
+    {
+        // the cost of the mode being left, measured a few frames behind
+        if (checkerboardRefraction && reflectionTargets)
+            std::cout << "Checkerboard refraction: reconstruction took " << reflectionTargets->stats().reconstructMs << " ms" << std::endl;
+        checkerboardRefraction = !checkerboardRefraction;
+        std::cout << "Checkerboard refraction: " << (checkerboardRefraction ? "on" : "off") << std::endl;
+    }
+    checkerboardKeyHeld = checker;
+
+    bool depth = glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS;
+    if (depth && !waterDepthKeyHeld)
+    {
+        // not with the oblique clip of the low and medium presets, the depth would be misread
+        shaderFeatures = compatibleFeatures(shaderFeatures ^ FEATURE_SOFT_EDGES);
+        std::cout << "Water depth: " << ((shaderFeatures & FEATURE_SOFT_EDGES) ? "absorption and soft shores"
+            : (shaderFeatures & FEATURE_OBLIQUE_CLIP) ? "off, the preset clips obliquely" : "off") << std::endl;
+    }
+    waterDepthKeyHeld = depth;
+
+    bool detail = glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS;
+    if (detail && !waterDetailKeyHeld)
+    {
+        // both on or both off, whatever the preset had
+        shaderFeatures = (shaderFeatures & FEATURE_NORMAL_MAP) ? shaderFeatures & ~(FEATURE_NORMAL_MAP | FEATURE_FRESNEL)
+                                                               : shaderFeatures | FEATURE_NORMAL_MAP | FEATURE_FRESNEL;
+        std::cout << "Water detail: " << ((shaderFeatures & FEATURE_NORMAL_MAP) ? "normals, DuDv and Fresnel" : "off") << std::endl;
+    }
+    waterDetailKeyHeld = detail;
+
+    bool hud = glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS;
+    if (hud && !frameStatsKeyHeld)
+        showFrameStats = !showFrameStats;
+    frameStatsKeyHeld = hud;
+
+    bool write = glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS;
+    if (write && !exportKeyHeld && frameStats.writeCsv("frame_stats.csv") && frameStats.writeJson("frame_stats.json"))
+    {
+        FrameStats::Summary summary = frameStats.total();
+        std::cout << "Frame stats: " << summary.frames << " frames, p50 " << summary.p50Ms << " ms, p99 " << summary.p99Ms
+            << " ms, " << summary.stutters << " stutters, written to frame_stats.csv and frame_stats.json" << std::endl;
+    }
+    exportKeyHeld = write;
+
+    bool heatmap = glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS;
+    if (heatmap && !overdrawKeyHeld)
+    {
+        showOverdraw = !showOverdraw;
+        std::cout << "Overdraw heatmap: " << (showOverdraw ? "on (main pass, reflection and refraction insets)" : "off") << std::endl;
+    }
+    overdrawKeyHeld = heatmap;
+
+    bool statistics = glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS;
+    if (statistics && !statisticsKeyHeld)
+        printStatistics = true;
+    statisticsKeyHeld = statistics;
+}
+
+// height of the GPU-simulated surface under a point, extrapolated over the readback latency
+// -----------------------------------------------------------------------------------------
+float waterSurfaceAt(const WaterSim& sim, const HeightReadback& readback, glm::vec3 position)
+{
+    if (!readback.valid())
+        return 0.0f;
+    glm::vec2 xz(position.x, position.z);
+    return readback.predict((xz - sim.origin()) / sim.extent(), glfwGetTime());
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
@@ -534,14 +984,15 @@ void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
     lastX = xpos;
     lastY = ypos;
 
-    camera.ProcessMouseMovement(xoffset, yoffset);
+    pendingInput.mouseX += xoffset;
+    pendingInput.mouseY += yoffset;
 }
 
 // glfw: whenever the mouse scroll wheel scrolls, this callback is called
 // ----------------------------------------------------------------------
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
-    camera.ProcessMouseScroll(static_cast<float>(yoffset));
+    pendingInput.scroll += static_cast<float>(yoffset);
 }
 
 unsigned int loadCubemap(vector<std::string> faces)
@@ -0,0 +1,113 @@
+#include "WaterNormals.h"
+#include "JobSystem.h"
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+WaterNormals::~WaterNormals()
+{
+    if (array)
+        glDeleteTextures(1, &array);
+}
+
+size_t WaterNormals::byteSize() const
+{
+    // two bytes a texel, a third more for the mips
+    return static_cast<size_t>(SIZE) * SIZE * 2 * LAYERS * 4 / 3;
+}
+
+// one wave of a layer: whole cycles across the tile along x and z, so the sum tiles seamlessly
+struct DetailWave
+{
+    int x, z;
+    float amplitude;
+    int phase;      // in table steps
+};
+
+static std::vector<DetailWave> detailWaves(int layer)
+{
+    // a fixed seed per layer, the same surface every run; amplitude falls off with frequency the way
+    // a wind sea's does, so no one wave stands out. The engine's own output is the same on every
+    // standard library where the distributions' is not, and the goldens depend on this surface
+    std::mt19937 random(0x5eed + layer);
+    std::vector<DetailWave> waves;
+    while (waves.size() < static_cast<size_t>(WaterNormals::WAVES))
+    {
+        int x = static_cast<int>(random() % 49) - 24, z = static_cast<int>(random() % 49) - 24;
+        float length = std::sqrt(static_cast<float>(x * x + z * z));
+        if (length < 2.0f || length > 24.0f)
+            continue;
+        int phase = static_cast<int>(random() % WaterNormals::SIZE);
+        waves.push_back({ x, z, 1.0f / (length * length), phase });
+    }
+    return waves;
+}
+
+void WaterNormals::create(JobSystem& jobs)
+{
+    double start = glfwGetTime();
+
+    // whole cycles across SIZE texels land the phase on a table entry, exact and periodic
+    const float TAU = 6.28318530718f;
+    std::vector<float> cosine(SIZE);
+    for (int i = 0; i < SIZE; i++)
+        cosine[i] = std::cos(TAU * i / SIZE);
+
+    std::vector<int8_t> texels(static_cast<size_t>(SIZE) * SIZE * 2 * LAYERS);
+    std::vector<float> slopes(static_cast<size_t>(SIZE) * SIZE * 2);
+    for (int layer = 0; layer < LAYERS; layer++)
+    {
+        // d/du of a sin(tau (x u + z v) + phase), per tile
+        const std::vector<DetailWave> waves = detailWaves(layer);
+        jobs.parallelFor(SIZE, 8, [&](size_t begin, size_t end)
+        {
+            for (size_t v = begin; v < end; v++)
+            {
+                for (int u = 0; u < SIZE; u++)
+                {
+                    float dx = 0.0f, dz = 0.0f;
+                    for (const DetailWave& wave : waves)
+                    {
+                        int step = ((wave.x * u + wave.z * static_cast<int>(v) + wave.phase) % SIZE + SIZE) % SIZE;
+                        float slope = wave.amplitude * TAU * cosine[step];
+                        dx += slope * wave.x;
+                        dz += slope * wave.z;
+                    }
+                    slopes[(v * SIZE + u) * 2] = dx;
+                    slopes[(v * SIZE + u) * 2 + 1] = dz;
+                }
+            }
+        });
+
+        // the steepest slope maps to full scale; water.fs scales it back to taste
+        float steepest = 1e-6f;
+        for (float slope : slopes)
+            steepest = std::max(steepest, std::abs(slope));
+        int8_t* layerTexels = &texels[static_cast<size_t>(layer) * SIZE * SIZE * 2];
+        for (size_t i = 0; i < slopes.size(); i++)
+            layerTexels[i] = static_cast<int8_t>(std::lround(slopes[i] / steepest * 127.0f));
+    }
+
+    if (array)
+        glDeleteTextures(1, &array);
+    glGenTextures(1, &array);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RG8_SNORM, SIZE, SIZE, LAYERS, 0, GL_RG, GL_BYTE, texels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    // averaged down the mips the slopes flatten, distant water calms instead of shimmering
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    generateMs = 1000.0 * (glfwGetTime() - start);
+}
@@ -0,0 +1,41 @@
+#ifndef WATER_NORMALS_H
+#define WATER_NORMALS_H
+
+#include <cstddef>
+
+class JobSystem;
+
+// Two layers of tiling surface detail that water.fs scrolls across the water, in one RG8_SNORM
+// texture array with a full mip chain. A texel holds the slope of a small-wave heightfield along x
+// and z: bent lookups use it as their DuDv offset and shading as the normal (-dx, 1, -dz), so each
+// layer is one fetch. The heightfields are sums of random waves with whole periods across the
+// tile, generated on the job system at startup; layer 1 repeats four times within layer 0.
+// ------------------------------------------------------------------------------------------------
+class WaterNormals
+{
+public:
+    static const int SIZE = 256;        // texels across a layer
+    static const int LAYERS = 2;
+    static const int WAVES = 48;        // per layer
+
+    float Tile = 8.0f;                  // metres layer 0 repeats over
+
+    WaterNormals() = default;
+    ~WaterNormals();
+    WaterNormals(const WaterNormals&) = delete;
+    WaterNormals& operator=(const WaterNormals&) = delete;
+
+    // GL thread: generate the layers with jobs and upload them
+    void create(JobSystem& jobs);
+
+    unsigned int texture() const { return array; }
+    float tile() const { return Tile; }
+    size_t byteSize() const;
+    double generationMs() const { return generateMs; }
+
+private:
+    unsigned int array = 0;
+    double generateMs = 0.0;
+};
+
+#endif
@@ -0,0 +1,409 @@
+#include "WaterSim.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// simulation
+// ----------
+WaterSim::WaterSim(int resolution, glm::vec2 origin, float extent, WaterSimBackend backend, JobSystem* jobs)
+    : simBackend(backend), size(resolution), gridOrigin(origin), gridExtent(extent), jobs(jobs)
+{
+    cells[0].assign(size * size, 0.0f);
+    cells[1].assign(size * size, 0.0f);
+    boundary.assign(size * size, 0);
+
+    if (simBackend == WaterSimBackend::GPU)
+    {
+        if (GLAD_GL_VERSION_4_3)
+            computeProgram = loadComputeProgram("water_sim.cs");
+        if (!computeProgram)
+        {
+            std::cout << "WATER_SIM:: compute shaders unavailable, falling back to the CPU solver" << std::endl;
+            simBackend = WaterSimBackend::CPU;
+        }
+    }
+
+    heightTex[0] = createFieldTexture(GL_R32F, GL_RED, GL_FLOAT, cells[0].data());
+    if (simBackend == WaterSimBackend::GPU)
+        heightTex[1] = createFieldTexture(GL_R32F, GL_RED, GL_FLOAT, cells[1].data());
+    boundaryTex = createFieldTexture(GL_R8, GL_RED, GL_UNSIGNED_BYTE, boundary.data());
+}
+
+WaterSim::~WaterSim()
+{
+    glDeleteTextures(2, heightTex);
+    glDeleteTextures(1, &boundaryTex);
+    if (computeProgram)
+        glDeleteProgram(computeProgram);
+}
+
+unsigned int WaterSim::threadCount() const
+{
+    return jobs ? jobs->threadCount() : 1;
+}
+
+unsigned int WaterSim::heightTexture() const
+{
+    return simBackend == WaterSimBackend::CPU ? heightTex[0] : heightTex[current];
+}
+
+unsigned int WaterSim::createFieldTexture(GLenum internalFormat, GLenum format, GLenum type, const void* data)
+{
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, size, size, 0, format, type, data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+void WaterSim::reset()
+{
+    std::fill(cells[0].begin(), cells[0].end(), 0.0f);
+    std::fill(cells[1].begin(), cells[1].end(), 0.0f);
+    disturbances.clear();
+    accumulator = 0.0f;
+    current = 0;
+    glBindTexture(GL_TEXTURE_2D, heightTex[0]);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, GL_RED, GL_FLOAT, cells[0].data());
+    if (heightTex[1])
+    {
+        glBindTexture(GL_TEXTURE_2D, heightTex[1]);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, GL_RED, GL_FLOAT, cells[1].data());
+    }
+}
+
+float WaterSim::heightAt(glm::vec2 worldPosition) const
+{
+    glm::vec2 p = (worldPosition - gridOrigin) * (size / gridExtent) - glm::vec2(0.5f);
+    p = glm::clamp(p, 0.0f, size - 1.0f);
+    int x0 = static_cast<int>(p.x), y0 = static_cast<int>(p.y);
+    int x1 = std::min(x0 + 1, size - 1), y1 = std::min(y0 + 1, size - 1);
+    float tx = p.x - x0, ty = p.y - y0;
+    const std::vector<float>& h = cells[current];
+    float top = h[y0 * size + x0] * (1.0f - tx) + h[y0 * size + x1] * tx;
+    float bottom = h[y1 * size + x0] * (1.0f - tx) + h[y1 * size + x1] * tx;
+    return top * (1.0f - ty) + bottom * ty;
+}
+
+// boundaries
+// ----------
+void WaterSim::clearBoundary()
+{
+    std::fill(boundary.begin(), boundary.end(), 0);
+    boundaryDirty = true;
+}
+
+void WaterSim::rasterizeTriangle(glm::vec2 a, glm::vec2 b, glm::vec2 c)
+{
+    // conservative: a cell is a wall if its centre lies within half a cell of the triangle
+    int minX = std::max(0, static_cast<int>(std::floor(std::min({ a.x, b.x, c.x }) - 0.5f)));
+    int maxX = std::min(size - 1, static_cast<int>(std::ceil(std::max({ a.x, b.x, c.x }) + 0.5f)));
+    int minY = std::max(0, static_cast<int>(std::floor(std::min({ a.y, b.y, c.y }) - 0.5f)));
+    int maxY = std::min(size - 1, static_cast<int>(std::ceil(std::max({ a.y, b.y, c.y }) + 0.5f)));
+
+    auto edge = [](glm::vec2 p, glm::vec2 q, glm::vec2 r) { return (q.x - p.x) * (r.y - p.y) - (q.y - p.y) * (r.x - p.x); };
+    float area = edge(a, b, c);
+    for (int y = minY; y <= maxY; y++)
+    {
+        for (int x = minX; x <= maxX; x++)
+        {
+            glm::vec2 p(x + 0.5f, y + 0.5f);
+            bool inside = false;
+            if (std::abs(area) > 1e-6f)
+            {
+                float w0 = edge(b, c, p) / area, w1 = edge(c, a, p) / area, w2 = edge(a, b, p) / area;
+                inside = w0 >= -0.01f && w1 >= -0.01f && w2 >= -0.01f;
+            }
+            if (!inside)
+            {
+                // distance to each edge covers slivers and degenerate (vertical) triangles
+                glm::vec2 verts[3] = { a, b, c };
+                for (int e = 0; e < 3 && !inside; e++)
+                {
+                    glm::vec2 p0 = verts[e], p1 = verts[(e + 1) % 3];
+                    glm::vec2 d = p1 - p0;
+                    float t = glm::dot(d, d) > 0.0f ? glm::clamp(glm::dot(p - p0, d) / glm::dot(d, d), 0.0f, 1.0f) : 0.0f;
+                    inside = glm::length(p - (p0 + d * t)) <= 0.71f;
+                }
+            }
+            if (inside)
+                boundary[y * size + x] = 1;
+        }
+    }
+}
+
+void WaterSim::buildBoundaryFromMeshes(const std::vector<Mesh>& meshes, const glm::mat4& model, float waterHeight, float margin)
+{
+    float toCells = size / gridExtent;
+    auto cellOf = [&](const glm::vec3& p) { return (glm::vec2(p.x, p.z) - gridOrigin) * toCells; };
+
+    for (const Mesh& mesh : meshes)
+    {
+        std::vector<glm::vec3> world(mesh.vertices.size());
+        for (size_t i = 0; i < mesh.vertices.size(); i++)
+            world[i] = glm::vec3(model * glm::vec4(mesh.vertices[i].Position, 1.0f));
+
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+        {
+            const glm::vec3& a = world[mesh.indices[i]];
+            const glm::vec3& b = world[mesh.indices[i + 1]];
+            const glm::vec3& c = world[mesh.indices[i + 2]];
+            float lo = std::min({ a.y, b.y, c.y });
+            float hi = std::max({ a.y, b.y, c.y });
+            // only geometry that crosses (or lies on) the water plane blocks waves
+            if (lo - margin > waterHeight || hi + margin < waterHeight)
+                continue;
+            rasterizeTriangle(cellOf(a), cellOf(b), cellOf(c));
+        }
+    }
+    boundaryDirty = true;
+}
+
+void WaterSim::applyBoundary()
+{
+    // only the compute shader reads the boundary texture
+    if (simBackend == WaterSimBackend::GPU)
+    {
+        glBindTexture(GL_TEXTURE_2D, boundaryTex);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, GL_RED, GL_UNSIGNED_BYTE, boundary.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+    for (int i = 0; i < size * size; i++)
+    {
+        if (boundary[i])
+            cells[0][i] = cells[1][i] = 0.0f;
+    }
+    boundaryDirty = false;
+}
+
+// disturbances
+// ------------
+void WaterSim::addDisturbance(glm::vec2 worldPosition, float radius, float strength)
+{
+    if (disturbances.size() < MAX_DISTURBANCES)
+        disturbances.push_back({ worldPosition, radius, strength });
+}
+
+void WaterSim::applyDisturbancesCPU()
+{
+    float cellsPerUnit = size / gridExtent;
+    std::vector<float>& h = cells[current];
+    for (const WaterDisturbance& d : disturbances)
+    {
+        glm::vec2 centre = (d.position - gridOrigin) * cellsPerUnit;
+        float radius = std::max(d.radius * cellsPerUnit, 1.0f);
+        int x0 = std::max(0, static_cast<int>(centre.x - radius)), x1 = std::min(size - 1, static_cast<int>(centre.x + radius));
+        int y0 = std::max(0, static_cast<int>(centre.y - radius)), y1 = std::min(size - 1, static_cast<int>(centre.y + radius));
+        for (int y = y0; y <= y1; y++)
+        {
+            for (int x = x0; x <= x1; x++)
+            {
+                float r2 = ((x + 0.5f - centre.x) * (x + 0.5f - centre.x) + (y + 0.5f - centre.y) * (y + 0.5f - centre.y)) / (radius * radius);
+                if (r2 < 1.0f && !boundary[y * size + x])
+                    h[y * size + x] += d.strength * (1.0f - r2) * (1.0f - r2);
+            }
+        }
+    }
+}
+
+// stepping
+// --------
+int WaterSim::update(float deltaTime)
+{
+    // clamp long frames (window drags, breakpoints) so we never try to catch up seconds of simulation
+    accumulator += std::min(deltaTime, 0.25f);
+    int steps = 0;
+    while (accumulator >= FixedTimestep && steps < MaxStepsPerUpdate)
+    {
+        step();
+        accumulator -= FixedTimestep;
+        steps++;
+    }
+    if (steps == MaxStepsPerUpdate)
+        accumulator = std::fmod(accumulator, FixedTimestep);
+    if (steps > 0 && simBackend == WaterSimBackend::CPU)
+        uploadHeights(cells[current]);
+    return steps;
+}
+
+void WaterSim::step()
+{
+    if (boundaryDirty)
+        applyBoundary();
+    if (simBackend == WaterSimBackend::CPU)
+        stepCPU();
+    else
+        stepGPU();
+    disturbances.clear();
+}
+
+void WaterSim::stepCPU()
+{
+    applyDisturbancesCPU();
+
+    const int n = size;
+    const float dx = gridExtent / n;
+    // squared Courant number, kept below the 2D stability limit of 0.5
+    const float k = std::min(WaveSpeed * WaveSpeed * FixedTimestep * FixedTimestep / (dx * dx), 0.49f);
+    const float damping = Damping;
+    const float* cur = cells[current].data();
+    float* out = cells[1 - current].data();    // holds t - dt on entry, t + dt on exit
+    const unsigned char* wall = boundary.data();
+
+    const int tilesX = (n + TILE_SIZE - 1) / TILE_SIZE;
+    const int tileCount = tilesX * tilesX;
+
+    auto runTiles = [&](size_t begin, size_t end)
+    {
+        for (int tile = static_cast<int>(begin); tile < static_cast<int>(end); tile++)
+        {
+            int tx = (tile % tilesX) * TILE_SIZE, ty = (tile / tilesX) * TILE_SIZE;
+            int xEnd = std::min(tx + TILE_SIZE, n), yEnd = std::min(ty + TILE_SIZE, n);
+            for (int y = ty; y < yEnd; y++)
+            {
+                const float* c = cur + y * n;
+                const float* up = y > 0 ? c - n : nullptr;
+                const float* down = y < n - 1 ? c + n : nullptr;
+                float* o = out + y * n;
+                const unsigned char* w = wall + y * n;
+
+                auto cell = [&](int x)
+                {
+                    float l = x > 0 ? c[x - 1] : 0.0f;
+                    float r = x < n - 1 ? c[x + 1] : 0.0f;
+                    float u = up ? up[x] : 0.0f;
+                    float d = down ? down[x] : 0.0f;
+                    float v = (2.0f * c[x] - o[x] + k * (l + r + u + d - 4.0f * c[x])) * damping;
+                    o[x] = w[x] ? 0.0f : v;
+                };
+
+                if (!up || !down)
+                {
+                    for (int x = tx; x < xEnd; x++)
+                        cell(x);
+                    continue;
+                }
+                int x = tx;
+                if (x == 0)
+                    cell(x++);
+                int interiorEnd = std::min(xEnd, n - 1);
+                // branch-free interior so the compiler can vectorize the row
+                for (; x < interiorEnd; x++)
+                {
+                    float v = (2.0f * c[x] - o[x] + k * (c[x - 1] + c[x + 1] + up[x] + down[x] - 4.0f * c[x])) * damping;
+                    o[x] = w[x] ? 0.0f : v;
+                }
+                for (; x < xEnd; x++)
+                    cell(x);
+            }
+        }
+    };
+
+    // small grids finish faster than the workers can pick them up
+    if (!jobs || tileCount < 2 * static_cast<int>(jobs->threadCount()))
+        runTiles(0, tileCount);
+    else
+        jobs->parallelFor(tileCount, 1, runTiles);
+
+    current = 1 - current;
+}
+
+void WaterSim::uploadHeights(const std::vector<float>& heights)
+{
+    glBindTexture(GL_TEXTURE_2D, heightTex[0]);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, GL_RED, GL_FLOAT, heights.data());
+}
+
+void WaterSim::stepGPU()
+{
+    const float dx = gridExtent / size;
+    const float k = std::min(WaveSpeed * WaveSpeed * FixedTimestep * FixedTimestep / (dx * dx), 0.49f);
+    const float cellsPerUnit = size / gridExtent;
+
+    glm::vec4 packed[MAX_DISTURBANCES];
+    for (size_t i = 0; i < disturbances.size(); i++)
+    {
+        glm::vec2 centre = (disturbances[i].position - gridOrigin) * cellsPerUnit;
+        packed[i] = glm::vec4(centre.x, centre.y, std::max(disturbances[i].radius * cellsPerUnit, 1.0f), disturbances[i].strength);
+    }
+
+    glUseProgram(computeProgram);
+    glBindImageTexture(0, heightTex[current], 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32F);
+    glBindImageTexture(1, heightTex[1 - current], 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32F);
+    glBindImageTexture(2, boundaryTex, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R8);
+    glUniform1f(glGetUniformLocation(computeProgram, "courant"), k);
+    glUniform1f(glGetUniformLocation(computeProgram, "damping"), Damping);
+    glUniform1i(glGetUniformLocation(computeProgram, "size"), size);
+    glUniform1i(glGetUniformLocation(computeProgram, "disturbanceCount"), static_cast<int>(disturbances.size()));
+    if (!disturbances.empty())
+        glUniform4fv(glGetUniformLocation(computeProgram, "disturbances"), static_cast<GLsizei>(disturbances.size()), &packed[0].x);
+
+    // pass 0 splashes the disturbances into the current heights in place, pass 1 steps the wave equation
+    int groups = (size + 15) / 16;
+    if (!disturbances.empty())
+    {
+        glUniform1i(glGetUniformLocation(computeProgram, "pass"), 0);
+        glDispatchCompute(groups, groups, 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+    glUniform1i(glGetUniformLocation(computeProgram, "pass"), 1);
+    glDispatchCompute(groups, groups, 1);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    current = 1 - current;
+}
+
+// utility function for loading a compute shader program
+// -----------------------------------------------------
+unsigned int loadComputeProgram(const char* computePath)
+{
+    std::string code;
+    std::ifstream file(computePath);
+    if (!file)
+    {
+        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << computePath << std::endl;
+        return 0;
+    }
+    std::stringstream stream;
+    stream << file.rdbuf();
+    code = stream.str();
+    const char* source = code.c_str();
+
+    int success;
+    char infoLog[1024];
+    unsigned int shader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+        std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: COMPUTE (" << computePath << ")\n" << infoLog << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    unsigned int program = glCreateProgram();
+    glAttachShader(program, shader);
+    glLinkProgram(program);
+    glDeleteShader(shader);
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glGetProgramInfoLog(program, 1024, NULL, infoLog);
+        std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: COMPUTE (" << computePath << ")\n" << infoLog << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
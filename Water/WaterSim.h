@@ -0,0 +1,106 @@
+#ifndef WATER_SIM_H
+#define WATER_SIM_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader_m.h>
+#include <learnopengl/mesh.h>
+
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+// Which implementation advances the heightfield
+enum class WaterSimBackend { CPU, GPU };
+
+// A point disturbance queued for the next simulation step (world xz, radius, strength)
+struct WaterDisturbance
+{
+    glm::vec2 position;
+    float radius;
+    float strength;
+};
+
+// Damped wave equation over a heightfield that covers the water tiles.
+// The solver runs at a fixed timestep independent of the render frame rate;
+// update() accumulates frame time and takes as many fixed steps as fit.
+// ----------------------------------------------------------------------
+class WaterSim
+{
+public:
+    static const int MAX_DISTURBANCES = 16;
+    static const int TILE_SIZE = 64;    // cells per side of a cache block on the CPU path
+
+    float WaveSpeed = 1.5f;
+    float Damping = 0.996f;
+    float FixedTimestep = 1.0f / 120.0f;
+    int MaxStepsPerUpdate = 8;
+
+    // the grid is resolution x resolution cells covering [origin, origin + extent] on the xz plane;
+    // the CPU step splits its tiles over jobs, or runs them on the calling thread without one
+    WaterSim(int resolution, glm::vec2 origin, float extent, WaterSimBackend backend, JobSystem* jobs = nullptr);
+    ~WaterSim();
+
+    WaterSimBackend backend() const { return simBackend; }
+    int resolution() const { return size; }
+    glm::vec2 origin() const { return gridOrigin; }
+    float extent() const { return gridExtent; }
+    unsigned int threadCount() const;
+    // blend factor between the last two fixed steps, for rendering in between ticks
+    float alpha() const { return accumulator / FixedTimestep; }
+
+    // mark cells where solid geometry pierces the water plane as reflecting walls
+    void buildBoundaryFromMeshes(const std::vector<Mesh>& meshes, const glm::mat4& model, float waterHeight, float margin = 0.02f);
+    void clearBoundary();
+    void addDisturbance(glm::vec2 worldPosition, float radius, float strength);
+
+    // advance by frame time, returns the number of fixed steps taken
+    int update(float deltaTime);
+    // advance exactly one fixed step; on the CPU backend this makes no GL calls and may run on
+    // another thread as long as the heights are uploaded from the GL thread afterwards
+    void step();
+    void reset();
+
+    // texture holding the current heights (GL_R32F), kept up to date for both backends
+    unsigned int heightTexture() const;
+    // copy heights computed elsewhere (e.g. a simulation thread snapshot) into heightTexture()
+    void uploadHeights(const std::vector<float>& heights);
+    // CPU copy of the heights, only valid for the CPU backend
+    const std::vector<float>& heights() const { return cells[current]; }
+    // bilinear height at a world xz position from the CPU copy
+    float heightAt(glm::vec2 worldPosition) const;
+
+private:
+    void stepCPU();
+    void stepGPU();
+    void applyDisturbancesCPU();
+    void applyBoundary();
+    unsigned int createFieldTexture(GLenum internalFormat, GLenum format, GLenum type, const void* data);
+    void rasterizeTriangle(glm::vec2 a, glm::vec2 b, glm::vec2 c);
+
+    WaterSimBackend simBackend;
+    int size;
+    glm::vec2 gridOrigin;
+    float gridExtent;
+    float accumulator = 0.0f;
+
+    // cells[current] holds heights at t, cells[1 - current] at t - dt and receives t + dt
+    std::vector<float> cells[2];
+    std::vector<unsigned char> boundary;    // 1 = wall
+    std::vector<WaterDisturbance> disturbances;
+    int current = 0;
+    bool boundaryDirty = true;
+
+    JobSystem* jobs;
+
+    unsigned int heightTex[2] = { 0, 0 };
+    unsigned int boundaryTex = 0;
+    unsigned int computeProgram = 0;
+};
+
+// compile a compute shader from file into a program, returns 0 on failure
+unsigned int loadComputeProgram(const char* computePath);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef WORLD_SPACE_H
+#define WORLD_SPACE_H
+
+#include <glm/glm.hpp>
+
+// World space is double precision and lives on the CPU only. Everything handed to GL is in
+// render space: float, relative to a floating origin that follows the camera, so vertices near the
+// camera keep full precision whether the scene sits at the world origin or a thousand km from it.
+// -----------------------------------------------------------------------------------------------
+
+// the origin moves in steps of this many metres, so it stays put while the camera moves around
+const double REBASE_GRID = 64.0;
+
+inline glm::dvec3 renderOrigin(const glm::dvec3& camera)
+{
+    return glm::floor(camera / REBASE_GRID) * REBASE_GRID;
+}
+
+inline glm::vec3 toRenderSpace(const glm::dvec3& world, const glm::dvec3& origin)
+{
+    return glm::vec3(world - origin);
+}
+
+// subtract in double before the matrix is rounded to float
+inline glm::mat4 toRenderSpace(const glm::dmat4& world, const glm::dvec3& origin)
+{
+    glm::dmat4 relative = world;
+    relative[3] -= glm::dvec4(origin, 0.0);
+    return glm::mat4(relative);
+}
+
+#endif
@@ -1,4 +1,7 @@
 #version 330 core
+#ifndef OVERDRAW
+#define OVERDRAW 0		// every fragment writes 1 for OverdrawView to add up
+#endif
 out vec4 FragColor;
 
 in vec2 TexCoords;
@@ -7,5 +10,9 @@ uniform sampler2D texture_diffuse1;
 
 void main()
 {    
+#if OVERDRAW
+    FragColor = vec4(1.0);
+    return;
+#endif
     FragColor = texture(texture_diffuse1, TexCoords);
 }
\ No newline at end of file
@@ -1,19 +1,33 @@
 #version 330 core
+
+// defined 1 by ShaderVariants when the plane passes clip with an oblique near plane instead
+#ifndef OBLIQUE_CLIP
+#define OBLIQUE_CLIP 0
+#endif
+
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
 out vec2 TexCoords;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform vec4 plane;
+layout (std140) uniform PassBlock
+{
+    mat4 view;
+    mat4 projection;
+    vec4 plane;
+};
+layout (std140) uniform DrawBlock
+{
+    mat4 model;
+};
 
 void main()
 {
     vec4 worldPosition = model * vec4(aPos, 1.0);
+#if !OBLIQUE_CLIP
     gl_ClipDistance[0] = dot(worldPosition, plane);
+#endif
     TexCoords = aTexCoords;    
     gl_Position = projection * view * model * vec4(aPos, 1.0);
 }
\ No newline at end of file
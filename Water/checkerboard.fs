@@ -0,0 +1,76 @@
+#version 330 core
+
+out vec4 FragColor;
+
+// mask: discard the pixels the refraction skips this render, so only the shaded ones get stencil;
+// otherwise fill in the skipped ones
+uniform bool mask;
+uniform int parity;
+
+uniform sampler2D current;			// this render, every other pixel shaded
+uniform sampler2D currentDepth;
+uniform sampler2D previous;			// the last render, already filled in
+uniform bool previousValid;
+uniform mat4 reprojection;			// this render's clip space to the last one's
+uniform vec2 jitter;				// texture-space offsets of both renders
+uniform vec2 previousJitter;
+
+bool shaded(ivec2 texel)
+{
+	return ((texel.x + texel.y + parity) & 1) == 0;
+}
+
+// a neighbour of a skipped pixel, always shaded: at the border the one opposite stands in
+ivec2 neighbour(ivec2 texel, ivec2 offset, ivec2 size)
+{
+	ivec2 p = texel + offset;
+	return any(lessThan(p, ivec2(0))) || any(greaterThanEqual(p, size)) ? texel - offset : p;
+}
+
+void main()
+{
+	ivec2 texel = ivec2(gl_FragCoord.xy);
+	if (mask)
+	{
+		if (!shaded(texel))
+			discard;
+		FragColor = vec4(0.0);
+		return;
+	}
+	if (shaded(texel))
+	{
+		FragColor = texelFetch(current, texel, 0);
+		return;
+	}
+
+	ivec2 size = textureSize(current, 0);
+	ivec2 left = neighbour(texel, ivec2(-1, 0), size), right = neighbour(texel, ivec2(1, 0), size);
+	ivec2 down = neighbour(texel, ivec2(0, -1), size), up = neighbour(texel, ivec2(0, 1), size);
+	vec4 cl = texelFetch(current, left, 0), cr = texelFetch(current, right, 0);
+	vec4 cd = texelFetch(current, down, 0), cu = texelFetch(current, up, 0);
+	float dl = texelFetch(currentDepth, left, 0).r, dr = texelFetch(currentDepth, right, 0).r;
+	float dd = texelFetch(currentDepth, down, 0).r, du = texelFetch(currentDepth, up, 0).r;
+
+	// interpolate along whichever axis the depth changes least, so edges stay sharp
+	bool horizontal = abs(dl - dr) <= abs(dd - du);
+	vec4 spatial = horizontal ? 0.5 * (cl + cr) : 0.5 * (cd + cu);
+	float depth = horizontal ? 0.5 * (dl + dr) : 0.5 * (dd + du);
+	if (!previousValid)
+	{
+		FragColor = spatial;
+		return;
+	}
+
+	// the last render shaded this pixel, if the surface here was on screen then
+	vec2 uv = (vec2(texel) + 0.5) / vec2(size) - jitter;
+	vec4 clip = reprojection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+	vec2 previousUV = clip.xy / clip.w * 0.5 + 0.5 + previousJitter;
+	if (clip.w <= 0.0 || any(lessThan(previousUV, vec2(0.0))) || any(greaterThan(previousUV, vec2(1.0))))
+	{
+		FragColor = spatial;
+		return;
+	}
+	vec4 lo = min(min(cl, cr), min(cd, cu));
+	vec4 hi = max(max(cl, cr), max(cd, cu));
+	FragColor = clamp(texture(previous, previousUV), lo, hi);
+}
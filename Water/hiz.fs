@@ -0,0 +1,37 @@
+#version 330 core
+
+layout (location = 0) out float Depth;
+
+// the depth buffer for level 0, otherwise the Hi-Z level above, restricted to that one level
+uniform sampler2D source;
+uniform bool reduce;
+
+float fetch(ivec2 texel, ivec2 size)
+{
+	return texelFetch(source, min(texel, size - 1), 0).r;
+}
+
+void main()
+{
+	ivec2 texel = ivec2(gl_FragCoord.xy);
+	ivec2 size = textureSize(source, 0);
+	if (!reduce)
+	{
+		Depth = fetch(texel, size);
+		return;
+	}
+
+	// nearest of the four texels below; on odd sizes the last cell also takes the leftover row and column
+	ivec2 base = texel * 2;
+	float nearest = min(min(fetch(base, size), fetch(base + ivec2(1, 0), size)),
+		min(fetch(base + ivec2(0, 1), size), fetch(base + ivec2(1, 1), size)));
+	bool oddX = (size.x & 1) != 0 && base.x + 3 == size.x;
+	bool oddY = (size.y & 1) != 0 && base.y + 3 == size.y;
+	if (oddX)
+		nearest = min(nearest, min(fetch(base + ivec2(2, 0), size), fetch(base + ivec2(2, 1), size)));
+	if (oddY)
+		nearest = min(nearest, min(fetch(base + ivec2(0, 2), size), fetch(base + ivec2(1, 2), size)));
+	if (oddX && oddY)
+		nearest = min(nearest, fetch(base + ivec2(2, 2), size));
+	Depth = nearest;
+}
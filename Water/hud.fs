@@ -0,0 +1,22 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec2 cell;
+flat in vec4 color;
+
+// 3 x 5 bitmaps, top row in the high bits: 0-9 and the point
+const int GLYPHS[11] = int[11](31599, 11415, 29671, 29647, 23497, 31183, 31215, 29257, 31727, 31695, 2);
+
+void main()
+{
+	// -2 is the backdrop, -1 a solid bar or line, anything else a glyph
+	int glyph = int(color.a);
+	if (glyph >= 0)
+	{
+		ivec2 bit = min(ivec2(cell * vec2(3.0, 5.0)), ivec2(2, 4));
+		if (((GLYPHS[glyph] >> (bit.y * 3 + 2 - bit.x)) & 1) == 0)
+			discard;
+	}
+	FragColor = vec4(color.rgb, glyph == -2 ? 0.5 : 0.9);
+}
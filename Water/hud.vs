@@ -0,0 +1,14 @@
+#version 330 core
+layout (location = 1) in vec2 aTexCoords;	// the screen quad's corners, 0 to 1
+layout (location = 2) in vec4 aRect;		// per instance: corner and size in clip space
+layout (location = 3) in vec4 aColor;		// rgb, glyph
+
+out vec2 cell;
+flat out vec4 color;
+
+void main()
+{
+	cell = aTexCoords;
+	color = aColor;
+	gl_Position = vec4(aRect.xy + aTexCoords * aRect.zw, 0.0, 1.0);
+}
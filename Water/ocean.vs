@@ -0,0 +1,28 @@
+#version 330 core
+layout (location = 0) in vec2 aGrid;
+
+out vec4 clipSpace;
+out vec3 worldPosition;
+
+layout (std140) uniform PassBlock
+{
+	mat4 view;
+	mat4 projection;
+	vec4 plane;
+	vec4 camera;	// render-space eye, w seconds of the water's scrolling
+};
+layout (std140) uniform OceanBlock
+{
+	vec4 chunks[256];	// min corner x, z, size, LOD level
+};
+
+uniform float oceanHeight;
+
+void main()
+{
+	vec4 chunk = chunks[gl_InstanceID];
+	vec2 xz = chunk.xy + aGrid * chunk.z;
+	worldPosition = vec3(xz.x, oceanHeight, xz.y);
+	clipSpace = projection * view * vec4(worldPosition, 1.0f);
+	gl_Position = clipSpace;
+}
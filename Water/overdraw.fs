@@ -0,0 +1,56 @@
+#version 330 core
+
+out vec4 FragColor;
+
+uniform sampler2D reflectionCounts;
+uniform sampler2D refractionCounts;
+uniform sampler2D mainCounts;
+uniform vec2 reflectionScale;	// the part of each target its pass drew into, 0 if it did not run
+uniform vec2 refractionScale;
+uniform vec2 mainScale;
+uniform vec2 targetSize;
+uniform float maxCount;
+
+const float MARGIN = 8.0;
+const float BORDER = 2.0;
+
+// black where nothing was drawn, then blue, green, yellow and red at maxCount; logarithmic, so one,
+// two and four fragments stay apart
+vec3 heat(float count)
+{
+	if (count < 0.5)
+		return vec3(0.0);
+	float t = clamp(log2(count) / log2(maxCount), 0.0, 1.0) * 3.0;
+	vec3 color = mix(vec3(0.0, 0.2, 1.0), vec3(0.0, 1.0, 0.0), clamp(t, 0.0, 1.0));
+	color = mix(color, vec3(1.0, 1.0, 0.0), clamp(t - 1.0, 0.0, 1.0));
+	return mix(color, vec3(1.0, 0.0, 0.0), clamp(t - 2.0, 0.0, 1.0));
+}
+
+float countAt(sampler2D counts, vec2 scale, vec2 uv)
+{
+	return scale.x > 0.0 ? texture(counts, uv * scale).r : 0.0;
+}
+
+void main()
+{
+	// the plane passes in quarter-size insets, reflection top left and refraction top right
+	vec2 inset = targetSize * 0.25;
+	vec2 corners[2] = vec2[2](vec2(MARGIN, targetSize.y - MARGIN - inset.y),
+							  vec2(targetSize.x - MARGIN - inset.x, targetSize.y - MARGIN - inset.y));
+	for (int i = 0; i < 2; i++)
+	{
+		vec2 local = gl_FragCoord.xy - corners[i];
+		if (any(lessThan(local, vec2(-BORDER))) || any(greaterThan(local, inset + BORDER)))
+			continue;
+		if (any(lessThan(local, vec2(0.0))) || any(greaterThan(local, inset)))
+		{
+			FragColor = vec4(1.0);
+			return;
+		}
+		float count = i == 0 ? countAt(reflectionCounts, reflectionScale, local / inset)
+							 : countAt(refractionCounts, refractionScale, local / inset);
+		FragColor = vec4(heat(count), 1.0);
+		return;
+	}
+	FragColor = vec4(heat(countAt(mainCounts, mainScale, gl_FragCoord.xy / targetSize)), 1.0);
+}
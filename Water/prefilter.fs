@@ -0,0 +1,72 @@
+#version 330 core
+
+in vec3 direction;
+out vec4 FragColor;
+
+uniform samplerCube source;		// mipmapped
+uniform float sourceSize;		// level 0 face size
+uniform float roughness;
+uniform int sampleCount;
+
+const float PI = 3.14159265359;
+
+float distributionGGX(float NdotH, float alpha)
+{
+	float a2 = alpha * alpha;
+	float d = NdotH * NdotH * (a2 - 1.0) + 1.0;
+	return a2 / (PI * d * d);
+}
+
+// low-discrepancy points: i / n against the bits of i mirrored
+vec2 hammersley(uint i, uint n)
+{
+	uint bits = i;
+	bits = (bits << 16u) | (bits >> 16u);
+	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+	bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+	bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+	bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+	return vec2(float(i) / float(n), float(bits) * 2.3283064365386963e-10);
+}
+
+// a half vector around N distributed like the GGX lobe
+vec3 importanceSampleGGX(vec2 xi, vec3 N, float alpha)
+{
+	float phi = 2.0 * PI * xi.x;
+	float cosTheta = sqrt((1.0 - xi.y) / (1.0 + (alpha * alpha - 1.0) * xi.y));
+	float sinTheta = sqrt(1.0 - cosTheta * cosTheta);
+	vec3 H = vec3(cos(phi) * sinTheta, sin(phi) * sinTheta, cosTheta);
+
+	vec3 up = abs(N.z) < 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0);
+	vec3 tangent = normalize(cross(up, N));
+	vec3 bitangent = cross(N, tangent);
+	return normalize(tangent * H.x + bitangent * H.y + N * H.z);
+}
+
+void main()
+{
+	// view along the normal, as split-sum prefiltering assumes
+	vec3 N = normalize(direction);
+	float alpha = roughness * roughness;
+	float texelSolidAngle = 4.0 * PI / (6.0 * sourceSize * sourceSize);
+
+	vec3 color = vec3(0.0);
+	float weight = 0.0;
+	uint count = uint(sampleCount);
+	for (uint i = 0u; i < count; i++)
+	{
+		vec3 H = importanceSampleGGX(hammersley(i, count), N, alpha);
+		vec3 L = normalize(2.0 * dot(N, H) * H - N);
+		float NdotL = dot(N, L);
+		if (NdotL <= 0.0)
+			continue;
+		// read the source at the level whose texels match the solid angle this sample stands for
+		float NdotH = max(dot(N, H), 0.0);
+		float pdf = distributionGGX(NdotH, alpha) * 0.25 + 0.0001;
+		float sampleSolidAngle = 1.0 / (float(sampleCount) * pdf + 0.0001);
+		float level = roughness == 0.0 ? 0.0 : 0.5 * log2(sampleSolidAngle / texelSolidAngle);
+		color += textureLod(source, L, level).rgb * NdotL;
+		weight += NdotL;
+	}
+	FragColor = vec4(color / weight, 1.0);
+}
@@ -1,4 +1,7 @@
 #version 330 core
+#ifndef OVERDRAW
+#define OVERDRAW 0		// every fragment writes 1 for OverdrawView to add up
+#endif
 out vec4 FragColor;
 
 in vec3 TexCoords;
@@ -7,5 +10,9 @@ uniform samplerCube skybox;
 
 void main()
 {    
+#if OVERDRAW
+    FragColor = vec4(1.0);
+    return;
+#endif
     FragColor = texture(skybox, TexCoords);
 }
\ No newline at end of file
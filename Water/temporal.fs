@@ -0,0 +1,51 @@
+#version 330 core
+
+out vec4 FragColor;
+
+// this frame's jittered render at reduced size, and the full-size history it is folded into
+uniform sampler2D current;
+uniform sampler2D currentDepth;
+uniform sampler2D history;
+uniform bool historyValid;
+
+uniform mat4 reprojection;	// this frame's clip space to the history's
+uniform vec2 jitter;		// texture-space offset of this frame's render
+uniform float historyWeight;
+
+void main()
+{
+	vec2 uv = gl_FragCoord.xy / vec2(textureSize(history, 0));
+	vec2 sampleUV = uv + jitter;
+	vec4 color = texture(current, sampleUV);
+	if (!historyValid)
+	{
+		FragColor = color;
+		return;
+	}
+
+	// the range the render's own neighbourhood allows; history outside it is stale
+	vec2 texel = 1.0 / vec2(textureSize(current, 0));
+	vec4 lo = color;
+	vec4 hi = color;
+	for (int y = -1; y <= 1; y++)
+	{
+		for (int x = -1; x <= 1; x++)
+		{
+			vec4 neighbour = texture(current, sampleUV + vec2(x, y) * texel);
+			lo = min(lo, neighbour);
+			hi = max(hi, neighbour);
+		}
+	}
+
+	// where the surface seen here was in the history
+	float depth = texture(currentDepth, sampleUV).r;
+	vec4 previous = reprojection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+	vec2 previousUV = previous.xy / previous.w * 0.5 + 0.5;
+	if (previous.w <= 0.0 || any(lessThan(previousUV, vec2(0.0))) || any(greaterThan(previousUV, vec2(1.0))))
+	{
+		FragColor = color;
+		return;
+	}
+	vec4 accumulated = clamp(texture(history, previousUV), lo, hi);
+	FragColor = mix(color, accumulated, historyWeight);
+}
@@ -0,0 +1,23 @@
+#version 330 core
+#ifndef OVERDRAW
+#define OVERDRAW 0		// every fragment writes 1 for OverdrawView to add up
+#endif
+out vec4 FragColor;
+
+in vec3 TexCoords;
+in vec3 Normal;
+
+uniform sampler2DArray tiles;
+
+const vec3 lightDirection = normalize(vec3(0.4, 1.0, 0.3));
+
+void main()
+{
+#if OVERDRAW
+    FragColor = vec4(1.0);
+    return;
+#endif
+    vec3 color = texture(tiles, TexCoords).rgb;
+    float diffuse = max(dot(normalize(Normal), lightDirection), 0.0);
+    FragColor = vec4(color * (0.35 + 0.65 * diffuse), 1.0);
+}
@@ -0,0 +1,60 @@
+#version 330 core
+layout (location = 0) in vec2 aGrid;
+
+out vec3 TexCoords;
+out vec3 Normal;
+
+layout (std140) uniform PassBlock
+{
+    mat4 view;
+    mat4 projection;
+    vec4 plane;
+};
+layout (std140) uniform TerrainBlock
+{
+    vec4 area;      // min corner x, z, size, LOD level
+    vec4 tile;      // layer, uv offset, uv scale
+    vec4 morph;     // morph start and end distance
+};
+
+uniform sampler2DArray tiles;
+uniform vec3 lodCenter;
+uniform float terrainBase;
+uniform float heightScale;
+
+const float GRID = 32.0;
+const float TILE_TEXELS = 65.0;
+
+// texel centres of the tile layer: the grid's corners land on the first and last texel
+vec3 tileCoords(vec2 grid)
+{
+    vec2 uv = tile.yz + grid * tile.w;
+    return vec3((uv * (TILE_TEXELS - 1.0) + 0.5) / TILE_TEXELS, tile.x);
+}
+
+float heightAt(vec2 grid)
+{
+    return terrainBase + texture(tiles, tileCoords(grid)).a * heightScale;
+}
+
+void main()
+{
+    // CDLOD morph: odd vertices slide onto the coarser grid as the distance reaches the range's end
+    vec2 grid = aGrid;
+    vec2 xz = area.xy + grid * area.z;
+    float distance = length(vec3(xz.x, heightAt(grid), xz.y) - lodCenter);
+    float k = clamp((distance - morph.x) / (morph.y - morph.x), 0.0, 1.0);
+    grid -= fract(grid * GRID * 0.5) * 2.0 / GRID * k;
+    xz = area.xy + grid * area.z;
+
+    vec3 worldPosition = vec3(xz.x, heightAt(grid), xz.y);
+    // slope from the neighbouring texels of the sampled layer, texel in grid units
+    float texel = 1.0 / ((TILE_TEXELS - 1.0) * tile.w);
+    float dx = heightAt(grid + vec2(texel, 0.0)) - heightAt(grid - vec2(texel, 0.0));
+    float dz = heightAt(grid + vec2(0.0, texel)) - heightAt(grid - vec2(0.0, texel));
+    Normal = normalize(vec3(-dx, 2.0 * texel * area.z, -dz));
+
+    TexCoords = tileCoords(grid);
+    gl_ClipDistance[0] = dot(vec4(worldPosition, 1.0), plane);
+    gl_Position = projection * view * vec4(worldPosition, 1.0);
+}
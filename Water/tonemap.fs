@@ -0,0 +1,21 @@
+#version 330 core
+
+out vec4 FragColor;
+
+uniform sampler2D scene;	// HDR, covering the target
+uniform vec2 targetSize;
+uniform float exposure;
+uniform float shoulder;		// below this nothing changes
+
+// identity up to the shoulder, then x / (1 + x) over what is left, which meets it with slope 1
+vec3 compress(vec3 color)
+{
+	vec3 over = max(color - shoulder, 0.0) / (1.0 - shoulder);
+	return min(color, vec3(shoulder)) + (1.0 - shoulder) * over / (1.0 + over);
+}
+
+void main()
+{
+	vec3 color = texture(scene, gl_FragCoord.xy / targetSize).rgb * exposure;
+	FragColor = vec4(compress(color), 1.0);
+}
@@ -1,20 +1,268 @@
 #version 330 core
 
+// features, each defined 0 or 1 by ShaderVariants after the version line; without it the quality
+// features are on and OVERDRAW is off
+#ifndef DISTORTION
+#define DISTORTION 1		// the simulated ripples and the detail bend the lookups
+#endif
+#ifndef FRESNEL
+#define FRESNEL 1			// Schlick's term, otherwise an even mix of reflection and refraction
+#endif
+#ifndef SOFT_EDGES
+#define SOFT_EDGES 1		// absorption and the shore fade from the water's thickness
+#endif
+#ifndef NORMAL_MAP
+#define NORMAL_MAP 1		// the scrolling detail layers
+#endif
+#ifndef OVERDRAW
+#define OVERDRAW 0		// every fragment writes 1 for OverdrawView to add up
+#endif
+
 in vec4 clipSpace;
+in vec3 worldPosition;
 out vec4 FragColor;
 
+layout (std140) uniform PassBlock
+{
+	mat4 view;
+	mat4 projection;
+	vec4 plane;
+	vec4 camera;	// render-space eye, w seconds of the water's scrolling
+};
+
 uniform sampler2D reflectionTexture;
+uniform sampler2D reflectionDepth;	// 1 where the reflection pass drew nothing
 uniform sampler2D refractionTexture;
+uniform sampler2D refractionDepth;	// what the refraction pass saw under the water
+uniform sampler2D heightField;
+
+uniform vec2 simOrigin;
+uniform float simExtent;
+uniform float rippleStrength;
+
+// the sky, prefiltered for rising roughness down its mips; the reflection pass leaves it out
+uniform samplerCube environment;
+uniform int environmentLevels;
+uniform float roughness;		// of calm water up close, ripples and distance add to it
+
+// screen-space reflections: 0 planar, 1 ray-marched with the sky behind misses, 2 ray-marched
+// over the low-resolution planar image; both take refraction from the opaque main pass
+uniform int reflectionMode;
+uniform sampler2D sceneColor;
+uniform sampler2D hiZ;			// nearest depth per cell, level 0 is the depth buffer
+uniform int hiZLevels;
+
+// scrolling surface detail, see WaterNormals: a layer's texel is the slope of small waves, both the
+// offset the lookups are bent by and the normal
+uniform sampler2DArray waterNormals;
+uniform vec2 detailOrigin;		// the render-space origin within a tile, keeps the waves on the world
+uniform float detailTile;		// metres layer 0 repeats over
+uniform float detailStrength;	// slope of the normals
+uniform float dudvStrength;		// texture-space offset of the bent lookups
+
+const float DETAIL_PERIOD = 64.0;	// seconds camera.w wraps over, the layers scroll whole tiles in it
+const float WATER_F0 = 0.02;		// reflectance of water seen head-on
+
+// thickness of the water column between the surface and the floor behind it: light is absorbed
+// along it towards deepColor, and the shore fades in over shoreSoftness metres of it
+uniform vec3 absorption;		// per metre
+uniform vec3 deepColor;
+uniform float shoreSoftness;
+
+const int MAX_STEPS = 64;
+const float THICKNESS = 0.5;	// metres a ray may pass behind a surface and still count as hitting it
+
+// render space to texture coordinates and window depth
+vec3 toScreen(vec3 position)
+{
+	vec4 clip = projection * view * vec4(position, 1.0);
+	return clip.xyz / clip.w * 0.5 + 0.5;
+}
+
+// window depth to distance along the view axis
+float linearDepth(float depth)
+{
+	return projection[3][2] / (depth * 2.0 - 1.0 + projection[2][2]);
+}
+
+// Walks the ray through the depth pyramid: while the ray stays in front of the nearest surface
+// of a cell it skips to the cell's edge and climbs a level, otherwise it descends, and reaching
+// below level 0 is a hit. Returns the hit's texture coordinates and a confidence, 0 on a miss.
+vec3 traceScreenSpace(vec3 origin, vec3 direction)
+{
+	// keep the far end in front of the near plane so it projects
+	vec3 viewOrigin = (view * vec4(origin, 1.0)).xyz;
+	vec3 viewDirection = mat3(view) * direction;
+	float rayLength = 100.0;
+	if (viewDirection.z > 0.0)
+		rayLength = min(rayLength, 0.99 * (-0.1 - viewOrigin.z) / viewDirection.z);
+
+	vec3 start = toScreen(origin);
+	vec3 delta = toScreen(origin + direction * rayLength) - start;
+	if (dot(delta.xy, delta.xy) < 1e-12)
+		return vec3(0.0);
+	delta.xy = vec2(abs(delta.x) < 1e-7 ? 1e-7 : delta.x, abs(delta.y) < 1e-7 ? 1e-7 : delta.y);
+
+	// where the ray leaves the screen
+	vec2 exits = (step(0.0, delta.xy) - start.xy) / delta.xy;
+	float tMax = min(1.0, min(exits.x, exits.y));
+
+	vec2 size = vec2(textureSize(hiZ, 0));
+	vec2 forward = step(0.0, delta.xy);
+	vec2 nudge = sign(delta.xy) * 0.05 / size;
+	float t = 1.0 / max(abs(delta.x) * size.x, abs(delta.y) * size.y);	// one pixel off the surface
+	int level = 0;
+	for (int i = 0; i < MAX_STEPS && level >= 0; i++)
+	{
+		if (t > tMax)
+			return vec3(0.0);
+		vec3 position = start + delta * t;
+		vec2 cells = vec2(textureSize(hiZ, level));
+		vec2 cell = floor(position.xy * cells);
+		float nearest = texelFetch(hiZ, ivec2(cell), level).r;
+
+		vec2 edges = ((cell + forward) / cells + nudge - start.xy) / delta.xy;
+		float tCell = min(edges.x, edges.y);
+		if (position.z < nearest)
+		{
+			float tDepth = delta.z > 0.0 ? (nearest - start.z) / delta.z : 1e30;
+			if (tDepth >= tCell)
+			{
+				t = tCell;
+				level = min(level + 1, hiZLevels - 1);
+			}
+			else
+			{
+				t = max(t, tDepth);
+				level--;
+			}
+		}
+		else
+			level--;
+	}
+	if (level >= 0)
+		return vec3(0.0);
+
+	// a ray that passed behind something thin is not a hit on it
+	vec3 hit = start + delta * t;
+	float surface = linearDepth(texelFetch(hiZ, ivec2(hit.xy * size), 0).r);
+	if (linearDepth(hit.z) - surface > THICKNESS)
+		return vec3(0.0);
+	// nothing past the border to blend with, fade out towards it
+	vec2 border = min(hit.xy, 1.0 - hit.xy);
+	return vec3(hit.xy, clamp(min(border.x, border.y) * 10.0, 0.0, 1.0));
+}
+
+// window depth of the floor behind the water at uv; a checkerboarded refraction leaves every
+// other pixel cleared, so the nearer of two neighbours is taken
+float floorDepth(vec2 uv)
+{
+	if (reflectionMode != 0)
+		return texelFetch(hiZ, ivec2(uv * vec2(textureSize(hiZ, 0))), 0).r;
+	vec2 texel = vec2(1.0 / float(textureSize(refractionDepth, 0).x), 0.0);
+	return min(texture(refractionDepth, uv).r, texture(refractionDepth, uv + texel).r);
+}
+
+// both layers drifting in different directions, one fetch each
+vec2 detailSlope()
+{
+	vec2 uv = (worldPosition.xz + detailOrigin) / detailTile;
+	float time = camera.w / DETAIL_PERIOD;
+	vec2 broad = texture(waterNormals, vec3(uv + vec2(2.0, 1.0) * time, 0.0)).rg;
+	vec2 fine = texture(waterNormals, vec3(uv * 4.0 + vec2(-3.0, 5.0) * time, 1.0)).rg;
+	return broad * 0.6 + fine * 0.4;
+}
+
+// far water packs more waves into a pixel, so it reflects a blurrier sky
+vec4 skyReflection(vec3 direction, float distance, vec2 ripple)
+{
+	float rough = clamp(roughness + length(ripple) * 8.0 + distance * 0.005, 0.0, 1.0);
+	return textureLod(environment, direction, rough * float(environmentLevels - 1));
+}
+
+// the planar image where the reflection pass drew something, the sky everywhere else
+vec4 planarReflection(vec2 uv, vec4 sky)
+{
+	float depth = texture(reflectionDepth, uv).r;
+	return mix(sky, texture(reflectionTexture, uv), clamp((1.0 - depth) * 10000.0, 0.0, 1.0));
+}
 
 void main()
 {
+#if OVERDRAW
+	FragColor = vec4(1.0);
+	return;
+#endif
 	vec2 ndc = (clipSpace.xy/clipSpace.w)/2.0f + 0.5f;
 	vec2 refractTexCoords = vec2(ndc.x, ndc.y);
 	vec2 reflectTexCoords = vec2(ndc.x, 1.0-ndc.y);
 
-	vec4 reflectColor = texture(reflectionTexture, reflectTexCoords);
-	vec4 refractColor = texture(refractionTexture, refractTexCoords);
+	// slope of the simulated heightfield bends both lookups
+	vec2 ripple = vec2(0.0);
+#if DISTORTION
+	vec2 simUV = (worldPosition.xz - simOrigin) / simExtent;
+	float texel = 1.0 / float(textureSize(heightField, 0).x);
+	float dhdx = texture(heightField, simUV + vec2(texel, 0.0)).r - texture(heightField, simUV - vec2(texel, 0.0)).r;
+	float dhdz = texture(heightField, simUV + vec2(0.0, texel)).r - texture(heightField, simUV - vec2(0.0, texel)).r;
+	ripple = vec2(dhdx, dhdz) * rippleStrength;
+#endif
+	vec2 detail = vec2(0.0);
+#if NORMAL_MAP
+	detail = detailSlope();
+#endif
+
+	// metres of water behind this pixel; ripples flatten out where it thins towards the shore
+	float thickness = 1e4;
+#if SOFT_EDGES
+	thickness = max(linearDepth(floorDepth(ndc)) - linearDepth(gl_FragCoord.z), 0.0);
+#endif
+	float edge = clamp(thickness / shoreSoftness, 0.0, 1.0);
+	ripple *= edge;
+	detail *= edge;
+	vec2 distortion = vec2(0.0);
+#if DISTORTION
+	distortion = ripple + detail * dudvStrength;
+	refractTexCoords = clamp(refractTexCoords + distortion, 0.001, 0.999);
+	reflectTexCoords = clamp(reflectTexCoords + distortion, 0.001, 0.999);
+#endif
+
+	vec2 slope = ripple + detail * detailStrength;
+	vec3 normal = normalize(vec3(-slope.x, 1.0, -slope.y));
+	vec3 toSurface = worldPosition - camera.xyz;
+	vec3 reflected = reflect(normalize(toSurface), normal);
+	vec4 sky = skyReflection(reflected, length(toSurface), distortion);
+
+	vec4 reflectColor;
+	vec4 refractColor;
+	if (reflectionMode == 0)
+	{
+		reflectColor = planarReflection(reflectTexCoords, sky);
+		refractColor = texture(refractionTexture, refractTexCoords);
+	}
+	else
+	{
+		vec4 fallback = reflectionMode == 2 ? planarReflection(reflectTexCoords, sky) : sky;
+		vec3 hit = traceScreenSpace(worldPosition, reflected);
+		reflectColor = mix(fallback, texture(sceneColor, hit.xy), hit.z);
+
+		// a bent lookup landing on something in front of the water would pull it into the water
+		ivec2 bent = ivec2(refractTexCoords * vec2(textureSize(hiZ, 0)));
+		if (texelFetch(hiZ, bent, 0).r < gl_FragCoord.z)
+			refractTexCoords = ndc;
+		refractColor = texture(sceneColor, refractTexCoords);
+	}
+
+#if SOFT_EDGES
+	refractColor.rgb = mix(deepColor, refractColor.rgb, exp(-absorption * thickness));
+#endif
+
+	// Schlick's Fresnel: water mostly transmits looking down into it and mostly reflects at grazing angles
+	float reflectance = 0.5;
+#if FRESNEL
+	reflectance = WATER_F0 + (1.0 - WATER_F0) * pow(1.0 - max(dot(normal, -normalize(toSurface)), 0.0), 5.0);
+#endif
 
-	FragColor = mix(reflectColor, refractColor, 0.5);
+	// at the waterline the surface is the floor seen through nothing
+	FragColor = mix(refractColor, mix(refractColor, reflectColor, reflectance), edge);
 	//FragColor = refractColor;
-}
\ No newline at end of file
+}
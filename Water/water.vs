@@ -2,13 +2,23 @@
 layout (location = 0) in vec3 aPos;
 
 out vec4 clipSpace;
+out vec3 worldPosition;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140) uniform PassBlock
+{
+	mat4 view;
+	mat4 projection;
+	vec4 plane;
+	vec4 camera;	// render-space eye, w seconds of the water's scrolling
+};
+layout (std140) uniform DrawBlock
+{
+	mat4 model;
+};
 
 void main()
 {
-	clipSpace = projection * view * model * vec4(aPos, 1.0f);
+	worldPosition = vec3(model * vec4(aPos, 1.0f));
+	clipSpace = projection * view * vec4(worldPosition, 1.0f);
 	gl_Position = clipSpace;
-}
\ No newline at end of file
+}
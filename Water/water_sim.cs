@@ -0,0 +1,48 @@
+#version 430 core
+layout (local_size_x = 16, local_size_y = 16) in;
+
+layout (r32f, binding = 0) uniform image2D current;   // heights at t
+layout (r32f, binding = 1) uniform image2D previous;  // heights at t - dt, receives t + dt
+layout (r8, binding = 2) uniform readonly image2D boundary;
+
+uniform int pass;
+uniform int size;
+uniform float courant;
+uniform float damping;
+uniform int disturbanceCount;
+uniform vec4 disturbances[16]; // cell x, cell y, radius in cells, strength
+
+float height(ivec2 p)
+{
+    // outside the grid behaves like a wall
+    if (any(lessThan(p, ivec2(0))) || any(greaterThanEqual(p, ivec2(size))))
+        return 0.0;
+    return imageLoad(current, p).r;
+}
+
+void main()
+{
+    ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+    if (p.x >= size || p.y >= size)
+        return;
+    bool wall = imageLoad(boundary, p).r > 0.5;
+
+    if (pass == 0)
+    {
+        float h = imageLoad(current, p).r;
+        for (int i = 0; i < disturbanceCount; i++)
+        {
+            vec2 d = (vec2(p) + 0.5 - disturbances[i].xy) / disturbances[i].z;
+            float r2 = dot(d, d);
+            if (r2 < 1.0)
+                h += disturbances[i].w * (1.0 - r2) * (1.0 - r2);
+        }
+        imageStore(current, p, vec4(wall ? 0.0 : h));
+        return;
+    }
+
+    float c = height(p);
+    float laplacian = height(p + ivec2(-1, 0)) + height(p + ivec2(1, 0)) + height(p + ivec2(0, -1)) + height(p + ivec2(0, 1)) - 4.0 * c;
+    float next = (2.0 * c - imageLoad(previous, p).r + courant * laplacian) * damping;
+    imageStore(previous, p, vec4(wall ? 0.0 : next));
+}